@@ -37,6 +37,7 @@ public:
 		current_(nullptr),
 		p_(nullptr),
 		end_(nullptr),
+		capacity_(0),
 		nextSize_(chunkSize),
 		intialSizeAndPolicy_((chunkSize << 8) | (uint8_t)growth)
 	{
@@ -80,8 +81,46 @@ public:
 		current_ = nullptr;
 		p_ = nullptr;
 		end_ = nullptr;
+		capacity_ = 0;
 	}
 
+	/**
+	 * Discards all allocations, but keeps the most recently allocated
+	 * chunk (which is typically the largest) so its memory can be
+	 * reused. If that chunk is larger than `maxRetained` bytes, the
+	 * Arena is cleared instead.
+	 */
+	void reset(size_t maxRetained = SIZE_MAX)
+	{
+		if (!current_) return;
+		uint8_t* start = reinterpret_cast<uint8_t*>(current_) + sizeof(Chunk);
+		size_t size = end_ - start;
+		if (size > maxRetained)
+		{
+			clear();
+			return;
+		}
+		Chunk* chunk = current_->next;
+		while (chunk)
+		{
+			Chunk* next = chunk->next;
+			delete[] reinterpret_cast<uint8_t*>(chunk);
+			chunk = next;
+		}
+		current_->next = nullptr;
+		p_ = start;
+		capacity_ = size;
+	}
+
+	/// The total size of the chunks held by this Arena
+	uint64_t capacity() const { return capacity_; }
+
+	/// The number of bytes allocated since the Arena was last reset
+	/// or cleared (including alignment padding, and the unused ends
+	/// of chunks that have been filled). Unlike capacity(), this
+	/// does not count the free space of a chunk retained by reset().
+	uint64_t used() const { return capacity_ - (end_ - p_); }
+
 	uint8_t* alloc(size_t size, int align)
 	{
 		p_ += (align - (reinterpret_cast<uintptr_t>(p_) & (align - 1))) & (align - 1);
@@ -183,6 +222,7 @@ private:
 	Chunk* current_;
 	uint8_t* p_;
 	uint8_t* end_;
+	uint64_t capacity_;
 	uint64_t nextSize_;
 	uint64_t intialSizeAndPolicy_;
 };
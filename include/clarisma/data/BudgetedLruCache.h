@@ -0,0 +1,131 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace clarisma {
+
+/// A cache of shared, immutable values whose total size is limited
+/// by a memory budget. Each value is added along with its size; if
+/// the total size exceeds the budget, the least-recently-used values
+/// are dropped from the cache. Handles that still refer to an evicted
+/// value keep it alive until they are released.
+///
+/// This class is thread-safe.
+///
+template <typename K, typename V>
+class BudgetedLruCache
+{
+public:
+    using Handle = std::shared_ptr<const V>;
+
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t count;
+        uint64_t bytes;
+        uint64_t budget;
+    };
+
+    explicit BudgetedLruCache(uint64_t budget) : budget_(budget) {}
+
+    BudgetedLruCache(const BudgetedLruCache&) = delete;
+    BudgetedLruCache& operator=(const BudgetedLruCache&) = delete;
+
+    /// Returns the cached value for the given key,
+    /// or an empty handle if there is none.
+    Handle get(const K& key)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = map_.find(key);
+        if (it == map_.end())
+        {
+            misses_++;
+            return {};
+        }
+        hits_++;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->value;
+    }
+
+    /// Adds a value to the cache. If another thread has cached a
+    /// value for the same key in the meantime, that one is returned
+    /// instead. A value larger than the entire budget is returned
+    /// without being cached.
+    Handle put(const K& key, Handle value, uint64_t size)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (size > budget_) return value;
+        auto it = map_.find(key);
+        if (it != map_.end())
+        {
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return it->second->value;
+        }
+        entries_.push_front({ key, size, value });
+        map_.emplace(key, entries_.begin());
+        bytes_ += size;
+        evict(budget_);
+        return value;
+    }
+
+    /// Sets the maximum total size of the cached values
+    /// (0 disables the cache).
+    void setBudget(uint64_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        budget_ = bytes;
+        evict(bytes);
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        evict(0);
+    }
+
+    Stats stats()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return { hits_, misses_, evictions_, entries_.size(), bytes_, budget_ };
+    }
+
+private:
+    struct Entry
+    {
+        K key;
+        uint64_t size;
+        Handle value;
+    };
+
+    void evict(uint64_t maxBytes)      // requires lock
+    {
+        while (bytes_ > maxBytes)
+        {
+            Entry& entry = entries_.back();
+            bytes_ -= entry.size;
+            map_.erase(entry.key);
+            entries_.pop_back();
+            evictions_++;
+        }
+    }
+
+    std::mutex mutex_;
+    std::list<Entry> entries_;          // most recently used first
+    std::unordered_map<K, typename std::list<Entry>::iterator> map_;
+    uint64_t budget_;
+    uint64_t bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+};
+
+} // namespace clarisma
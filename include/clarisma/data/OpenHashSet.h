@@ -0,0 +1,177 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace clarisma {
+
+/// A compact set of integer keys, based on open addressing with
+/// linear probing. All keys live in a single flat table, which
+/// makes lookups far more cache-friendly than std::unordered_set
+/// (no per-key allocations, no chains to follow).
+///
+/// Keys are removed via backward-shift deletion, so the table never
+/// accumulates tombstones. The key 0 marks an empty slot; it can
+/// still be stored, but is tracked separately.
+///
+/// The table is grown once it is 3/4 full, but never shrinks.
+///
+template<typename K>
+class OpenHashSet
+{
+public:
+    static_assert(std::is_integral_v<K>, "Keys must be integers");
+
+    explicit OpenHashSet(size_t initialCapacity = 64) :
+        count_(0),
+        hasZero_(false)
+    {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < initialCapacity) capacity <<= 1;
+        allocate(capacity);
+    }
+
+    size_t size() const noexcept { return count_ + (hasZero_ ? 1 : 0); }
+    bool isEmpty() const noexcept { return size() == 0; }
+    size_t capacity() const noexcept { return mask_ + 1; }
+
+    bool contains(K key) const noexcept
+    {
+        if (key == 0) [[unlikely]] return hasZero_;
+        for (size_t slot = slotOf(key); ; slot = (slot + 1) & mask_)
+        {
+            K k = table_[slot];
+            if (k == key) return true;
+            if (k == 0) return false;
+        }
+    }
+
+    /// Adds the given key. Returns `true` if the key was added,
+    /// or `false` if the set already contained it.
+    bool insert(K key)
+    {
+        if (key == 0) [[unlikely]]
+        {
+            bool added = !hasZero_;
+            hasZero_ = true;
+            return added;
+        }
+        size_t slot = slotOf(key);
+        for (;;)
+        {
+            K k = table_[slot];
+            if (k == key) return false;
+            if (k == 0) break;
+            slot = (slot + 1) & mask_;
+        }
+        if (count_ >= growthThreshold_) [[unlikely]]
+        {
+            grow();
+            slot = slotOf(key);
+            while (table_[slot] != 0) slot = (slot + 1) & mask_;
+        }
+        table_[slot] = key;
+        count_++;
+        return true;
+    }
+
+    /// Removes the given key. Returns `true` if the set
+    /// contained the key.
+    bool erase(K key) noexcept
+    {
+        if (key == 0) [[unlikely]]
+        {
+            bool removed = hasZero_;
+            hasZero_ = false;
+            return removed;
+        }
+        size_t slot = slotOf(key);
+        for (;;)
+        {
+            K k = table_[slot];
+            if (k == key) break;
+            if (k == 0) return false;
+            slot = (slot + 1) & mask_;
+        }
+
+        // Move back any keys that follow the removed key in the
+        // same cluster, unless doing so would place them ahead
+        // of their home slot
+
+        size_t hole = slot;
+        for (size_t next = (hole + 1) & mask_; ; next = (next + 1) & mask_)
+        {
+            K k = table_[next];
+            if (k == 0) break;
+            size_t home = slotOf(k);
+            if (((next - home) & mask_) >= ((next - hole) & mask_))
+            {
+                table_[hole] = k;
+                hole = next;
+            }
+        }
+        table_[hole] = 0;
+        count_--;
+        return true;
+    }
+
+    void clear() noexcept
+    {
+        memset(table_.get(), 0, capacity() * sizeof(K));
+        count_ = 0;
+        hasZero_ = false;
+    }
+
+private:
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    size_t slotOf(K key) const noexcept
+    {
+        // Fibonacci hashing: the high bits of the product depend on
+        // all bits of the key, so keys that only differ in their
+        // upper bits (or share the same low bits) still spread well
+        uint64_t hash = static_cast<uint64_t>(key) * 0x9E37'79B9'7F4A'7C15ULL;
+        return static_cast<size_t>(hash >> shift_);
+    }
+
+    void allocate(size_t capacity)
+    {
+        assert((capacity & (capacity - 1)) == 0);
+        table_.reset(new K[capacity]());
+        mask_ = capacity - 1;
+        growthThreshold_ = capacity - capacity / 4;
+        int bits = 0;
+        while ((size_t{1} << bits) < capacity) bits++;
+        shift_ = 64 - bits;
+    }
+
+    void grow()
+    {
+        size_t oldCapacity = capacity();
+        std::unique_ptr<K[]> oldTable = std::move(table_);
+        allocate(oldCapacity * 2);
+        for (size_t i = 0; i < oldCapacity; i++)
+        {
+            K k = oldTable[i];
+            if (k == 0) continue;
+            size_t slot = slotOf(k);
+            while (table_[slot] != 0) slot = (slot + 1) & mask_;
+            table_[slot] = k;
+        }
+    }
+
+    std::unique_ptr<K[]> table_;
+    size_t mask_;
+    size_t count_;
+    size_t growthThreshold_;
+    int shift_;
+    bool hasZero_;
+};
+
+} // namespace clarisma
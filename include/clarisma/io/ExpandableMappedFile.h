@@ -49,6 +49,7 @@ public:
 	 */
 	byte* translate(uint64_t ofs);
 	byte* mainMapping() const { return mainMapping_; }
+	size_t mainMappingSize() const { return mainMappingSize_; }
 	byte* mapping(int n);
 	size_t mappingSize(int n) const;
 	int mappingNumber(uint64_t ofs) const;
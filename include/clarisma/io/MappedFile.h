@@ -23,6 +23,16 @@ public:
     {
         READ = 1 << 0,
         WRITE = 1 << 1,
+        POPULATE = 1 << 8,      // pre-fault the pages of the mapping
+    };
+
+    /// Hints about how a mapped range will be accessed
+    enum class Advice
+    {
+        NORMAL,
+        RANDOM,         // disables read-ahead
+        SEQUENTIAL,     // aggressive read-ahead
+        HUGE_PAGES      // back the range with huge pages, if possible
     };
 
     void* map(uint64_t offset, uint64_t length, int /* MappingMode */ mode);
@@ -44,6 +54,19 @@ public:
     static void unmap(void* address, uint64_t length);
     void prefetch(void* address, uint64_t length);
         // TODO: technically, does not need to be part of MappedFile
+
+    /// Returns the number of bytes of the given range whose pages
+    /// are currently in physical memory (whole pages are counted)
+    static uint64_t residentBytes(const void* address, uint64_t length);
+
+    /// Locks the pages of the given range into physical memory.
+    /// Returns `false` if the OS refused (e.g. due to resource limits)
+    static bool lock(const void* address, uint64_t length);
+
+    /// Passes an access hint for the given range to the OS.
+    /// Returns `false` if the hint is not supported on this platform
+    /// (or was rejected), which is harmless
+    static bool advise(const void* address, uint64_t length, Advice advice);
     void sync(const void* address, uint64_t length);
 };
 
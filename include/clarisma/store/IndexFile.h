@@ -43,9 +43,33 @@ public:
 		ExpandableMappedFile::open(filename, mode);
 	}
 
+	void close()
+	{
+		unmapSegments();
+		ExpandableMappedFile::close();
+	}
+
+	~IndexFile()
+	{
+		unmapSegments();
+	}
+
 	uint32_t get(uint64_t key);
 	void put(uint64_t key, uint32_t value);
 
+	/**
+	 * Returns the value for the given key, or 0 if the key lies 
+	 * beyond the end of the file (unlike get(), this is safe for 
+	 * files that have been opened read-only).
+	 */
+	uint32_t tryGet(uint64_t key)
+	{
+		assert(bits_);
+		if (!isOpen()) return 0;
+		uint64_t end = (key / slotsPerBlock_ + 1) * BLOCK_SIZE;
+		return end <= mainMappingSize() ? get(key) : 0;
+	}
+
 private:
 	static const uint32_t BLOCK_SIZE = 4096;
 
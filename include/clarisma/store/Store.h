@@ -37,7 +37,8 @@ public:
 		WRITE = 1 << 1,			// TODO: expected to match File::OpenMode
 		CREATE = 1 << 2,		// TODO: expected to match File::OpenMode
 								// TODO: Create always implies WRITE
-		EXCLUSIVE = 1 << 7
+		EXCLUSIVE = 1 << 7,
+		POPULATE = 1 << 8		// TODO: expected to match MappedFile::MappingMode
 	};
 
 	Store();
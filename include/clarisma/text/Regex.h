@@ -0,0 +1,155 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace clarisma {
+
+class RegexException : public std::runtime_error
+{
+public:
+    explicit RegexException(const char* message) : std::runtime_error(message) {}
+};
+
+/// A regular expression that is matched in linear time. The pattern is
+/// compiled to an NFA, which in turn is converted to a DFA (unless the
+/// DFA would be too large, in which case the NFA is simulated directly
+/// -- still in linear time, but slower). Since there is no backtracking,
+/// no pattern can cause exponential run time.
+///
+/// The syntax is the ECMAScript subset that does not require
+/// backtracking: literals and escapes (`\d \w \s \D \W \S \t \n \r
+/// \f \v \0 \xHH \uHHHH`), `.`, character classes, groups (`(...)`,
+/// `(?:...)`), alternation, the anchors `^` and `$`, and the greedy or
+/// lazy quantifiers `* + ? {n} {n,} {n,m}`. Backreferences, lookaround
+/// and word boundaries are rejected. Like `std::regex` on `char`, the
+/// pattern operates on bytes (except that `\xHH` and `\uHHHH` outside
+/// of character classes match the UTF-8 encoding of the code point).
+///
+/// Literal text required by the pattern (a prefix, a suffix, or the
+/// longest literal run) is extracted at compile time, so most
+/// non-matching strings are rejected by a plain substring test
+/// before the automaton runs.
+///
+/// A Regex is immutable once constructed, and can be used by
+/// multiple threads at the same time.
+///
+class Regex
+{
+public:
+    explicit Regex(std::string_view pattern);
+
+    /// Checks whether the pattern matches the *entire* string
+    /// (the equivalent of `std::regex_match`)
+    bool match(std::string_view s) const;
+
+    bool isLiteral() const noexcept { return isLiteral_; }
+    bool hasDfa() const noexcept { return !transitions_.empty(); }
+    const std::string& literalPrefix() const noexcept { return prefix_; }
+    const std::string& literalSuffix() const noexcept { return suffix_; }
+    const std::string& requiredLiteral() const noexcept { return required_; }
+
+    struct ByteSet
+    {
+        uint64_t bits[4] = {};
+
+        bool contains(uint8_t b) const noexcept
+        {
+            return (bits[b >> 6] >> (b & 63)) & 1;
+        }
+        void add(uint8_t b) noexcept { bits[b >> 6] |= uint64_t{1} << (b & 63); }
+        void addRange(uint8_t from, uint8_t to) noexcept
+        {
+            for (int b = from; b <= to; b++) add(static_cast<uint8_t>(b));
+        }
+        void add(const ByteSet& other) noexcept
+        {
+            for (int i = 0; i < 4; i++) bits[i] |= other.bits[i];
+        }
+        void invert() noexcept
+        {
+            for (int i = 0; i < 4; i++) bits[i] = ~bits[i];
+        }
+        bool operator==(const ByteSet& other) const noexcept
+        {
+            return bits[0] == other.bits[0] && bits[1] == other.bits[1] &&
+                bits[2] == other.bits[2] && bits[3] == other.bits[3];
+        }
+    };
+
+    struct Instruction
+    {
+        enum Opcode : uint8_t
+        {
+            BYTES,      // consume a byte in sets_[x]
+            SPLIT,      // continue at x and y
+            JUMP,       // continue at x
+            BEGIN,      // ^
+            END,        // $
+            MATCH
+        };
+
+        Opcode opcode;
+        int32_t x;
+        int32_t y;
+    };
+
+    static constexpr size_t MAX_PROGRAM_SIZE = 32 * 1024;
+    static constexpr size_t MAX_DFA_STATES = 2048;
+
+private:
+    using Threads = std::vector<int32_t>;
+
+    /// Working memory of the NFA simulation. It is kept per thread
+    /// (since a Regex may be shared), and only grows, so matching
+    /// doesn't allocate once it has reached its working size.
+    struct Scratch
+    {
+        Threads current;
+        Threads next;
+        Threads stack;
+        /// The generation in which each instruction was last visited;
+        /// bumping the generation clears all marks at once
+        std::vector<uint32_t> visited;
+        uint32_t generation = 0;
+
+        void newGeneration(size_t programSize);
+        bool visit(int32_t pc)
+        {
+            if (visited[pc] == generation) return false;
+            visited[pc] = generation;
+            return true;
+        }
+    };
+
+    void buildByteClasses();
+    void buildDfa();
+    void addClosure(int32_t pc, bool atStart, bool atEnd, Threads& threads,
+        Scratch& scratch, bool* matched) const;
+    void start(Threads& threads, Scratch& scratch) const;
+    void step(const Threads& current, uint8_t b, Threads& next,
+        Scratch& scratch) const;
+    bool accepts(const Threads& threads, bool atStart, Scratch& scratch) const;
+    bool matchNfa(std::string_view s) const;
+
+    std::vector<Instruction> program_;
+    std::vector<ByteSet> sets_;
+    uint8_t byteClasses_[256];
+    int classCount_;
+    std::vector<uint32_t> transitions_;     // [state * classCount_ + class]
+    std::vector<uint8_t> accepting_;
+    std::string prefix_;
+    std::string suffix_;
+    std::string required_;
+    bool isLiteral_;
+
+    friend class RegexCompiler;
+};
+
+} // namespace clarisma
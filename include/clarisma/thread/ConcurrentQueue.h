@@ -0,0 +1,145 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace clarisma {
+
+/// A bounded, lock-free multi-producer/multi-consumer queue
+/// (based on Dmitry Vyukov's ring buffer design). Each slot carries
+/// a sequence number that tells producers and consumers whether it
+/// is ready to be written or read, so neither side ever takes a lock;
+/// contention is limited to a CAS on the head or tail index.
+///
+/// The capacity is rounded up to the next power of 2.
+/// `T` must be default-constructible and copy- or move-assignable.
+///
+template <typename T>
+class ConcurrentQueue
+{
+public:
+    explicit ConcurrentQueue(size_t capacity) :
+        mask_(roundUpToPowerOf2(capacity) - 1),
+        slots_(new Slot[mask_ + 1]),
+        head_(0),
+        tail_(0)
+    {
+        for (size_t i = 0; i <= mask_; i++)
+        {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ConcurrentQueue(const ConcurrentQueue&) = delete;
+    ConcurrentQueue& operator=(const ConcurrentQueue&) = delete;
+
+    size_t capacity() const noexcept { return mask_ + 1; }
+
+    /// Attempts to add an item to the queue. Returns `false` if
+    /// the queue is full.
+    bool tryPush(const T& item)
+    {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;)
+        {
+            slot = &slots_[pos & mask_];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1,
+                    std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;   // queue is full
+            }
+            else
+            {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->item = item;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Attempts to remove the item at the head of the queue.
+    /// Returns `false` if the queue is empty.
+    bool tryPop(T& item)
+    {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;)
+        {
+            slot = &slots_[pos & mask_];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (head_.compare_exchange_weak(pos, pos + 1,
+                    std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;   // queue is empty
+            }
+            else
+            {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(slot->item);
+        slot->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Returns the approximate number of items in the queue (exact
+    /// only if no other thread is pushing or popping at the same time)
+    size_t count() const noexcept
+    {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool isEmpty() const noexcept { return count() == 0; }
+
+private:
+    static size_t roundUpToPowerOf2(size_t n)
+    {
+        size_t size = 2;
+        while (size < n) size <<= 1;
+        return size;
+    }
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    // Head and tail are written by different sets of threads;
+    // keep them on separate cache lines to avoid false sharing
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_;
+};
+
+} // namespace clarisma
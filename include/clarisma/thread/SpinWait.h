@@ -0,0 +1,67 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <thread>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace clarisma {
+
+/// The wait policy used by the lock-free queues: A waiting thread
+/// first busy-waits (with a CPU pause hint), then yields its time
+/// slice a few times, and finally reports that it should park
+/// (i.e. block on a condition variable or similar).
+///
+/// Usage:
+///
+///     SpinWait wait;
+///     while (!ready())
+///     {
+///         if (!wait.spin()) park();
+///     }
+///
+class SpinWait
+{
+public:
+    static constexpr int SPIN_LIMIT = 128;
+    static constexpr int YIELD_LIMIT = SPIN_LIMIT + 16;
+
+    /// Waits briefly. Returns `false` once the spin budget has been
+    /// used up, at which point the caller should park.
+    bool spin() noexcept
+    {
+        if (count_ >= YIELD_LIMIT) return false;
+        if (count_ < SPIN_LIMIT)
+        {
+            pause();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+        count_++;
+        return true;
+    }
+
+    void reset() noexcept { count_ = 0; }
+
+    /// Hints to the CPU that the calling thread is busy-waiting
+    static void pause() noexcept
+    {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#endif
+    }
+
+private:
+    int count_ = 0;
+};
+
+} // namespace clarisma
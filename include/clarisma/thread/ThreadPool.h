@@ -3,27 +3,37 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <thread>
 #include <condition_variable>
+#include <clarisma/thread/ConcurrentQueue.h>
+#include <clarisma/thread/SpinWait.h>
 
 namespace clarisma {
 
+// Tasks are handed to the workers through a lock-free ring buffer,
+// so posting a task never takes a lock. An idle worker spins briefly
+// before it parks on notEmpty_; mutex_ is only needed to park and
+// to wake parked workers (a producer checks parkedCount_ and skips
+// the notification if all workers are busy). Likewise, a producer
+// that finds the queue full (or a thread that awaits completion)
+// spins before it parks on notFull_, and a worker only wakes it
+// if waitingCount_ indicates that somebody is parked.
 
 template <typename TaskType>
 class ThreadPool
 {
 public:
     ThreadPool(int numberOfThreads, int queueSize) :
-        queueSize_(queueSize == 0 ? (numberOfThreads * 4) : queueSize), 
-        count_(0), 
-        front_(0), 
-        rear_(0), 
+        queue_(queueSize == 0 ? (std::max(numberOfThreads, 1) * 4) : queueSize),
+        parkedCount_(0),
+        waitingCount_(0),
         running_(true)
     {
         numberOfThreads = (numberOfThreads == 0) ? 1 : numberOfThreads;
         threads_.reserve(numberOfThreads);
-        queue_.resize(queueSize_);      // Don't use `queueSize` since we adjusted it
         for (int i = 0; i < numberOfThreads; i++)
         {
             threads_.emplace_back(&ThreadPool::worker, this);
@@ -37,59 +47,53 @@ public:
 
     void post(const TaskType& task)
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        notFull_.wait(lock, [this] { return count_ < queueSize_; });
-        queue_[rear_] = task;
-        rear_ = (rear_ + 1) % queueSize_;
-        count_++;
-        notEmpty_.notify_one();
+        post(task, true);
     }
 
     bool tryPost(const TaskType& task)
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        if (count_ == queueSize_) return false;
-        queue_[rear_] = task;
-        rear_ = (rear_ + 1) % queueSize_;
-        count_++;
-        notEmpty_.notify_one();
+        if (!queue_.tryPush(task)) return false;
+        wakeWorker();
         return true;
     }
 
     bool post(const TaskType& task, bool wait)
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        if (count_ == queueSize_)
+        SpinWait spin;
+        while (!queue_.tryPush(task))
         {
             if (!wait) return false;
-            notFull_.wait(lock, [this] { return count_ < queueSize_; });
+            if (!spin.spin())
+            {
+                awaitTaken([this] { return queue_.count() < queue_.capacity(); });
+                spin.reset();
+            }
         }
-        queue_[rear_] = task;
-        rear_ = (rear_ + 1) % queueSize_;
-        count_++;
-        notEmpty_.notify_one();
+        wakeWorker();
         return true;
     }
 
     int minimumRemainingCapacity()
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        // TODO: No lock needed, as long as there aren't multiple consumers
-        // count_ will only decrease, so this should be safe without locking
-        // But no noticeable performance difference, so we'll leave the lock for now
-        return queueSize_ - count_;
+        // Only approximate if other threads are posting at the
+        // same time
+        return static_cast<int>(queue_.capacity() - queue_.count());
     }
 
     void awaitCompletion()
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        while (count_ != 0) 
-        {  // Continue to wait as long as there are tasks in the queue
-            notFull_.wait(lock);  // Wait for a signal that a task has been completed
+        SpinWait spin;
+        while (!queue_.isEmpty())
+        {
+            if (!spin.spin())
+            {
+                awaitTaken([this] { return queue_.isEmpty(); });
+                spin.reset();
+            }
         }
-        // When the loop exits, all tasks have been completed
+        // When the loop exits, all tasks have been taken from the queue
 
-        // TODO: This does not work, because condition is signaled 
+        // TODO: This does not work, because the queue becomes empty
         //  when the thread takes the task from the queue, not when it completes it
         // We need a counter that indicates the number of threads still running
     }
@@ -110,41 +114,91 @@ private:
     void signalShutdown()
     {
         std::unique_lock<std::mutex> lock(mutex_);
-        running_ = false;
+        running_.store(false, std::memory_order_seq_cst);
         notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+    void wakeWorker()
+    {
+        // The fence pairs with the one in park(): Either we see
+        // the parked worker, or it sees our task
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parkedCount_.load(std::memory_order_relaxed) > 0) [[unlikely]]
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.notify_one();
+        }
+    }
+
+    /// Blocks until `done` is true or the pool is shut down; the
+    /// workers re-check after taking a task from the queue.
+    template <typename Predicate>
+    void awaitTaken(Predicate done)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waitingCount_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!done() && running_.load(std::memory_order_relaxed))
+        {
+            notFull_.wait(lock);
+        }
+        waitingCount_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void wakeWaiting()
+    {
+        // Pairs with the fence in awaitTaken(), like wakeWorker()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waitingCount_.load(std::memory_order_relaxed) > 0) [[unlikely]]
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notFull_.notify_all();
+        }
+    }
+
+    /// Blocks until a task may be available or the pool is shut down.
+    void park()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        parkedCount_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (queue_.isEmpty() && running_.load(std::memory_order_relaxed))
+        {
+            notEmpty_.wait(lock);
+        }
+        parkedCount_.fetch_sub(1, std::memory_order_relaxed);
     }
 
     void worker()
     {
-        for(;;)
+        TaskType task;
+        SpinWait spin;
+        while (running_.load(std::memory_order_relaxed))
         {
-            TaskType task;
+            if (queue_.tryPop(task))
+            {
+                wakeWaiting();
+                task();
+                spin.reset();
+                continue;
+            }
+            if (!spin.spin())
             {
-                std::unique_lock<std::mutex> lock(mutex_);
-                for (;;)
-                {
-                    if (!running_) return;
-                    if (count_ > 0) break;
-                    notEmpty_.wait(lock);
-                }
-                task = std::move(queue_[front_]);
-                front_ = (front_ + 1) % queueSize_;
-                count_--;
-                notFull_.notify_one();
+                park();
+                spin.reset();
             }
-            task();
         }
     }
 
     std::vector<std::thread> threads_;
-    std::vector<TaskType> queue_;
-    int front_;
-    int rear_;
-    int queueSize_;
-    int count_;
+    ConcurrentQueue<TaskType> queue_;
+    std::atomic<int> parkedCount_;
+    std::atomic<int> waitingCount_;
+    std::atomic<bool> running_;
     std::mutex mutex_;
-    std::condition_variable notEmpty_, notFull_;
-    bool running_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
 };
 
 } // namespace clarisma
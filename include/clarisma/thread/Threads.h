@@ -2,9 +2,13 @@
 // SPDX-License-Identifier: LGPL-3.0-only
 
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <sstream>
 #include <thread>
 #include <string>
+#include <vector>
 
 namespace clarisma {
 
@@ -16,5 +20,61 @@ namespace Threads
 		ss << std::this_thread::get_id();
 		return ss.str();
 	}
+
+	/// Calls fn(i) for each i in [0, count), using up to `threadCount`
+	/// threads (including the calling thread; 0 means one per core).
+	/// Indexes are handed out in batches of `grain`. If fn throws,
+	/// the remaining indexes are skipped and the first exception is
+	/// rethrown once all threads have finished.
+	template <typename Fn>
+	void parallelFor(size_t count, int threadCount, Fn&& fn, size_t grain = 64)
+	{
+		if (threadCount <= 0) threadCount = static_cast<int>(std::thread::hardware_concurrency());
+		size_t batches = (count + grain - 1) / grain;
+		threadCount = static_cast<int>(std::min<size_t>(std::max(threadCount, 1), batches));
+		if (threadCount <= 1)
+		{
+			for (size_t i = 0; i < count; i++) fn(i);
+			return;
+		}
+
+		std::atomic<size_t> next(0);
+		std::atomic<bool> failed(false);
+		std::exception_ptr error;
+		auto work = [&]()
+		{
+			try
+			{
+				for (;;)
+				{
+					size_t start = next.fetch_add(grain, std::memory_order_relaxed);
+					if (start >= count || failed.load(std::memory_order_relaxed)) break;
+					size_t end = std::min(start + grain, count);
+					for (size_t i = start; i < end; i++) fn(i);
+				}
+			}
+			catch (...)
+			{
+				if (!failed.exchange(true)) error = std::current_exception();
+			}
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount - 1);
+		try
+		{
+			for (int i = 1; i < threadCount; i++) threads.emplace_back(work);
+		}
+		catch (...)
+		{
+			// Couldn't start a thread: stop the ones already running
+			failed = true;
+			for (std::thread& thread : threads) thread.join();
+			throw;
+		}
+		work();
+		for (std::thread& thread : threads) thread.join();
+		if (error) std::rethrow_exception(error);
+	}
 }
 } // namespace clarisma
@@ -0,0 +1,279 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <clarisma/thread/ConcurrentQueue.h>
+#include <clarisma/thread/SpinWait.h>
+
+namespace clarisma {
+
+/// A thread pool in which each worker owns a set of task queues
+/// (one per priority level). Tasks are distributed round-robin
+/// across the workers; a worker takes tasks from its own queue
+/// first, and steals from the other workers once its own queue
+/// has run dry. Higher-priority tasks are always taken before
+/// lower-priority ones, regardless of which worker holds them.
+///
+/// Clients (e.g. queries) that share the pool can register
+/// themselves, which allows each of them to limit the number
+/// of tasks it keeps in flight to its fairShare(), so a large
+/// client cannot crowd out the others.
+///
+/// All queue operations are lock-free; a mutex is only used
+/// to park idle workers (and producers that find all queues
+/// full), and to wake them up.
+///
+template <typename TaskType>
+class WorkStealingPool
+{
+public:
+    static constexpr int PRIORITY_LEVELS = 2;
+
+    /// @param numberOfThreads  number of workers (at least 1)
+    /// @param queueSize        capacity of each worker's queue
+    ///                         (per priority level; 0 = default)
+    WorkStealingPool(int numberOfThreads, int queueSize) :
+        nextWorker_(0),
+        parkedCount_(0),
+        waitingCount_(0),
+        clientCount_(0),
+        running_(true)
+    {
+        numberOfThreads = std::max(numberOfThreads, 1);
+        queueSize = (queueSize == 0) ? DEFAULT_QUEUE_SIZE : queueSize;
+        workers_.reserve(numberOfThreads);
+        for (int i = 0; i < numberOfThreads; i++)
+        {
+            workers_.emplace_back(new Worker(queueSize));
+        }
+        for (int i = 0; i < numberOfThreads; i++)
+        {
+            workers_[i]->thread = std::thread(&WorkStealingPool::work, this, i);
+        }
+    }
+
+    ~WorkStealingPool()
+    {
+        shutdown();
+    }
+
+    int workerCount() const noexcept
+    {
+        return static_cast<int>(workers_.size());
+    }
+
+    /// The number of tasks (per priority level) the pool can hold
+    size_t capacity() const noexcept
+    {
+        return workers_.size() * workers_[0]->queues[0].capacity();
+    }
+
+    /// Attempts to queue a task without blocking. Returns `false`
+    /// if the queues of all workers are full.
+    bool tryPost(const TaskType& task, int priority = 0)
+    {
+        assert(priority >= 0 && priority < PRIORITY_LEVELS);
+        size_t workerCount = workers_.size();
+        size_t start = nextWorker_.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < workerCount; i++)
+        {
+            Worker& worker = *workers_[(start + i) % workerCount];
+            if (worker.queues[priority].tryPush(task))
+            {
+                wakeWorker();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Queues a task, blocking while the queues of all workers
+    /// are full (the caller spins briefly, then parks until a
+    /// worker has taken a task)
+    void post(const TaskType& task, int priority = 0)
+    {
+        SpinWait spin;
+        while (!tryPost(task, priority))
+        {
+            if (!spin.spin())
+            {
+                awaitRoom(priority);
+                spin.reset();
+            }
+        }
+    }
+
+    void addClient() noexcept
+    {
+        clientCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void removeClient() noexcept
+    {
+        clientCount_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// The number of tasks a registered client should keep in flight
+    /// at most, so all clients get a similar share of the pool
+    int fairShare() const noexcept
+    {
+        int clients = std::max(clientCount_.load(std::memory_order_relaxed), 1);
+        return std::max(static_cast<int>(capacity()) / clients, MIN_FAIR_SHARE);
+    }
+
+    void shutdown()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            running_.store(false, std::memory_order_seq_cst);
+            notEmpty_.notify_all();
+            notFull_.notify_all();
+        }
+        for (auto& worker : workers_)
+        {
+            if (worker->thread.joinable()) worker->thread.join();
+        }
+    }
+
+private:
+    static constexpr int DEFAULT_QUEUE_SIZE = 8;
+    static constexpr int MIN_FAIR_SHARE = 2;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct alignas(CACHE_LINE_SIZE) Worker
+    {
+        explicit Worker(int queueSize) :
+            queues{ ConcurrentQueue<TaskType>(queueSize),
+                ConcurrentQueue<TaskType>(queueSize) } {}
+
+        ConcurrentQueue<TaskType> queues[PRIORITY_LEVELS];
+        std::thread thread;
+    };
+
+    bool tryTake(size_t self, TaskType& task)
+    {
+        size_t workerCount = workers_.size();
+        for (int priority = PRIORITY_LEVELS - 1; priority >= 0; priority--)
+        {
+            if (workers_[self]->queues[priority].tryPop(task)) return true;
+            for (size_t i = 1; i < workerCount; i++)
+            {
+                Worker& victim = *workers_[(self + i) % workerCount];
+                if (victim.queues[priority].tryPop(task)) return true;
+            }
+        }
+        return false;
+    }
+
+    bool hasRoom(int priority) const noexcept
+    {
+        for (const auto& worker : workers_)
+        {
+            const ConcurrentQueue<TaskType>& queue = worker->queues[priority];
+            if (queue.count() < queue.capacity()) return true;
+        }
+        return false;
+    }
+
+    bool hasTasks() const noexcept
+    {
+        for (const auto& worker : workers_)
+        {
+            for (const auto& queue : worker->queues)
+            {
+                if (!queue.isEmpty()) return true;
+            }
+        }
+        return false;
+    }
+
+    void wakeWorker()
+    {
+        // The fence pairs with the one in park(): Either we see
+        // the parked worker, or it sees our task
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parkedCount_.load(std::memory_order_relaxed) > 0) [[unlikely]]
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.notify_one();
+        }
+    }
+
+    /// Blocks until a queue of the given priority has room,
+    /// or the pool is shut down
+    void awaitRoom(int priority)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waitingCount_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!hasRoom(priority) && running_.load(std::memory_order_relaxed))
+        {
+            notFull_.wait(lock);
+        }
+        waitingCount_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void wakeWaiting()
+    {
+        // Pairs with the fence in awaitRoom(), like wakeWorker()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waitingCount_.load(std::memory_order_relaxed) > 0) [[unlikely]]
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notFull_.notify_all();
+        }
+    }
+
+    void park()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        parkedCount_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!hasTasks() && running_.load(std::memory_order_relaxed))
+        {
+            notEmpty_.wait(lock);
+        }
+        parkedCount_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void work(int self)
+    {
+        TaskType task;
+        SpinWait spin;
+        while (running_.load(std::memory_order_relaxed))
+        {
+            if (tryTake(self, task))
+            {
+                wakeWaiting();
+                task();
+                spin.reset();
+                continue;
+            }
+            if (!spin.spin())
+            {
+                park();
+                spin.reset();
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> nextWorker_;
+    std::atomic<int> parkedCount_;
+    std::atomic<int> waitingCount_;
+    std::atomic<int> clientCount_;
+    std::atomic<bool> running_;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+};
+
+} // namespace clarisma
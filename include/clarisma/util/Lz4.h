@@ -0,0 +1,48 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace clarisma {
+
+class Lz4Exception : public std::runtime_error
+{
+public:
+    explicit Lz4Exception(const char* message) : std::runtime_error(message) {}
+};
+
+/// Compression and decompression of raw LZ4 blocks (the block format
+/// without the frame, as produced by `LZ4_compress_default()`).
+/// The decoder is strict: it never reads or writes out of bounds,
+/// and throws Lz4Exception if the input is malformed.
+///
+class Lz4
+{
+public:
+    static constexpr size_t maxCompressedSize(size_t size) noexcept
+    {
+        return size + size / 255 + 16;
+    }
+
+    /// Compresses `size` bytes into `dest`, which must have room for
+    /// maxCompressedSize(size) bytes. Returns the compressed size.
+    static size_t compress(const uint8_t* src, size_t size, uint8_t* dest);
+
+    /// Decompresses a block into `dest`, which must be exactly
+    /// `size` bytes (the uncompressed size of the block).
+    static void decompress(const uint8_t* src, size_t compressedSize,
+        uint8_t* dest, size_t size);
+
+private:
+    static constexpr int MIN_MATCH = 4;
+    static constexpr int LAST_LITERALS = 5;         // required by the format
+    static constexpr int MATCH_SAFE_DISTANCE = 12;  // from the end of input
+    static constexpr int HASH_BITS = 14;
+    static constexpr uint32_t MAX_DISTANCE = 65535;
+};
+
+} // namespace clarisma
@@ -227,6 +227,40 @@ public:
     ///
     Feature one() const;
 
+    /// @brief Returns the Feature with the given type and ID, or `std::nullopt`
+    /// if there is no such Feature (or if it does not meet the type, tag and
+    /// spatial constraints of this collection).
+    ///
+    /// Lookups by ID require an ID index, which must be created once
+    /// (see FeatureStore::buildIdIndex()); it is stored next to the GOL.
+    ///
+    /// @throws QueryException if the GOL has no ID index
+    ///
+    std::optional<Feature> byId(FeatureType type, uint64_t id) const;
+
+    /// @brief Looks up the Features with the given IDs. This is faster than
+    /// calling byId() for each ID, since the lookups are sorted by tile.
+    ///
+    /// @return the Features, in the same order as `ids`
+    ///   (`std::nullopt` for IDs without a matching Feature)
+    ///
+    /// @throws QueryException if the GOL has no ID index
+    ///
+    std::vector<std::optional<Feature>> byIds(FeatureType type,
+        std::span<const uint64_t> ids) const;
+
+    /// @brief Returns a collection that contains at most `n` of the
+    /// Feature objects in this collection.
+    ///
+    /// Once a query has found `n` features, it stops scanning tiles,
+    /// which makes this much cheaper than iterating the full collection
+    /// and stopping early. Just like first(), which features are
+    /// returned is arbitrary, unless the collection is ordered.
+    ///
+    /// @param n the maximum number of features
+    ///
+    Features limit(uint64_t n) const;
+
     /// @brief Returns a `std::vector` with the Feature objects in this collection.
     ///
     operator std::vector<Feature>() const;
@@ -246,6 +280,31 @@ public:
     ///
     void addTo(std::vector<FeaturePtr>& features) const;
 
+    /// @}
+    /// @name Batch Queries
+    /// @{
+
+    /// @brief Calls `fn(i, feature)` for each Feature in this collection
+    /// whose bounding box intersects `boxes[i]`.
+    ///
+    /// This is much faster than querying each box on its own: the boxes
+    /// are sorted along a Hilbert curve, and each tile is read only once
+    /// (by multiple threads). Results arrive in no particular order, but
+    /// `fn` is always called on the calling thread.
+    ///
+    template<typename Fn>
+    void forEachIntersecting(std::span<const Box> boxes, Fn fn) const;
+
+    /// @brief Calls `fn(i, feature)` for each Feature in this collection
+    /// whose geometry contains `points[i]`. Use this to find the
+    /// administrative areas of a large set of locations, for example.
+    ///
+    /// @throws QueryException if one or more tiles that contain
+    ///   the geometry of a Relation are missing
+    ///
+    template<typename Fn>
+    void forEachContaining(std::span<const Coordinate> points, Fn fn) const;
+
     /// @}
     /// @name Scalar Queries
     /// @{
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <geodesk/feature/RelationPtr.h>
+#include <geodesk/feature/TileCache.h>
 
 namespace geodesk {
 
@@ -23,6 +24,7 @@ private:
 	int32_t currentMember_;
 	DataPtr p_;
 	DataPtr pForeignTile_;
+	TilePin foreignTilePin_;
 };
 
 // \endcond
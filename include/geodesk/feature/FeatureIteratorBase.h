@@ -35,11 +35,13 @@ private:
 		const MatcherHolder* matcher, const Filter* filter);
 	void initParentRelationsIterator(const View& view);
 	void switchToParentRelationsIterator();
+	void fetchNextUnlimited();
 	bool fetchNextParentWay();
 	void fetchNextParentRelation();
 
 	uint_fast8_t type_;
     Feature current_;
+	uint64_t remaining_;		// remaining features allowed by the view's limit
 	union Storage
 	{
 		Query worldQuery;
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <geodesk/feature/TileCache.h>
 #include <geodesk/feature/WayPtr.h>
 
 namespace geodesk {
@@ -25,6 +26,7 @@ private:
     int32_t currentNode_;
     DataPtr p_;
     DataPtr pForeignTile_;
+    TilePin foreignTilePin_;
 };
 
 // \endcond
@@ -3,15 +3,26 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 #ifdef GEODESK_PYTHON
 #include <Python.h>
 #endif
 #include <clarisma/store/BlobStore.h>
-#include <clarisma/thread/ThreadPool.h>
+#include <clarisma/thread/WorkStealingPool.h>
 #include <geodesk/export.h>
+#include <geodesk/feature/FeatureTypes.h>
+#include <geodesk/feature/GolIdentity.h>
+#include <geodesk/feature/IdIndex.h>
 #include <geodesk/feature/Key.h>
 #include <geodesk/feature/StringTable.h>
+#include <geodesk/feature/TileCache.h>
+#include <geodesk/geom/Box.h>
+#include <geodesk/geom/index/MCIndexCache.h>
+#include <geodesk/geom/index/MCIndexFile.h>
+#include <geodesk/geom/polygon/PolygonizerCache.h>
 #include <geodesk/match/Matcher.h>
 #include <geodesk/match/MatcherCompiler.h>
 #include <geodesk/query/TileQueryTask.h>
@@ -22,6 +33,8 @@ namespace geodesk {
 
 class MatcherHolder;
 
+using TileQueryTaskExecutor = clarisma::WorkStealingPool<TileQueryTask>;
+
 //  Possible threadpool alternatives:
 //  - https://github.com/progschj/ThreadPool (Zlib license, header-only)
 
@@ -40,13 +53,61 @@ public:
     FeatureStore();
     ~FeatureStore() override;
 
-    static FeatureStore* openSingle(std::string_view fileName);
+    /// Controls how the GOL is mapped into memory
+    struct MappingPolicy
+    {
+        enum class Access : uint8_t
+        {
+            DEFAULT,        // let the OS decide how much to read ahead
+            RANDOM,         // no read-ahead (best for scattered queries)
+            SEQUENTIAL      // aggressive read-ahead (best for full scans)
+        };
+
+        Access access;
+        bool hugePageIndex;     // back the tile index with huge pages
+        bool populate;          // read the entire file when opening
+    };
+
+    /// The policy in effect, and which of its hints the OS has accepted
+    /// (all hints are best-effort, and Windows accepts none of them).
+    /// Since the GOL is a shared file mapping, the OS may accept a
+    /// request for huge pages without ever using them (most file
+    /// systems can't back file pages with huge pages), hence we only
+    /// report that they have been requested.
+    struct MappingStats
+    {
+        MappingPolicy policy;
+        uint64_t mappedBytes;
+        uint64_t tileIndexBytes;
+        bool accessApplied;
+        bool hugePagesRequested;
+    };
+
+    static constexpr MappingPolicy DEFAULT_MAPPING_POLICY =
+        { MappingPolicy::Access::DEFAULT, false, false };
+
+    /// Opens the given GOL (using DEFAULT_MAPPING_POLICY), or returns
+    /// the already-open instance (whose policy is left unchanged)
+    static FeatureStore* openSingle(std::string_view fileName)
+    {
+        return openSingle(fileName, nullptr);
+    }
+
+    /// Opens the given GOL, or returns the already-open instance
+    /// (in which case `policy` replaces its current policy)
+    static FeatureStore* openSingle(std::string_view fileName,
+        const MappingPolicy& policy)
+    {
+        return openSingle(fileName, &policy);
+    }
 
     void open(const char* fileName)
     {
-        BlobStore::open(fileName, 0);   // TODO: open mode
+        open(fileName, DEFAULT_MAPPING_POLICY);
     }
 
+    void open(const char* fileName, const MappingPolicy& policy);
+
 #ifdef GEODESK_MULTITHREADED
     void addref()
     {
@@ -76,6 +137,7 @@ public:
     const IndexedKeyMap& keysToCategories() const { return keysToCategories_; }
     int getIndexCategory(int keyCode) const;
     const MatcherHolder* getMatcher(const char* query);
+    MatcherCompiler& matchers() { return matchers_; }
 
     const MatcherHolder* borrowAllMatcher() const { return &allMatcher_; }
     const MatcherHolder* getAllMatcher() 
@@ -100,9 +162,88 @@ public:
     PyFeatures* getEmptyFeatures();
     #endif
 
-    clarisma::ThreadPool<TileQueryTask>& executor() { return executor_; }
+    TileQueryTaskExecutor& executor() { return executor_; }
+
+    /// Returns a pointer to the given tile, which is decompressed if
+    /// the GOL stores it in compressed form. A decompressed tile is
+    /// pinned by `pin` (replacing whatever it held before); for an
+    /// uncompressed tile, `pin` is reset.
+    DataPtr fetchTile(Tip tip, TilePin& pin);
 
-    DataPtr fetchTile(Tip tip);
+    TileCache& tileCache() { return tileCache_; }
+
+    /// Returns the identity of the GOL's current contents
+    /// (calculating it requires a pass over the tile index)
+    GolIdentity identity();
+
+    /// Returns the index that maps feature IDs to their locations
+    /// (opening it on first use), or `nullptr` if the GOL has none
+    /// (or if it was built for a different version of the GOL).
+    IdIndex* idIndex();
+
+    /// Creates (or re-creates) the ID index of this GOL, which is
+    /// stored in IdIndex::defaultPath(). Must not be called while
+    /// other threads use the index.
+    void buildIdIndex();
+
+    /// The prepared geometries of features used by spatial filters
+    /// (see PreparedFilterFactory)
+    MCIndexCache& mcIndexCache() { return mcIndexCache_; }
+
+    /// The assembled rings of area relations
+    /// (see PolygonizerCache::rings())
+    PolygonizerCache& polygonizerCache() { return polygonizerCache_; }
+
+    /// Returns the file of pre-built prepared geometries stored next
+    /// to this GOL (see MCIndexFile::defaultPath()), opening it on first
+    /// use, or `nullptr` if there is none (or if it was built for a
+    /// different version of the GOL). Spatial filters take their
+    /// indexes from this file (if present) before building them.
+    MCIndexFile* mcIndexFile();
+
+    /// Asks the OS to start reading the given tile into memory (without
+    /// waiting for the I/O to complete). Failures are ignored, since
+    /// prefetching is merely a hint.
+    void prefetchTile(Tip tip) noexcept;
+
+    /// The number of tiles that queries of this store prefetch ahead
+    /// of the tiles being scanned (see Query::Options::prefetchDistance).
+    /// Off (0) by default; should be set before queries are run.
+    uint32_t prefetchDistance() const noexcept { return prefetchDistance_; }
+    void setPrefetchDistance(uint32_t distance) noexcept { prefetchDistance_ = distance; }
+
+    /// How much of a region's data is held in memory
+    /// (see warm() and residency())
+    struct Residency
+    {
+        uint32_t tileCount;
+        uint64_t totalBytes;        // tiles, tile index and string table
+        uint64_t residentBytes;
+        uint64_t lockedBytes;       // only set by warm()
+    };
+
+    /// Reads the tiles covering the given region (along with the tile
+    /// index and the string table) into memory, using multiple threads,
+    /// and optionally locks them so they can't be paged out.
+    /// Since tiles hold features of all types, `types` only matters
+    /// if it is empty (in which case nothing is read).
+    ///
+    /// @param threadCount  the number of reader threads
+    ///                     (0 = one per core)
+    /// @return the residency after warming (if locking has failed
+    ///   for some of the data, `lockedBytes` is less than `totalBytes`)
+    Residency warm(const Box& box, FeatureTypes types = FeatureTypes::ALL,
+        bool lock = false, int threadCount = 0);
+
+    /// Reports how much of the data covering the given region
+    /// is resident in memory (without reading anything).
+    Residency residency(const Box& box);
+
+    /// Changes the access hints of an open store (if `populate`
+    /// is set, the file is prefetched in the background, since
+    /// it has already been mapped).
+    void setMappingPolicy(const MappingPolicy& policy);
+    MappingStats mappingStats() const { return mappingStats_; }
 
 protected:
     void initialize() override;
@@ -120,10 +261,21 @@ private:
     static const uint32_t STRING_TABLE_PTR_OFS = 52;
     static const uint32_t INDEX_SCHEMA_PTR_OFS = 56;
 
+    static FeatureStore* openSingle(std::string_view fileName,
+        const MappingPolicy* policy);
     void readIndexSchema();
 
     void readTileSchema();
 
+    struct DataRange
+    {
+        const uint8_t* start;
+        uint64_t length;
+    };
+    std::vector<DataRange> dataRanges(const Box& box, uint32_t* pTileCount);
+    void applyMappingPolicy(const MappingPolicy& policy);
+    uint64_t tileIndexSize();
+
     static std::unordered_map<std::string, FeatureStore*>& getOpenStores();
     static std::mutex& getOpenStoresMutex();
 
@@ -146,8 +298,18 @@ private:
         // but PyFeatures requires a non-null MatcherHolder, which in turn
         // requires a FeatureStore
     #endif
-    clarisma::ThreadPool<TileQueryTask> executor_;
+    TileQueryTaskExecutor executor_;
+    TileCache tileCache_;
+    MCIndexCache mcIndexCache_;
+    PolygonizerCache polygonizerCache_;
+    std::mutex idIndexMutex_;
+    std::unique_ptr<IdIndex> idIndex_;
+    bool idIndexChecked_ = false;
+    std::unique_ptr<MCIndexFile> mcIndexFile_;
+    bool mcIndexFileChecked_ = false;
     uint32_t zoomLevels_;
+    uint32_t prefetchDistance_ = 0;
+    MappingStats mappingStats_;
 };
 
 
@@ -5,6 +5,8 @@
 #include <cstdint>
 #include <string>
 #include <geodesk/export.h>
+#include <geodesk/feature/FeaturePtr.h>
+#include <geodesk/feature/FeatureType.h>
 
 namespace geodesk {
 
@@ -18,10 +20,16 @@ class GEODESK_API FeatureUtils
 public:
     static uint64_t count(const View& view);
     static bool isEmpty(const View& view);
+    static double length(const View& view);
+    static double area(const View& view);
     static char* format(char* buf, const char* type, int64_t id);
     static std::string label(const Tags& tags);
+    static FeaturePtr byId(const View& view, FeatureType type, uint64_t id);
+    static void byIds(const View& view, FeatureType type,
+        const uint64_t* ids, size_t count, FeaturePtr* results);
 
 private:
+    static bool accept(const View& view, FeaturePtr feature);
     static uint64_t countWorld(const View& view);
     static uint64_t countGeneric(const View& view);
 };
@@ -3,6 +3,9 @@
 
 #pragma once
 
+#include <optional>
+#include <span>
+#include <vector>
 #include <geodesk/filter/Filters.h>
 #include <geodesk/feature/FeatureUtils.h>
 #include <geodesk/feature/QueryException.h>
@@ -98,11 +101,69 @@ public:
     [[nodiscard]] std::optional<T> first() const;
     [[nodiscard]] T one() const;
 
+    /// @brief Returns the feature with the given type and ID, or
+    /// `std::nullopt` if there is no such feature (or if it does not
+    /// meet the type, tag and spatial constraints of this collection).
+    ///
+    /// @throws QueryException if the GOL has no ID index
+    ///   (see FeatureStore::buildIdIndex()), or if its tiles are
+    ///   compressed and the tile cache has a memory budget (since
+    ///   the tile of the returned feature could then be evicted)
+    ///
+    [[nodiscard]] std::optional<T> byId(FeatureType type, uint64_t id) const;
+
+    /// @brief Looks up features for a batch of IDs (which is faster than
+    /// calling byId() for each, since the lookups are sorted by tile).
+    ///
+    /// @return the features, in the same order as `ids`
+    ///   (`std::nullopt` for IDs that don't have a matching feature)
+    ///
+    /// @throws QueryException under the same conditions as byId()
+    ///
+    [[nodiscard]] std::vector<std::optional<T>> byIds(FeatureType type,
+        std::span<const uint64_t> ids) const;
+
+    /// @brief Returns at most `n` features of this collection.
+    ///
+    /// The result cannot be narrowed further by query, filter or
+    /// bounds (these throw a QueryException); apply them before
+    /// calling limit().
+    ///
+    [[nodiscard]] FeaturesBase limit(uint64_t n) const
+    {
+        return FeaturesBase(view_.withLimit(n));
+    }
+
     // NOLINTNEXTLINE(google-explicit-constructor)
     [[nodiscard]] operator std::vector<T>() const;
 
     void addTo(std::vector<T>& v) const;
 
+    /// @}
+    /// @name Batch queries
+    /// @{
+
+    /// @brief Calls `fn(i, feature)` for each feature whose bounding box
+    /// intersects `boxes[i]`.
+    ///
+    /// This is much faster than querying each box separately: the boxes
+    /// are sorted along a Hilbert curve, and each tile is scanned only
+    /// once (using multiple threads). Results arrive in no particular
+    /// order; `fn` is always called on the calling thread.
+    ///
+    template<typename Fn>
+    void forEachIntersecting(std::span<const Box> boxes, Fn fn) const;
+
+    /// @brief Calls `fn(i, feature)` for each feature whose geometry
+    /// contains `points[i]` (e.g. to find the administrative areas of
+    /// a large set of locations).
+    ///
+    /// @throws QueryException if one or more tiles that contain
+    ///   the geometry of a Relation are missing
+    ///
+    template<typename Fn>
+    void forEachContaining(std::span<const Coordinate> points, Fn fn) const;
+
     /// @}
     /// @name Scalar queries
     /// @{
@@ -124,12 +185,18 @@ public:
     /// @brief Calculates the total length (in meters) of the features
     /// in this collection.
     ///
-    [[nodiscard]] double length() const;
+    [[nodiscard]] double length() const
+    {
+        return FeatureUtils::length(view_);
+    }
 
     /// @brief Calculates the total area (in square meters) of the features
     /// in this collection.
     ///
-    [[nodiscard]] double area() const;
+    [[nodiscard]] double area() const
+    {
+        return FeatureUtils::area(view_);
+    }
 
     FeatureIterator<T> begin() const;
 
@@ -5,6 +5,7 @@
 
 #include <geodesk/feature/FeaturesBase.h>
 #include <geodesk/feature/FeatureIterator.h>
+#include <geodesk/query/BatchQuery.h>
 
 // \cond
 
@@ -49,25 +50,82 @@ template<typename T>
 }
 
 template<typename T>
-void FeaturesBase<T>::addTo(std::vector<T>& v) const
+[[nodiscard]] std::optional<T> FeaturesBase<T>::byId(FeatureType type, uint64_t id) const
 {
-    for(T f: *this) v.push_back(f);
+    FeaturePtr feature = FeatureUtils::byId(view_, type, id);
+    if(feature.isNull()) return std::nullopt;
+    return T(store(), feature);
+}
+
+template<typename T>
+[[nodiscard]] std::vector<std::optional<T>> FeaturesBase<T>::byIds(
+    FeatureType type, std::span<const uint64_t> ids) const
+{
+    std::vector<FeaturePtr> features(ids.size());
+    FeatureUtils::byIds(view_, type, ids.data(), ids.size(), features.data());
+    std::vector<std::optional<T>> results;
+    results.reserve(ids.size());
+    for(FeaturePtr feature : features)
+    {
+        if(feature.isNull())
+        {
+            results.emplace_back(std::nullopt);
+        }
+        else
+        {
+            results.emplace_back(T(store(), feature));
+        }
+    }
+    return results;
+}
+
+// Only a WORLD view can be answered with a single pass over its tiles;
+// the others (which are bounded by a single feature) are cheap enough
+// to query once per probe
+template<typename T>
+template<typename Fn>
+void FeaturesBase<T>::forEachIntersecting(std::span<const Box> boxes, Fn fn) const
+{
+    if(view_.view() == View::WORLD)
+    {
+        BatchQuery query(store(), boxes, view_.types(), view_.matcher(),
+            view_.usesFilter() ? view_.filter() : nullptr);
+        query.run([this, &fn](size_t i, FeaturePtr feature)
+        {
+            fn(i, T(store(), feature));
+        }, view_.bounds());
+        return;
+    }
+    for(size_t i = 0; i < boxes.size(); i++)
+    {
+        for(T feature : (*this)(boxes[i])) fn(i, feature);
+    }
 }
 
 template<typename T>
-[[nodiscard]] double FeaturesBase<T>::area() const
+template<typename Fn>
+void FeaturesBase<T>::forEachContaining(std::span<const Coordinate> points, Fn fn) const
 {
-    double total = 0;
-    for(auto f: *this) total += f.area();
-    return total;
+    if(view_.view() == View::WORLD)
+    {
+        BatchQuery query(store(), points, view_.types(), view_.matcher(),
+            view_.usesFilter() ? view_.filter() : nullptr);
+        query.run([this, &fn](size_t i, FeaturePtr feature)
+        {
+            fn(i, T(store(), feature));
+        }, view_.bounds());
+        return;
+    }
+    for(size_t i = 0; i < points.size(); i++)
+    {
+        for(T feature : containing(points[i])) fn(i, feature);
+    }
 }
 
 template<typename T>
-[[nodiscard]] double FeaturesBase<T>::length() const
+void FeaturesBase<T>::addTo(std::vector<T>& v) const
 {
-    double total = 0;
-    for(auto f: *this) total += f.length();
-    return total;
+    for(T f: *this) v.push_back(f);
 }
 
 template<typename T>
@@ -0,0 +1,33 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+
+namespace geodesk {
+
+/// \cond lowlevel
+
+/// Identifies the contents of a GOL. Files that are derived from a GOL
+/// (such as its IdIndex or an MCIndexFile) record the identity of the
+/// GOL from which they were built, so they can be rejected once the
+/// GOL has been rebuilt or updated (see FeatureStore::identity()).
+///
+/// A rebuilt GOL has a different creation timestamp; an update writes
+/// the modified tiles to new pages, which changes the tile index.
+///
+struct GolIdentity
+{
+    uint64_t creationTimestamp;
+    uint32_t totalPageCount;
+    uint32_t tileIndexChecksum;     // CRC-32 of the tile index
+
+    bool operator==(const GolIdentity& other) const = default;
+};
+
+static_assert(sizeof(GolIdentity) == 16, "GolIdentity is written to files as-is");
+
+// \endcond
+
+} // namespace geodesk
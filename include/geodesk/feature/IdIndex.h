@@ -0,0 +1,94 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <string>
+#include <clarisma/store/IndexFile.h>
+#include <geodesk/feature/FeatureType.h>
+#include <geodesk/feature/GolIdentity.h>
+#include <geodesk/feature/Tip.h>
+
+namespace geodesk {
+
+class FeatureStore;
+
+/// \cond lowlevel
+
+/// A persistent index that maps the IDs of a GOL's features to their
+/// locations (the TIP of their tile, and their offset within it).
+///
+/// The index lives in a directory next to the GOL, which contains
+/// a pair of IndexFile instances for each feature type: one holds the
+/// TIPs (24 bits), the other the offsets (in units of 4 bytes, also
+/// 24 bits, which limits tiles to 64 MB). Since an offset is never 0,
+/// a zero offset indicates that the ID is not present. The files are
+/// sparse, so unused ID ranges take up no disk space.
+///
+/// A feature that lives in more than one tile is recorded only
+/// for the first tile in which it is found.
+///
+/// The directory also holds the GolIdentity of the GOL for which the
+/// index was built (written last, so an incomplete index is never
+/// used); an index whose identity doesn't match is not opened.
+///
+/// Lookups are thread-safe.
+///
+class IdIndex
+{
+public:
+    struct Location
+    {
+        Tip tip;
+        uint32_t offset;        // relative to the start of the tile
+
+        bool isNull() const noexcept { return offset == 0; }
+    };
+
+    IdIndex() = default;
+    IdIndex(const IdIndex&) = delete;
+    IdIndex& operator=(const IdIndex&) = delete;
+
+    /// Opens the index in the given directory (read-only), unless
+    /// it was built for a GOL other than `identity`, in which case
+    /// `false` is returned. Throws FileNotFoundException if the
+    /// index does not exist.
+    bool open(const std::string& path, const GolIdentity& identity);
+
+    Location get(FeatureType type, uint64_t id)
+    {
+        int t = static_cast<int>(type);
+        uint32_t offset = offsets_[t].tryGet(id);
+        if (offset == 0) return { Tip(), 0 };
+        return { Tip(tips_[t].tryGet(id)), offset << 2 };
+    }
+
+    /// Creates the index for all features in the given store,
+    /// replacing any existing index files in `path`.
+    static void build(FeatureStore* store, const std::string& path,
+        const GolIdentity& identity);
+
+    /// The path of the directory that holds the index
+    /// of the given GOL file (`foo.gol` -> `foo.idx`)
+    static std::string defaultPath(const std::string& golFileName);
+
+    static const int MAX_TILE_SIZE = 64 * 1024 * 1024;
+
+private:
+    void open(const std::string& path, int mode);
+    void put(FeatureType type, uint64_t id, Location loc);
+    void indexTile(Tip tip, const uint8_t* pTile);
+    void indexRoot(Tip tip, const uint8_t* pTile, const uint8_t* ppRoot, bool nodes);
+    void indexBranch(Tip tip, const uint8_t* pTile, const uint8_t* p, bool nodes);
+    void indexLeaf(Tip tip, const uint8_t* pTile, const uint8_t* p, bool nodes);
+
+    static const char* const FILE_NAMES[3];
+    static const char* const IDENTITY_FILE_NAME;
+
+    clarisma::IndexFile tips_[3];
+    clarisma::IndexFile offsets_[3];
+};
+
+// \endcond
+
+} // namespace geodesk
@@ -6,6 +6,7 @@
 #include <clarisma/util/ShortVarString.h>
 #include <geodesk/feature/FeaturePtr.h>
 #include <geodesk/feature/FeatureStore.h>
+#include <geodesk/feature/TileCache.h>
 
 namespace geodesk {
 
@@ -46,6 +47,11 @@ public:
 	}
 	Tip currentTip() const { return currentTip_; }
 
+	/// The pin that keeps the tile of the current foreign member in
+	/// memory (a copy keeps the member valid after the iterator
+	/// has moved on to another tile)
+	const TilePin& currentTilePin() const { return foreignTilePin_; }
+
 	std::string_view currentRole() const
 	{
 		if (currentRoleCode_ >= 0)
@@ -124,6 +130,7 @@ private:
 	const Matcher* currentMatcher_;
 	DataPtr p_;
 	DataPtr pForeignTile_;
+	TilePin foreignTilePin_;
 };
 
 // \endcond
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <geodesk/feature/RelationPtr.h>
+#include <geodesk/feature/TileCache.h>
 
 namespace geodesk {
 
@@ -26,6 +27,7 @@ private:
 	int32_t currentRel_;
 	DataPtr p_;
 	DataPtr pForeignTile_;
+	TilePin foreignTilePin_;
 };
 
 // \endcond
@@ -68,6 +68,14 @@ public:
 #endif
 
     uint32_t stringCount() const { return stringCount_; }
+    /// The encoded strings, as stored in the GOL
+    const uint8_t* data() const { return stringBase_; }
+    size_t dataSize() const noexcept
+    {
+        if (stringCount_ <= 1) return 1;    // only the count
+        const clarisma::ShortVarString* last = getGlobalString(stringCount_ - 1);
+        return reinterpret_cast<const uint8_t*>(last) + last->totalSize() - stringBase_;
+    }
 
     enum Constant
     {
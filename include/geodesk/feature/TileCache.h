@@ -0,0 +1,197 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <clarisma/util/DataPtr.h>
+#include <geodesk/feature/Tip.h>
+
+namespace geodesk {
+
+using clarisma::DataPtr;
+
+class TileCache;
+
+/// \cond lowlevel
+
+/// Keeps a decompressed tile in a TileCache from being evicted.
+/// A default-constructed (or reset) pin holds nothing, which is
+/// also the case for tiles that are stored uncompressed.
+///
+class TilePin
+{
+public:
+    TilePin() noexcept : entry_(nullptr) {}
+    TilePin(const TilePin& other) noexcept : entry_(other.entry_)
+    {
+        if (entry_) addref(entry_);
+    }
+    TilePin(TilePin&& other) noexcept : entry_(other.entry_)
+    {
+        other.entry_ = nullptr;
+    }
+    ~TilePin() { reset(); }
+
+    TilePin& operator=(const TilePin& other) noexcept
+    {
+        if (other.entry_) addref(other.entry_);
+        reset();
+        entry_ = other.entry_;
+        return *this;
+    }
+
+    TilePin& operator=(TilePin&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            entry_ = other.entry_;
+            other.entry_ = nullptr;
+        }
+        return *this;
+    }
+
+    void reset() noexcept
+    {
+        if (entry_)
+        {
+            release(entry_);
+            entry_ = nullptr;
+        }
+    }
+
+    bool isEmpty() const noexcept { return entry_ == nullptr; }
+
+private:
+    struct Entry;
+
+    static void addref(Entry* entry) noexcept;
+    static void release(Entry* entry) noexcept;
+
+    Entry* entry_;
+
+    friend class TileCache;
+};
+
+
+/// A cache of decompressed tiles for GOLs whose tiles are stored
+/// in compressed form (tiles that are not compressed are accessed
+/// directly via the file mapping and never enter the cache).
+///
+/// A compressed tile blob starts with the usual 4-byte header (the
+/// length of the blob's payload, with COMPRESSED_FLAG set), followed
+/// by the length of the uncompressed tile payload and an LZ4 block.
+/// Once decompressed, the tile has the same layout as an uncompressed
+/// tile blob, so it can be read by the same code.
+///
+/// The cache is split into shards (by TIP) to reduce lock contention.
+/// If the total size of the decompressed tiles exceeds the memory
+/// budget, tiles are evicted using the CLOCK algorithm (tiles that
+/// have been accessed since the last sweep get a second chance).
+/// Tiles that are pinned are never evicted; since features obtained
+/// from a tile refer to its memory, a tile must stay pinned for as
+/// long as its features are in use. (Queries and feature iterators
+/// hold pins while their results are being consumed, but not beyond.
+/// Applications that hold on to features should leave the budget
+/// unlimited, which is the default.)
+///
+/// This class is thread-safe.
+///
+class TileCache
+{
+public:
+    static constexpr uint32_t COMPRESSED_FLAG = 0x4000'0000;
+    static constexpr uint64_t UNLIMITED = 0;
+
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t tileCount;
+        uint64_t bytes;         // decompressed size of the cached tiles
+        uint64_t budget;
+    };
+
+    TileCache();
+    ~TileCache();
+
+    TileCache(const TileCache&) = delete;
+    TileCache& operator=(const TileCache&) = delete;
+
+    static bool isCompressed(DataPtr pBlob)
+    {
+        return pBlob.getUnsignedInt() & COMPRESSED_FLAG;
+    }
+
+    /// Returns the decompressed contents of the given compressed
+    /// tile blob, and pins it (replacing whatever `pin` held before).
+    /// Throws Lz4Exception if the blob is corrupt.
+    DataPtr fetch(Tip tip, DataPtr pBlob, TilePin& pin);
+
+    /// Sets the maximum total size of the decompressed tiles
+    /// (UNLIMITED disables eviction). The budget may be exceeded
+    /// temporarily if too many tiles are pinned.
+    void setBudget(uint64_t bytes);
+    uint64_t budget() const noexcept { return budget_.load(std::memory_order_relaxed); }
+    void clear();
+    Stats stats();
+
+    static constexpr int SHARD_COUNT = 16;
+
+private:
+    using Entry = TilePin::Entry;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<uint32_t, Entry*> entries;
+        std::vector<Entry*> clock;
+        size_t hand = 0;
+        uint64_t bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    Shard& shardOf(Tip tip)
+    {
+        // Adjacent tiles are often used together, so we spread them
+        static_assert(SHARD_COUNT == 16);
+        return shards_[(static_cast<uint32_t>(tip) * 0x9E37'79B1u) >> 28];
+    }
+
+    void evict(Shard& shard, uint64_t maxBytes);     // requires lock
+
+    Shard shards_[SHARD_COUNT];
+    std::atomic<uint64_t> budget_;
+};
+
+struct TilePin::Entry
+{
+    std::atomic<int32_t> pins;
+    std::atomic<bool> referenced;
+    uint32_t tip;
+    uint32_t size;          // size of the decompressed tile blob
+    std::unique_ptr<uint8_t[]> data;
+};
+
+inline void TilePin::addref(Entry* entry) noexcept
+{
+    entry->pins.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void TilePin::release(Entry* entry) noexcept
+{
+    entry->pins.fetch_sub(1, std::memory_order_release);
+}
+
+// \endcond
+
+} // namespace geodesk
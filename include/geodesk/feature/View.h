@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <geodesk/filter/ComboFilter.h>
 #include <geodesk/feature/QueryException.h>
 #include <geodesk/feature/FeatureStore.h>
@@ -61,9 +62,12 @@ public:
         PARENTS
     };
 
+    static constexpr uint64_t UNLIMITED = UINT64_MAX;
+
     explicit View(FeatureStore* store) :
         view_(EMPTY), flags_(0), types_(0), store_(store),
-        matcher_(store->getAllMatcher()), filter_(nullptr)
+        matcher_(store->getAllMatcher()), filter_(nullptr),
+        limit_(UNLIMITED)
     {
         store->addref();
         // TODO: this differs from other cons that steal the ref
@@ -72,34 +76,34 @@ public:
 
     // steals references
     View(int view, int flags, FeatureTypes types, FeatureStore* store, const Context& context,
-        const MatcherHolder* matcher, const Filter* filter) :
+        const MatcherHolder* matcher, const Filter* filter, uint64_t limit = UNLIMITED) :
         view_(view), flags_(flags), types_(types), store_(store), 
-        context_(context), matcher_(matcher), filter_(filter)
+        matcher_(matcher), filter_(filter), context_(context), limit_(limit)
     {
         //printf("Creating view, store refcount = %llu\n", store_->refcount());
         //fflush(stdout);
     }
 
     View(int view, int flags, FeatureTypes types, FeatureStore* store, const Box& bounds,
-        const MatcherHolder* matcher, const Filter* filter) :
+        const MatcherHolder* matcher, const Filter* filter, uint64_t limit = UNLIMITED) :
         view_(view), flags_(flags | USES_BOUNDS), types_(types), store_(store),
-        matcher_(matcher), filter_(filter)
+        matcher_(matcher), filter_(filter), limit_(limit)
     {
         context_.bounds = { bounds.minX(), bounds.minY(), bounds.maxX(), bounds.maxY() };
     }
 
     View(int view, int flags, FeatureTypes types, FeatureStore* store, FeaturePtr related,
-        const MatcherHolder* matcher, const Filter* filter) :
+        const MatcherHolder* matcher, const Filter* filter, uint64_t limit = UNLIMITED) :
         view_(view), flags_(flags), types_(types), store_(store),
-        matcher_(matcher), filter_(filter)
+        matcher_(matcher), filter_(filter), limit_(limit)
     {
         context_.relatedFeature = related.ptr();
     }
 
     View(int view, int flags, FeatureTypes types, FeatureStore* store, Coordinate anonNode,
-        const MatcherHolder* matcher, const Filter* filter) :
+        const MatcherHolder* matcher, const Filter* filter, uint64_t limit = UNLIMITED) :
         view_(view), flags_(flags), types_(types), store_(store),
-        matcher_(matcher), filter_(filter)
+        matcher_(matcher), filter_(filter), limit_(limit)
     {
         context_.relatedFeature = nullptr;
         context_.relatedNodeX = anonNode.x;
@@ -109,7 +113,7 @@ public:
 
     View(const View& other) :
         View(other.view_, other.flags_, other.types_, other.store_,
-            other.context_, other.matcher_, other.filter_)
+            other.context_, other.matcher_, other.filter_, other.limit_)
     {
         // printf("Creating copy of view, store refcount before = %llu\n", store_->refcount());
         // fflush(stdout);
@@ -148,6 +152,7 @@ public:
             store_ = other.store_;
         }
         context_ = other.context_;
+        limit_ = other.limit_;
         if(matcher_ != other.matcher_)
         {
             matcher_->release();
@@ -202,7 +207,7 @@ public:
         matcher_->addref();
         store_->addref();
         if(filter_) filter_->addref();
-        return { WAY_NODES, flags_, types, store_, way, matcher_, filter_ };
+        return { WAY_NODES, flags_, types, store_, way, matcher_, filter_, limit_ };
     }
 
     // TODO: guard against empty relations
@@ -222,7 +227,7 @@ public:
         matcher_->addref();
         store_->addref();
         if(filter_) filter_->addref();
-        return { MEMBERS, flags_, types_, store_, rel, matcher_, filter_ };
+        return { MEMBERS, flags_, types_, store_, rel, matcher_, filter_, limit_ };
     }
 
     View parentWaysOf(Coordinate anonNode) const
@@ -241,7 +246,7 @@ public:
         store_->addref();
         if(filter_) filter_->addref();
         return { PARENTS, flags_, types,
-            store_, anonNode, matcher_, filter_ };
+            store_, anonNode, matcher_, filter_, limit_ };
     }
 
     View parentsOf(FeaturePtr feature) const
@@ -272,7 +277,7 @@ public:
         matcher_->addref();
         store_->addref();
         if(filter_) filter_->addref();
-        return { PARENTS, flags_, types, store_, feature, matcher_, filter_ };
+        return { PARENTS, flags_, types, store_, feature, matcher_, filter_, limit_ };
     }
 
     static View parentWaysOf(FeatureStore* store, Coordinate anonNode, const char* query = nullptr)
@@ -327,6 +332,10 @@ public:
         return Coordinate(context_.relatedNodeX, context_.relatedNodeY);
     }
 
+    /// The maximum number of features in this view (or UNLIMITED)
+    uint64_t limit() const noexcept { return limit_; }
+    bool isLimited() const noexcept { return limit_ != UNLIMITED; }
+
     bool usesMatcher() const noexcept
     {
         return flags_ & USES_MATCHER;
@@ -369,7 +378,7 @@ public:
         store_->addref();
         matcher_->addref();
         if (filter_) filter_->addref();
-        return View(view_, flags_, types, store_, context_, matcher_, filter_);
+        return View(view_, flags_, types, store_, context_, matcher_, filter_, limit_);
     }
 
     View withQuery(const char* query, FeatureTypes newTypes = FeatureTypes::ALL) const
@@ -377,6 +386,7 @@ public:
         // TODO: Turn ParseException into QueryException
         //try
         //{
+            checkNotLimited();
             const MatcherHolder* newMatcher = store_->getMatcher(query);
             newTypes &= types_ & newMatcher->acceptedTypes();
             if (newTypes == 0)
@@ -394,7 +404,7 @@ public:
             if (filter_) filter_->addref();     
             store_->addref();
             return View(view_, flags_ | USES_MATCHER, newTypes, store_,
-                context_, newMatcher, filter_);
+                context_, newMatcher, filter_, limit_);
         // }
         /*
         catch (const ParseException& ex)
@@ -408,6 +418,11 @@ public:
 
     View withFilter(const Filter* newFilter) const
     {
+        if (isLimited())
+        {
+            newFilter->release();   // consumed even if we fail
+            checkNotLimited();
+        }
         if (filter_)
         {
             const ComboFilter* combo = new ComboFilter(filter_, newFilter);
@@ -436,14 +451,15 @@ public:
             Context ctx;
             ctx.bounds = { b.minX(), b.minY(), b.maxX(), b.maxY() };
             return View(view_, flags_ | USES_FILTER, newTypes, store_,
-                ctx, matcher_, newFilter);
+                ctx, matcher_, newFilter, limit_);
         }
         return View(view_, flags_ | USES_FILTER, newTypes, store_,
-            context_, matcher_, newFilter);
+            context_, matcher_, newFilter, limit_);
     }
 
     View withBounds(Box box) const
     {
+        checkNotLimited();
         if (box.isEmpty()) return empty();
         if (flags_ & USES_BOUNDS)
         {
@@ -455,13 +471,14 @@ public:
             matcher_->addref();
             if(filter_) filter_->addref();
             store_->addref();
-            return View(view_, flags_ | BOUNDS_ACTIVE, types_, store_, box, matcher_, filter_);
+            return View(view_, flags_ | BOUNDS_ACTIVE, types_, store_, box, matcher_, filter_, limit_);
         }
         throw QueryException("Not yet implented");
     }
 
     View withBounds(Coordinate xy) const
     {
+        checkNotLimited();
         if (flags_ & USES_BOUNDS)
         {
             if (flags_ & BOUNDS_ACTIVE)
@@ -471,7 +488,7 @@ public:
             matcher_->addref();
             if(filter_) filter_->addref();
             store_->addref();
-            return View(view_, flags_ | BOUNDS_ACTIVE, types_, store_, Box(xy), matcher_, filter_);
+            return View(view_, flags_ | BOUNDS_ACTIVE, types_, store_, Box(xy), matcher_, filter_, limit_);
         }
         throw QueryException("Not yet implented");
     }
@@ -487,7 +504,7 @@ public:
         if(filter_) filter_->addref();
         store_->addref();
         return View(view, flags_ & ~(USES_BOUNDS | BOUNDS_ACTIVE), types, store_,
-            related, matcher_, filter_);
+            related, matcher_, filter_, limit_);
     }
 
     /*
@@ -504,6 +521,30 @@ public:
     }
 
 
+    /// A limited view selects its first `limit` features, so narrowing
+    /// it afterwards (by query, filter or bounds) would have to pick from
+    /// these features only, rather than yield the first `limit` features
+    /// that pass the new criteria. We don't support that (apply limit()
+    /// last instead).
+    void checkNotLimited() const
+    {
+        if (isLimited())
+        {
+            throw QueryException("Cannot narrow a limited set of features "
+                "(apply limit() last)");
+        }
+    }
+
+    View withLimit(uint64_t limit) const
+    {
+        if (limit == 0) return empty();
+        store_->addref();
+        matcher_->addref();
+        if (filter_) filter_->addref();
+        return View(view_, flags_, types_, store_, context_, matcher_, filter_,
+            std::min(limit, limit_));
+    }
+
     View empty() const
     {
         store_->addref();
@@ -519,6 +560,7 @@ private:
     const MatcherHolder* matcher_;
     const Filter* filter_;
     Context context_;
+    uint64_t limit_;
 };
 
 // \endcond lowlevel
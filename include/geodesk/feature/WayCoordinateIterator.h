@@ -14,6 +14,9 @@ namespace geodesk {
 class WayCoordinateIterator
 {
 public:
+    /// A block size that suits most callers of nextBlock()
+    static constexpr int BLOCK_SIZE = 64;
+
     WayCoordinateIterator() {};
     explicit WayCoordinateIterator(WayPtr way);
 
@@ -25,6 +28,15 @@ public:
     void start(FeaturePtr way, int flags);
     Coordinate next();
 
+    /// Decodes up to `maxCount` coordinates into `buf` (including the
+    /// duplicated first coordinate of an area, just like next()).
+    /// Calls to next() and nextBlock() can be freely mixed.
+    ///
+    /// @return the number of coordinates decoded (less than
+    ///   `maxCount` once the end of the way has been reached)
+    ///
+    int nextBlock(Coordinate* buf, int maxCount);
+
     // does not include any duplicated last coordinate
     int storedCoordinatesRemaining() const { return remaining_; }
     // This one includes any duplicate last coordinate for areas, based on flags:
@@ -34,6 +46,8 @@ public:
     }
 
 private:
+    void decodeBlock(Coordinate* out, int count);
+
     const uint8_t* p_;
     int remaining_;
     bool duplicateFirst_;
@@ -18,6 +18,7 @@ public:
 
     bool accept(FeatureStore* store, FeaturePtr feature, FastFilterHint fast) const override;
     int acceptTile(Tile tile) const override;
+    int acceptBranch(const Box& bounds) const override;
 
 private:
     void add(const Filter* f);
@@ -13,15 +13,16 @@ namespace geodesk {
 class CrossesFilter : public PreparedSpatialFilter
 {
 public:
-	CrossesFilter(FeatureTypes accepted, const Box& bounds, MCIndex&& index) :
+	CrossesFilter(FeatureTypes accepted, const Box& bounds, MCIndexCache::Handle index) :
 		PreparedSpatialFilter(bounds, std::move(index)) 
 	{
-		flags_ |= FilterFlags::FAST_TILE_FILTER;
+		flags_ |= FilterFlags::FAST_TILE_FILTER | FilterFlags::FAST_BRANCH_FILTER;
 		acceptedTypes_ = accepted;
 	}
 
 	bool accept(FeatureStore* store, FeaturePtr feature, FastFilterHint fast) const override;
 	int acceptTile(Tile tile) const override;
+	int acceptBranch(const Box& bounds) const override;
 
 protected:
 	bool acceptWay(WayPtr way) const override;
@@ -54,6 +54,23 @@ enum FilterFlags
      * must be accepted by this filter in order for the filter to match.
      */
     MUST_ACCEPT_ALL_MEMBERS = 32,
+
+    /**
+     * Given the bounding box of a branch in a tile's spatial index, the
+     * Filter is able to reject all features in the branch, or accept
+     * all of them without testing each.
+     *
+     * If set, `Filter` must implement `acceptBranch()`
+     */
+    FAST_BRANCH_FILTER = 64,
+
+    /**
+     * The Filter is able to test a batch of nodes more cheaply than
+     * testing each node on its own.
+     *
+     * If set, `Filter` must implement `acceptNodes()`
+     */
+    BATCH_NODE_FILTER = 128,
 };
 
 
@@ -101,6 +118,33 @@ public:
         return 0;
     }
 
+    /**
+     * Classifies the features in an index branch with the given
+     * bounding box (which encloses the bounding boxes of all of them).
+     * Returns:
+     *  0 if each feature must be tested
+     *  1 if all features are accepted
+     * -1 if all features are rejected
+     */
+    virtual int acceptBranch(const Box& bounds) const
+    {
+        return 0;
+    }
+
+    /**
+     * Tests a batch of nodes, with the same results as calling
+     * accept() for each, and stores the outcome for each node
+     * in `accepted`.
+     */
+    virtual void acceptNodes(FeatureStore* store, const FeaturePtr* nodes,
+        int count, FastFilterHint fast, bool* accepted) const
+    {
+        for (int i = 0; i < count; i++)
+        {
+            accepted[i] = accept(store, nodes[i], fast);
+        }
+    }
+
 protected:
     int flags_;
 	FeatureTypes acceptedTypes_;
@@ -18,14 +18,15 @@ namespace geodesk {
 class IntersectsPolygonFilter : public PreparedSpatialFilter
 {
 public:
-	IntersectsPolygonFilter(const Box& bounds, MCIndex&& index) :
+	IntersectsPolygonFilter(const Box& bounds, MCIndexCache::Handle index) :
 		PreparedSpatialFilter(bounds, std::move(index))
 	{
-		flags_ |= FilterFlags::FAST_TILE_FILTER;
+		flags_ |= FilterFlags::FAST_TILE_FILTER | FilterFlags::FAST_BRANCH_FILTER;
 	}
 
 	bool accept(FeatureStore* store, FeaturePtr feature, FastFilterHint fast) const override;
 	int acceptTile(Tile tile) const override;
+	int acceptBranch(const Box& bounds) const override;
 
 protected:
 	bool acceptWay(WayPtr way) const override;
@@ -37,10 +38,15 @@ protected:
 class IntersectsLinealFilter : public PreparedSpatialFilter
 {
 public:
-	IntersectsLinealFilter(const Box& bounds, MCIndex&& index) :
-		PreparedSpatialFilter(bounds, std::move(index)) {}
+	IntersectsLinealFilter(const Box& bounds, MCIndexCache::Handle index) :
+		PreparedSpatialFilter(bounds, std::move(index))
+	{
+		flags_ |= FilterFlags::FAST_TILE_FILTER | FilterFlags::FAST_BRANCH_FILTER;
+	}
 
 	bool accept(FeatureStore* store, FeaturePtr feature, FastFilterHint fast) const override;
+	int acceptTile(Tile tile) const override;
+	int acceptBranch(const Box& bounds) const override;
 
 protected:
 	bool acceptWay(WayPtr way) const override;
@@ -18,6 +18,8 @@ public:
 	PointDistanceFilter(double meters, Coordinate point);
 
 	virtual bool accept(FeatureStore* store, FeaturePtr feature, FastFilterHint fast) const;
+	int acceptTile(Tile tile) const override;
+	int acceptBranch(const Box& bounds) const override;
 
 private:
 	bool segmentsWithinDistance(WayPtr way, int areaFlag) const;
@@ -8,6 +8,7 @@
 #endif
 #include <geodesk/feature/RelationPtr.h>
 #include <geodesk/geom/index/MCIndexBuilder.h>
+#include <geodesk/geom/index/MCIndexCache.h>
 
 namespace geodesk {
 
@@ -23,7 +24,10 @@ public:
 	virtual const Filter* forCoordinate(Coordinate point) { return nullptr; };
 
 	const Box& bounds() const { return bounds_; }
-	MCIndex buildIndex() { return indexBuilder_.build(bounds_); }
+
+	/// Returns the index of the geometry (which for features is
+	/// taken from, or added to, the store's MCIndexCache)
+	MCIndexCache::Handle buildIndex();
 
 protected:
 	virtual const Filter* forPolygonal() { return nullptr; };
@@ -46,8 +50,13 @@ protected:
 	#endif
 
 private:
+	bool useCachedIndex(FeatureStore* store, FeaturePtr feature);
+
 	Box bounds_;
 	MCIndexBuilder indexBuilder_;
+	MCIndexCache* cache_ = nullptr;		// only used for features
+	int64_t cacheKey_ = 0;
+	MCIndexCache::Handle cachedIndex_;
 };
 
 } // namespace geodesk
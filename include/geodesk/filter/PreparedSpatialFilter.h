@@ -4,7 +4,7 @@
 #pragma once
 
 #include <geodesk/filter/SpatialFilter.h>
-#include <geodesk/geom/index/MCIndex.h>
+#include <geodesk/geom/index/MCIndexCache.h>
 
 namespace geodesk {
 
@@ -14,9 +14,10 @@ namespace geodesk {
 class PreparedSpatialFilter : public SpatialFilter
 {
 public:
-	PreparedSpatialFilter(const Box& bounds, MCIndex&& index) :
+	PreparedSpatialFilter(const Box& bounds, MCIndexCache::Handle index) :
 		SpatialFilter(bounds),
-		index_(std::move(index))
+		preparedIndex_(std::move(index)),
+		index_(*preparedIndex_)
 	{
 	}
 
@@ -27,6 +28,7 @@ protected:
 	bool anySegmentsCross(WayPtr way) const;
 	bool wayIntersectsPolygon(WayPtr way) const;
 
-	MCIndex index_;
+	MCIndexCache::Handle preparedIndex_;	// may be shared with other filters
+	const MCIndex& index_;
 };
 } // namespace geodesk
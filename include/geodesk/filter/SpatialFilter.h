@@ -30,6 +30,21 @@ public:
 
 protected:
     bool acceptFeature(FeatureStore* store, FeaturePtr feature) const;
+
+    /// Checks whether the bounding box of a feature (found in the given
+    /// tile) lies entirely within the tile. If the tile has been accepted
+    /// in its entirety by acceptTile(), such a feature can be accepted
+    /// without testing its geometry.
+    static bool liesWithinTile(FeaturePtr feature, const Tile& tile)
+    {
+        if (feature.isNode()) return true;
+        // A feature that does not extend into the tiles to the
+        // north or west can only cross the tile's south or east edge
+        return (feature.flags() &
+            (FeatureFlags::MULTITILE_NORTH | FeatureFlags::MULTITILE_WEST)) == 0 &&
+            feature.minY() >= tile.bottomY() &&
+            feature.maxX() <= tile.rightX();
+    }
     
     virtual bool acceptWay(WayPtr way) const { return false; }
     virtual bool acceptNode(NodePtr node) const { return false; }
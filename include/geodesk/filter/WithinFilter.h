@@ -14,11 +14,13 @@ namespace geodesk {
 class WithinPolygonFilter : public PreparedSpatialFilter
 {
 public:
-	WithinPolygonFilter(const Box& bounds, MCIndex&& index) :
+	WithinPolygonFilter(const Box& bounds, MCIndexCache::Handle index) :
 		PreparedSpatialFilter(bounds, std::move(index)) 
 	{
 		flags_ |= 
 			FilterFlags::FAST_TILE_FILTER |
+			FilterFlags::FAST_BRANCH_FILTER |
+			FilterFlags::BATCH_NODE_FILTER |
 			FilterFlags::MUST_ACCEPT_ALL_MEMBERS | 
 			FilterFlags::STRICT_BBOX;
 	}
@@ -26,12 +28,16 @@ public:
 	WithinPolygonFilter(FeatureStore* store, RelationPtr areaRelation) :
 		PreparedSpatialFilter(
 			areaRelation.bounds(),
-			MCIndexBuilder::buildFromAreaRelation(store, areaRelation))
+			std::make_shared<const MCIndex>(
+				MCIndexBuilder::buildFromAreaRelation(store, areaRelation)))
 	{
 	}
 
 	bool accept(FeatureStore* store, FeaturePtr feature, FastFilterHint fast) const override;
 	int acceptTile(Tile tile) const override;
+	int acceptBranch(const Box& bounds) const override;
+	void acceptNodes(FeatureStore* store, const FeaturePtr* nodes,
+		int count, FastFilterHint fast, bool* accepted) const override;
 	
 protected:
 	bool acceptWay(WayPtr way) const override;
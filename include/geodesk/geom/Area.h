@@ -21,14 +21,23 @@ public:
      * Returns the signed area (in squared Mercator units)
      * of the given way; assumes that way is an area.
      * (This function is useful for getting the winding order)
+     * Unless `exact` is `false`, the terms are summed in their
+     * original order (see GeodesicKernels).
      */
-    static double signedMercatorOfWay(WayPtr way);
+    static double signedMercatorOfWay(WayPtr way, bool exact = true);
     static double signedMercatorOfRing(const Polygonizer::Ring* ring);
-    static double ofWay(WayPtr way)
+    /**
+     * Returns the signed area (in squared Mercator units) of the ring
+     * formed by the given coordinates (the last of which must be
+     * the same as the first).
+     */
+    static double signedMercatorOfRing(const Coordinate* coords, int count,
+        bool exact = true);
+    static double ofWay(WayPtr way, bool exact = true)
 	{
         int32_t avgY = clarisma::Math::avg(way.minY(), way.maxY());
         double scale = Mercator::metersPerUnitAtY(avgY);
-		return std::abs(signedMercatorOfWay(way)) * scale * scale;
+		return std::abs(signedMercatorOfWay(way, exact)) * scale * scale;
 	}
     static double mercatorOfRing(const Polygonizer::Ring* ring)
     {
@@ -49,12 +49,10 @@ private:
 				x1 = x2;
 				y1 = y2;
 			}
-			double sign = (ringSum >= 0 && isShell) ? 1.0 : -1.0;
-			areaSum_ += ringSum * sign;
-			areaCentroidX_ += ringCentroidX * sign;
-			areaCentroidY_ += ringCentroidY * sign;
+			addRingTerms(ringSum, ringCentroidX, ringCentroidY, isShell);
 		}
 
+		void addWayRing(WayPtr way);
 		void addAreaRelation(FeatureStore* store, RelationPtr relation);
 		bool isEmpty() const { return areaSum_ == 0; }
 		Coordinate centroid() const
@@ -65,6 +63,15 @@ private:
 		}
 
 	private:
+		void addRingTerms(double ringSum, double ringCentroidX,
+			double ringCentroidY, bool isShell)
+		{
+			double sign = (ringSum >= 0 && isShell) ? 1.0 : -1.0;
+			areaSum_ += ringSum * sign;
+			areaCentroidX_ += ringCentroidX * sign;
+			areaCentroidY_ += ringCentroidY * sign;
+		}
+
 		double areaSum_;
 		double areaCentroidX_;
 		double areaCentroidY_;
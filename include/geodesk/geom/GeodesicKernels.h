@@ -0,0 +1,119 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <geodesk/export.h>
+#include <geodesk/geom/Coordinate.h>
+#include <geodesk/geom/Mercator.h>
+
+namespace geodesk {
+
+/// \cond lowlevel
+
+/// Approximates Mercator::metersPerUnitAtY() within a band of
+/// Y-coordinates by a quadratic polynomial, so the meters covered
+/// by a segment can be calculated without a `cosh` per segment.
+/// Within MAX_HALF_SPAN of the band's center, the relative error
+/// is less than 1e-9.
+///
+class LocalMercatorScale
+{
+public:
+    /// About 9 km at the equator
+    static constexpr double MAX_HALF_SPAN = 1'000'000;
+
+    explicit LocalMercatorScale(double centerY) noexcept
+    {
+        // 1/cosh(k * (c + d)) ~= s * (1 - t*kd + (2t^2 - 1)/2 * (kd)^2),
+        // with s = 1/cosh(kc) and t = tanh(kc)
+        constexpr double k = 2.0 * M_PI / Mercator::MAP_WIDTH;
+        double s = Mercator::metersPerUnitAtY(centerY);
+        double t = std::tanh(k * centerY);
+        center_ = centerY;
+        c0_ = s;
+        c1_ = -s * t * k;
+        c2_ = s * (2 * t * t - 1) / 2 * k * k;
+    }
+
+    /// Checks whether a band that spans the given Y-coordinates
+    /// is narrow enough for the approximation
+    static bool covers(int32_t minY, int32_t maxY) noexcept
+    {
+        return static_cast<double>(maxY) - minY <= 2 * MAX_HALF_SPAN;
+    }
+
+    double metersPerUnitAtY(double y) const noexcept
+    {
+        double d = y - center_;
+        return c0_ + d * (c1_ + d * c2_);
+    }
+
+    double center() const noexcept { return center_; }
+    double c0() const noexcept { return c0_; }
+    double c1() const noexcept { return c1_; }
+    double c2() const noexcept { return c2_; }
+
+private:
+    double center_;
+    double c0_;
+    double c1_;
+    double c2_;
+};
+
+
+/// Batch versions of the geometric calculations of Length, Area,
+/// Centroid and Distance, which operate on contiguous arrays of
+/// coordinates (as produced by WayCoordinateIterator::nextBlock()).
+/// On x86-64, they process two segments at a time using SSE2.
+///
+/// Since the vectorized kernels sum their terms in a different order,
+/// their results may differ from the scalar versions in the last few
+/// bits. Hence, they are opt-in: unless `exact` is set to `false`,
+/// each function produces the same results as the original
+/// per-segment calculations.
+///
+class GEODESK_API GeodesicKernels
+{
+public:
+    /// Returns the length (in meters) of the line string formed by the
+    /// given coordinates. Unless `exact`, uses a LocalMercatorScale if
+    /// the coordinates lie within a narrow enough band.
+    static double length(const Coordinate* coords, int count, bool exact = true);
+
+    /// Returns the sum of the lengths (in Mercator units) of the
+    /// segments, each multiplied by a quadratic polynomial of the Y of
+    /// the segment's midpoint (centered at `scale.center()`).
+    static double scaledLength(const Coordinate* coords, int count,
+        const LocalMercatorScale& scale);
+
+    /// Returns twice the signed area (in squared Mercator units) of
+    /// the ring section formed by the given coordinates, counting only
+    /// the vertexes that have both neighbors in the array. The X of each
+    /// vertex is taken relative to `x0` (the X of the ring's first vertex),
+    /// to preserve precision.
+    static double signedMercatorAreaSum(const Coordinate* coords, int count,
+        double x0, bool exact = true);
+
+    /// Adds the length-weighted centroid terms of the line
+    /// string formed by the given coordinates.
+    static void addLineCentroid(const Coordinate* coords, int count,
+        double& totalLength, double& centroidX, double& centroidY,
+        bool exact = true);
+
+    /// Adds the area-weighted centroid terms of the ring
+    /// section formed by the given coordinates.
+    static void addRingCentroid(const Coordinate* coords, int count,
+        double& areaSum, double& centroidX, double& centroidY,
+        bool exact = true);
+
+    /// Returns the square of the smallest distance (in Mercator units)
+    /// between the given point and the line string formed by the
+    /// given coordinates (or infinity if count < 2).
+    static double minPointSegmentSquared(const Coordinate* coords, int count,
+        Coordinate pt, bool exact = true);
+};
+
+// \endcond
+
+} // namespace geodesk
@@ -14,11 +14,18 @@ namespace geodesk {
 class GEODESK_API Length
 {
 public:
-	static double ofWay(WayPtr way);
-	static double ofRelation(FeatureStore* store, RelationPtr relation);
+	/// Returns the length (in meters) of the given way. If `exact` is
+	/// `false`, uses a per-way approximation of the Mercator scale where
+	/// this is accurate to 1e-9 (see LocalMercatorScale)
+	static double ofWay(WayPtr way, bool exact = true);
+	/// Returns the length (in meters) of the line string
+	/// formed by the given coordinates
+	static double ofLineString(const Coordinate* coords, int count, bool exact = true);
+	static double ofRelation(FeatureStore* store, RelationPtr relation, bool exact = true);
 
 private:
-	static double ofRelation(FeatureStore* store, RelationPtr rel, RecursionGuard& guard);
+	static double ofRelation(FeatureStore* store, RelationPtr rel,
+		RecursionGuard& guard, bool exact);
 };
 
 // \endcond
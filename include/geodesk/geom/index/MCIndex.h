@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: LGPL-3.0-only
 
 #pragma once
+#include <vector>
 #include <geodesk/geom/index/RTree.h>
 
 namespace geodesk {
@@ -84,7 +85,14 @@ public:
 	MCIndex() : data_(nullptr) {}
 	~MCIndex()
 	{
-		if (data_) delete[] data_;
+		if (data_)
+		{
+			delete[] data_;
+		}
+		else
+		{
+			index_.release();		// not owned
+		}
 	}
 
 	MCIndex(const uint8_t* data, RTree<const MonotoneChain>&& index) : 
@@ -105,13 +113,27 @@ public:
 
 	MCIndex& operator=(MCIndex&& other) noexcept
 	{
+		if (this == &other) return *this;
+		if (!data_) index_.release();		// not owned
 		index_ = std::move(other.index_);
-		if (this != &other && data_) delete data_; // Release currently owned memory (if any)
+		if (data_) delete[] data_; // Release currently owned memory (if any)
 		data_ = other.data_;
 		other.data_ = nullptr;
 		return *this;
 	}
 
+	/// Creates an index whose chains and nodes live in memory that
+	/// it does not own (such as a mapped MCIndexFile), which must
+	/// outlive the index
+	static MCIndex unowned(const RTree<const MonotoneChain>::Node* root)
+	{
+		MCIndex index;
+		index.index_ = RTree<const MonotoneChain>(root);
+		return index;
+	}
+
+	const RTree<const MonotoneChain>::Node* root() const { return index_.root(); }
+
 	bool properlyContainsPoint(Coordinate c) const;
 	bool containsPoint(Coordinate c) const;	
 	bool pointOnBoundary(Coordinate c) const;
@@ -126,6 +148,17 @@ public:
 		return index_.search(box, intersectsBoxBoundary, &box);
 	}
 
+	/**
+	 * Tests whether the bounding box of any monotone chain
+	 * intersects the given box.
+	 */
+	bool anyChainsIntersect(const Box& box) const
+	{
+		return index_.search<const void*>(box,
+			[](const RTree<const MonotoneChain>::Node*, const void*) { return true; },
+			nullptr);
+	}
+
 	/**
 	 * Tests where the given Box is located in respect to the indexed polygon.
 	 * 
@@ -159,6 +192,43 @@ public:
 		return closure.location.location();
 	}
 
+	/// Points located by locatePoints() are grouped into clusters
+	/// of this size, each of which takes a single walk of the index
+	static constexpr int CLUSTER_SIZE = 64;
+
+private:
+	struct ClusterPoint;
+
+public:
+	/// Working memory of locatePoints(), which can be reused for
+	/// multiple calls (batches of up to CLUSTER_SIZE points don't
+	/// need it at all)
+	class LocateBuffer
+	{
+	private:
+		std::vector<ClusterPoint> points_;
+		friend class MCIndex;
+	};
+
+	/**
+	 * Locates a batch of points, storing the same results as
+	 * locatePoint() (-1 = outside, 0 = on boundary, 1 = inside)
+	 * in `results`.
+	 *
+	 * The points are sorted along a Hilbert curve and split into
+	 * clusters of up to CLUSTER_SIZE points. The index is searched
+	 * once per cluster, and each chain that is found is tested
+	 * against all points of the cluster whose eastward rays
+	 * it may cross.
+	 */
+	void locatePoints(const Coordinate* points, size_t count, int8_t* results,
+		LocateBuffer& buffer) const;
+	void locatePoints(const Coordinate* points, size_t count, int8_t* results) const
+	{
+		LocateBuffer buffer;
+		locatePoints(points, count, results, buffer);
+	}
+
 	// static void nextWayChain(Coordinate start, WayCoordinateIterator& iter, MonotoneChain* mc, int maxVertexes);
 
 	template <typename QT>
@@ -176,6 +246,21 @@ private:
 		PointLocation location;
 	};
 
+	struct ClusterPoint
+	{
+		Coordinate point;
+		uint32_t index;		// position in the caller's array
+		uint32_t order;		// Hilbert distance
+	};
+
+	struct PointCluster
+	{
+		const ClusterPoint* points;		// sorted by y
+		int count;
+		int unresolved;					// points not found on the boundary
+		PointLocation locations[CLUSTER_SIZE];
+	};
+
 	static bool intersectsChain(const RTree<const MonotoneChain>::Node* node,
 		const MonotoneChain* candidate);
 	static bool intersectsBoxBoundary(const RTree<const MonotoneChain>::Node* node,
@@ -189,6 +274,10 @@ private:
 	*/
 	static bool countCrossings(const RTree<const MonotoneChain>::Node* node,
 		PointLocationClosure* closure);
+	static bool countClusterCrossings(const RTree<const MonotoneChain>::Node* node,
+		PointCluster* cluster);
+	static void locateCluster(const RTree<const MonotoneChain>& index,
+		const ClusterPoint* points, int count, int8_t* results);
 
 	RTree<const MonotoneChain> index_;
 	const uint8_t* data_;
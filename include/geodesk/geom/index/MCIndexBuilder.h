@@ -26,7 +26,21 @@ public:
 	#endif
 	void segmentizeAreaRelation(FeatureStore* store, RelationPtr rel);
 	void segmentizeMembers(FeatureStore* store, RelationPtr rel, RecursionGuard& guard);
+
+	/// Segmentizes a way or relation the same way as PreparedFilterFactory
+	void segmentizeFeature(FeatureStore* store, FeaturePtr feature);
+	bool isEmpty() const { return chainCount_ == 0; }
 	MCIndex build(Box bounds);
+
+	/// The approximate amount of memory taken up by the index
+	/// that build() creates
+	size_t indexSize() const
+	{
+		// The R-tree has a leaf node for each chain, and one
+		// parent node for every 9 children on the level below
+		return totalChainSize_ + (chainCount_ * 9 / 8 + 1) *
+			sizeof(RTree<const MonotoneChain>::Node);
+	}
 	static MCIndex buildFromAreaRelation(FeatureStore* store, RelationPtr rel)
 	{
 		MCIndexBuilder builder;
@@ -0,0 +1,47 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <clarisma/data/BudgetedLruCache.h>
+#include <geodesk/geom/index/MCIndex.h>
+
+namespace geodesk {
+
+/// \cond lowlevel
+
+/// A cache of prepared geometries (the MCIndex of a feature's
+/// monotone chains), so spatial filters that are created over and
+/// over for the same feature (e.g. `within(country)`) don't need to
+/// segmentize it and rebuild its index each time.
+///
+/// Indexes are keyed by the identity of their feature (FeaturePtr::idBits())
+/// and are shared with the filters that use them. If the total size of
+/// the cached indexes exceeds the memory budget, the least-recently-used
+/// ones are dropped from the cache; filters that still refer to an
+/// evicted index keep it alive until they are destroyed.
+///
+/// This class is thread-safe.
+///
+class MCIndexCache : public clarisma::BudgetedLruCache<int64_t, MCIndex>
+{
+public:
+    static constexpr uint64_t DEFAULT_BUDGET = 256 * 1024 * 1024;
+
+    /// Indexes smaller than this are cheap enough to rebuild,
+    /// so they aren't worth a cache slot
+    static constexpr size_t MIN_CACHED_SIZE = 4096;
+
+    MCIndexCache() : BudgetedLruCache(DEFAULT_BUDGET) {}
+
+    /// Adds an index to the cache. If another thread has cached an
+    /// index for the same feature in the meantime, that one is returned
+    /// instead (the two are equivalent). If the index is smaller than
+    /// MIN_CACHED_SIZE (or larger than the entire budget), it is
+    /// returned without being cached.
+    Handle put(int64_t key, MCIndex&& index, size_t size);
+};
+
+// \endcond
+
+} // namespace geodesk
@@ -0,0 +1,129 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <clarisma/io/MappedFile.h>
+#include <geodesk/feature/FeaturePtr.h>
+#include <geodesk/feature/GolIdentity.h>
+#include <geodesk/geom/index/MCIndexCache.h>
+
+namespace geodesk {
+
+class FeatureStore;
+
+/// \cond lowlevel
+
+/// A file of prepared geometries (MCIndex instances), keyed by the
+/// identity of their features (FeaturePtr::idBits()). It is written once
+/// and then memory-mapped, after which its indexes can be used in place,
+/// without having to be built (Since the nodes of an RTree refer to their
+/// children and items via self-relative offsets, the file contains the
+/// indexes in the same form as they exist in memory.) Processes that
+/// open the same file share its pages via the OS page cache.
+///
+/// Its indexes are only valid for the GOL from which they were built,
+/// whose identity is recorded in the header (see GolIdentity).
+///
+/// Layout (all values little-endian, blobs aligned to 8 bytes):
+///
+///   Header     magic, version, GOL identity, entry count,
+///              offset of entry table
+///   Blobs      for each index: its RTree nodes (root first),
+///              followed by its monotone chains
+///   Entries    (key, offset, size) of each blob, sorted by key
+///
+/// Lookups are thread-safe.
+///
+class MCIndexFile
+{
+    struct Entry
+    {
+        int64_t key;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+public:
+    static constexpr uint32_t MAGIC = 0x434D'4447;     // "GDMC"
+    static constexpr uint32_t VERSION = 2;
+
+    MCIndexFile() = default;
+    ~MCIndexFile();
+    MCIndexFile(const MCIndexFile&) = delete;
+    MCIndexFile& operator=(const MCIndexFile&) = delete;
+
+    /// Maps the given file (read-only), unless it was built for a GOL
+    /// other than `identity`, in which case `false` is returned.
+    /// Throws IOException if the file cannot be opened, or is not
+    /// a valid index file.
+    bool open(const std::string& path, const GolIdentity& identity);
+
+    size_t count() const noexcept { return count_; }
+
+    /// Returns the index for the given feature (or an empty handle if
+    /// the file has none). The index refers to the mapped file, and
+    /// must not be used once the file has been closed.
+    MCIndexCache::Handle get(int64_t key) const;
+
+    /// The path of the prepared-index file for the given
+    /// GOL file (`foo.gol` -> `foo.mci`)
+    static std::string defaultPath(const std::string& golFileName);
+
+    /// Writes an MCIndexFile, one index at a time.
+    class Writer
+    {
+    public:
+        /// Creates an index file for the GOL with the given identity
+        /// (see FeatureStore::identity())
+        Writer(const std::string& path, const GolIdentity& identity);
+        ~Writer();
+
+        /// Adds the given index. Each key may only be added once.
+        void add(int64_t key, const MCIndex& index);
+
+        /// Builds and adds the index of the given feature (the same
+        /// one that spatial filters use). Nodes, and features without
+        /// any segments, are skipped.
+        void addFeature(FeatureStore* store, FeaturePtr feature);
+
+        /// Writes the entry table and closes the file.
+        void finish();
+
+    private:
+        using Node = RTree<const MonotoneChain>::Node;
+
+        void writeAligned(const void* data, size_t size);
+        static void measure(const Node* p, bool leaf, const Node* root,
+            size_t& nodeCount, const uint8_t*& dataStart, const uint8_t*& dataEnd);
+        static void relocate(const Node* src, Node* dest, bool leaf,
+            const Node* srcRoot, Node* destRoot, const uint8_t* srcData, uint8_t* destData);
+
+        clarisma::File file_;
+        GolIdentity identity_;
+        uint64_t pos_;
+        std::vector<Entry> entries_;
+    };
+
+private:
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        GolIdentity identity;
+        uint64_t count;
+        uint64_t entriesOffset;
+    };
+
+    clarisma::MappedFile file_;
+    const uint8_t* data_ = nullptr;
+    uint64_t size_ = 0;
+    const Entry* entries_ = nullptr;
+    size_t count_ = 0;
+};
+
+// \endcond
+
+} // namespace geodesk
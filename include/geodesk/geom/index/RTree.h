@@ -21,6 +21,11 @@ template <typename IT>
 class RTree
 {
 public:
+	// A node refers to its first child (or its item) by a self-relative
+	// offset rather than a pointer, so a tree (along with its items)
+	// can be written to a file and used in place once mapped back
+	// into memory (see MCIndexFile). Hence, nodes must be
+	// initialized at their final location, and cannot be copied.
 	struct Node
 	{
 		Box bounds;
@@ -34,21 +39,27 @@ public:
 		void init(const Box& b, const void* p, int flags)
 		{
 			bounds = b;
-			childOrItem = reinterpret_cast<Node*>(
-				reinterpret_cast<uintptr_t>(p) | flags);
+			childOrItem = static_cast<intptr_t>(reinterpret_cast<uintptr_t>(p) -
+				reinterpret_cast<uintptr_t>(this)) | flags;
 		}
 
 		void markLast()
 		{
-			childOrItem = reinterpret_cast<Node*>(
-				reinterpret_cast<uintptr_t>(childOrItem) | LAST);
+			childOrItem |= LAST;
 		}
 
-		IT* item() const { return reinterpret_cast<IT*>(reinterpret_cast<uintptr_t>(childOrItem) & ~1); }
-		int endFlag() const { return reinterpret_cast<uintptr_t>(childOrItem) & 1; }
+		IT* item() const { return reinterpret_cast<IT*>(target(childOrItem & ~1)); }
+		const Node* child() const { return reinterpret_cast<const Node*>(target(childOrItem & ~3)); }
+		int endFlag() const { return childOrItem & 1; }
+		int flags() const { return childOrItem & 3; }
 
 	private:
-		Node* childOrItem;
+		uintptr_t target(intptr_t ofs) const
+		{
+			return reinterpret_cast<uintptr_t>(this) + ofs;
+		}
+
+		intptr_t childOrItem;
 
 		friend class RTree;
 	};
@@ -71,7 +82,7 @@ public:
 
 	RTree& operator=(RTree&& other) noexcept
 	{
-		if (this != &other && root_) delete root_; // Release currently owned memory (if any)
+		if (this != &other && root_) delete[] root_; // Release currently owned memory (if any)
 		root_ = other.root_;
 		other.root_ = nullptr;
 		return *this;
@@ -79,6 +90,15 @@ public:
 
 	const Node* root() const { return root_; }
 
+	/// Gives up ownership of the nodes (for trees whose
+	/// memory is managed elsewhere)
+	const Node* release() noexcept
+	{
+		const Node* root = root_;
+		root_ = nullptr;
+		return root;
+	}
+
 	template <typename QT>
 	bool search(const Box& box, SearchFunction<QT> func, QT closure) const
 	{
@@ -131,13 +151,11 @@ private:
 		for (;; p++)
 		{
 			bool found = false;
-			void* pItem = p->childOrItem;
-			uintptr_t intPtr = reinterpret_cast<uintptr_t>(pItem);
-			int endFlag = intPtr & 1;
-			int leafFlag = intPtr & 2;
+			int endFlag = p->childOrItem & 1;
+			int leafFlag = p->childOrItem & 2;
 			if (query.checkIntersection(p))
 			{
-				const Node* pChild = reinterpret_cast<const Node*>(intPtr & ~3);
+				const Node* pChild = p->child();
 				if (leafFlag)
 				{
 					found = searchLeaf(query, pChild);
@@ -46,11 +46,31 @@ public:
 			return false;
 		}
 		WayCoordinateIterator iter(way);
-		Coordinate prev = iter.next();
-		for (;;)
+		// Each block starts with the last coordinate of the previous block
+		Coordinate coords[WayCoordinateIterator::BLOCK_SIZE + 1];
+		int count = iter.nextBlock(coords, WayCoordinateIterator::BLOCK_SIZE + 1);
+		while (count > 1)
+		{
+			if (testAgainstLineString(coords, count)) return true;
+			coords[0] = coords[count - 1];
+			count = iter.nextBlock(&coords[1], WayCoordinateIterator::BLOCK_SIZE) + 1;
+		}
+		return false;
+	}
+
+	/**
+	 * Adds the number of times a ray cast from the test point crosses
+	 * the line string formed by the given coordinates. Shortcuts if
+	 * point lies on boundary.
+	 *
+	 * @return true if point lies on boundary, else false.
+	 */
+	bool testAgainstLineString(const Coordinate* coords, int count)
+	{
+		Coordinate prev = coords[0];
+		for (int i = 1; i < count; i++)
 		{
-			Coordinate next = iter.next();
-			if (next.isNull()) break;
+			Coordinate next = coords[i];
 
 			// we normalize the vector so it always points upwards
 			Coordinate start = prev.y < next.y ? prev : next;
@@ -5,6 +5,8 @@
 
 #include <geodesk/feature/WayPtr.h>
 #include <geodesk/feature/RelationPtr.h>
+#include <geodesk/feature/TileCache.h>
+#include <vector>
 #include <clarisma/alloc/Arena.h>
 #ifdef GEODESK_WITH_GEOS
 #include <geos_c.h>
@@ -65,6 +67,36 @@ public:
     /// have been called.
     ///
     void assignAndMergeHoles();
+
+    /// @brief Discards the assembled rings, so this Polygonizer
+    /// can be used for another relation. Unlike a new Polygonizer,
+    /// it keeps the memory of its arena (up to MAX_RETAINED_MEMORY).
+    ///
+    void reset();
+
+    /// @brief The memory (in bytes) used by this Polygonizer for
+    /// its rings and their coordinates since it was last reset
+    /// (memory retained for reuse, but not yet used, isn't counted).
+    ///
+    uint64_t memoryUsed() const { return arena_.used(); }
+
+    static constexpr size_t MAX_RETAINED_MEMORY = 1024 * 1024;
+
+    /// @brief Sets the maximum number of threads used to assemble the
+    /// rings of very large relations (0 = one per core; 1 = single-threaded,
+    /// which is the default, since Polygonizers are typically used by
+    /// threads that already run in parallel). Only relations with at least
+    /// `parallelThreshold` member ways (or RingAssigner::PARALLEL_THRESHOLD
+    /// inner rings, if that is less) are processed in parallel.
+    ///
+    void setMaxThreads(int threads, uint32_t parallelThreshold = PARALLEL_THRESHOLD)
+    {
+        maxThreads_ = threads;
+        parallelThreshold_ = parallelThreshold;
+    }
+
+    static constexpr size_t PARALLEL_THRESHOLD = 1024;
+
     #ifdef GEODESK_WITH_GEOS
     GEOSGeometry* createPolygonal(GEOSContextHandle_t context);
     #endif
@@ -76,6 +108,7 @@ private:
     class RingMerger;
 
     Segment* createSegment(WayPtr way, Segment* next);
+    void decodeSegments(const std::vector<Segment*>& segments);
     Ring* buildRings(int segmentCount, Segment* firstSegment);
 
     static Ring* createRing(int vertexCount, Segment* firstSegment, 
@@ -84,6 +117,9 @@ private:
     clarisma::Arena arena_;
     Ring* outerRings_;
     Ring* innerRings_;
+    std::vector<TilePin> foreignPins_;   // tiles of the member ways
+    int maxThreads_;
+    uint32_t parallelThreshold_;
 
     friend class RingCoordinateIterator;
 };
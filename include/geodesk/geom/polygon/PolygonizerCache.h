@@ -0,0 +1,89 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <atomic>
+#include <clarisma/data/BudgetedLruCache.h>
+#include <geodesk/geom/polygon/Polygonizer.h>
+
+namespace geodesk {
+
+/// \cond lowlevel
+
+/// A cache of the assembled rings of area relations, so relations
+/// that are measured or exported over and over (e.g. countries or
+/// large lakes) don't need to be polygonized each time.
+///
+/// Rings are keyed by the identity of their relation
+/// (FeaturePtr::idBits()), and whether their holes have been
+/// assigned. If the total memory held by the cached Polygonizers
+/// exceeds the budget, the least-recently-used ones are dropped.
+/// (A Polygonizer also pins the tiles of any member ways that live
+/// in other tiles, which aren't counted towards the budget.)
+/// Rings of relations that aren't worth caching are assembled in
+/// a Polygonizer taken from a per-thread pool, whose memory is
+/// recycled once the last Handle to it is released.
+///
+/// This class is thread-safe.
+///
+class PolygonizerCache
+{
+public:
+    using Handle = std::shared_ptr<const Polygonizer>;
+    using Stats = clarisma::BudgetedLruCache<int64_t, Polygonizer>::Stats;
+
+    static constexpr uint64_t DEFAULT_BUDGET = 64 * 1024 * 1024;
+
+    /// Relations whose rings take up less memory than this are
+    /// cheap enough to assemble again, so they aren't cached
+    static constexpr size_t MIN_CACHED_SIZE = 64 * 1024;
+
+    PolygonizerCache() : cache_(DEFAULT_BUDGET) {}
+
+    PolygonizerCache(const PolygonizerCache&) = delete;
+    PolygonizerCache& operator=(const PolygonizerCache&) = delete;
+
+    /// Returns the rings of the given area relation, assembling
+    /// them if they aren't cached. If `assignHoles`, the Polygonizer
+    /// has had assignAndMergeHoles() applied.
+    Handle rings(FeatureStore* store, RelationPtr relation, bool assignHoles);
+
+    /// Sets the maximum total memory of the cached Polygonizers
+    /// (0 disables the cache).
+    void setBudget(uint64_t bytes) { cache_.setBudget(bytes); }
+
+    /// Sets the maximum number of threads used to assemble the rings
+    /// of very large relations (see Polygonizer::setMaxThreads()).
+    /// Affects only rings assembled from now on; since the result is
+    /// the same either way, cached rings are kept.
+    void setMaxThreads(int threads,
+        uint32_t parallelThreshold = Polygonizer::PARALLEL_THRESHOLD)
+    {
+        maxThreads_.store(threads, std::memory_order_relaxed);
+        parallelThreshold_.store(parallelThreshold, std::memory_order_relaxed);
+    }
+
+    int maxThreads() const { return maxThreads_.load(std::memory_order_relaxed); }
+
+    void clear() { cache_.clear(); }
+    Stats stats() { return cache_.stats(); }
+
+private:
+    static int64_t key(RelationPtr relation, bool assignHoles)
+    {
+        // The lowest bits of idBits() are always clear
+        return relation.idBits() | (assignHoles ? 1 : 0);
+    }
+
+    static std::unique_ptr<Polygonizer> acquire();
+    static void recycle(Polygonizer* polygonizer);
+
+    clarisma::BudgetedLruCache<int64_t, Polygonizer> cache_;
+    std::atomic<int> maxThreads_ = 1;
+    std::atomic<uint32_t> parallelThreshold_ = Polygonizer::PARALLEL_THRESHOLD;
+};
+
+// \endcond
+
+} // namespace geodesk
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <geodesk/feature/types.h>
@@ -100,7 +101,10 @@ public:
         const MatcherHolder* a, const MatcherHolder* b);
 
     void dealloc() const;
-#ifdef GEODESK_MULTITHREADED
+
+    // The refcount is atomic even in single-threaded builds, since
+    // the Matchers cached by a MatcherCompiler are shared by all
+    // threads that issue the same query
     void addref() const
     {
         refcount_.fetch_add(1, std::memory_order_relaxed);
@@ -113,10 +117,6 @@ public:
             dealloc();
         }
     }
-#else
-    void addref() const { ++refcount_; }
-    void release() const { if (--refcount_ == 0) dealloc(); }
-#endif
 
     const Matcher& mainMatcher() const { return mainMatcher_; }
     FeatureTypes acceptedTypes() const { return acceptedTypes_; }
@@ -133,11 +133,7 @@ private:
     static bool matchAllMethod(const Matcher*, FeaturePtr);
     static uint8_t* alloc(size_t size) { return new uint8_t[size]; };
 
-#ifdef GEODESK_MULTITHREADED
     mutable std::atomic_uint32_t refcount_;
-#else
-    mutable uint32_t refcount_;
-#endif
 
     FeatureTypes acceptedTypes_;
     uint32_t resourcesLength_;
@@ -153,6 +149,7 @@ private:
 
     friend class MatcherCompiler;
     friend class ComboMatcher;
+    friend class KernelMatcher;
 };
 
 // \endcond
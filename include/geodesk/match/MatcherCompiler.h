@@ -3,9 +3,14 @@
 
 #pragma once
 
-// #define ASMJIT_STATIC 
+// #define ASMJIT_STATIC
 // #include <asmjit/asmjit.h>
 #include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 namespace geodesk {
 
@@ -16,22 +21,79 @@ struct Selector;
 
 /// \cond lowlevel
 
+/// Turns query strings into Matchers. Compiled Matchers are kept in
+/// a bounded LRU cache (keyed by the normalized query string), so
+/// repeated queries don't have to be parsed and compiled again.
+///
+/// This class is thread-safe (cached Matchers may be handed to several
+/// threads at once, which is why MatcherHolder's reference count is
+/// always atomic).
+///
 class MatcherCompiler
 {
 public:
+	static constexpr size_t DEFAULT_CACHE_CAPACITY = 256;
+
+	struct CacheStats
+	{
+		uint64_t hits;
+		uint64_t misses;
+		size_t size;
+		size_t capacity;
+	};
+
 	explicit MatcherCompiler(FeatureStore* store) :
-		store_(store)
+		store_(store),
+		cacheCapacity_(DEFAULT_CACHE_CAPACITY),
+		hits_(0),
+		misses_(0)
 	{
 		// TODO: fix this dependency, store not initialized yet
 	}
 
+	~MatcherCompiler();
+
+	MatcherCompiler(const MatcherCompiler&) = delete;
+	MatcherCompiler& operator=(const MatcherCompiler&) = delete;
+
+	/// Returns a Matcher for the given query (the caller owns
+	/// one reference and must release it).
 	const MatcherHolder* getMatcher(const char* query);
 
+	CacheStats cacheStats();
+
+	/// Sets the maximum number of cached Matchers (0 disables
+	/// the cache), evicting the least-recently used as needed.
+	void setCacheCapacity(size_t capacity);
+	void clearCache();
+
+	/// Trims the query and collapses runs of whitespace into a single
+	/// space (except in quoted strings), so trivially different
+	/// spellings of the same query share a cache entry.
+	static std::string normalizeQuery(std::string_view query);
+
 private:
+	struct CacheEntry
+	{
+		std::string query;
+		const MatcherHolder* matcher;
+	};
+
+	using CacheList = std::list<CacheEntry>;
+
+	const MatcherHolder* compile(const char* query);
 	const MatcherHolder* compileMatcher(OpGraph& graph, Selector* firstSel, uint32_t indexBits);
+	void evict(size_t maxSize);		// requires lock
 
 	FeatureStore* store_;
 	// asmjit::JitRuntime runtime_;
+	std::mutex mutex_;
+	CacheList entries_;				// most recently used first
+	std::unordered_map<std::string_view, CacheList::iterator> index_;
+		// keys point to the query strings held by entries_
+	size_t cacheCapacity_;
+	uint64_t hits_;
+	uint64_t misses_;
 };
 
 // \endcond
@@ -0,0 +1,121 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <functional>
+#include <span>
+#include <vector>
+#include <geodesk/feature/FeaturePtr.h>
+#include <geodesk/feature/FeatureStore.h>
+#include <geodesk/feature/types.h>
+#include <geodesk/geom/Box.h>
+#include <geodesk/geom/Coordinate.h>
+#include <geodesk/geom/index/RTree.h>
+
+namespace geodesk {
+
+class Filter;
+
+/// \cond lowlevel
+
+/// Finds the features for a large number of probes (bounding boxes,
+/// or points) at once: a spatial join between the probes and the
+/// features of a GOL.
+///
+/// Rather than running a Query for each probe, the probes are placed
+/// into a Hilbert-packed R-tree, and the tile index is walked only
+/// once. Each tile that intersects any probe is fetched and scanned
+/// a single time (on multiple threads); the bounding box of every
+/// candidate feature is looked up in the probe tree to find the probes
+/// that it matches.
+///
+/// For box probes, a feature matches if its bounding box intersects
+/// the probe. For point probes, its geometry must contain the point
+/// (the same test as Features::containing()).
+///
+/// Matches are delivered on the calling thread, grouped by tile (and
+/// hence in no particular order); a feature that matches more than one
+/// probe is reported once per probe. A feature that lives in two tiles
+/// is only matched against a probe by one of them: each tile only
+/// considers the part of the probe that lies within its bounds, and
+/// if both tiles see the probe, the tile to the west (or north) reports
+/// the match. At most MAX_QUEUED_TILES tiles of matches wait for the
+/// consumer; once this limit is reached, the threads that scan tiles
+/// pause (so a slow consumer doesn't cause all tiles to be kept
+/// in memory).
+///
+class BatchQuery
+{
+public:
+    using Consumer = std::function<void(size_t probe, FeaturePtr feature)>;
+
+    BatchQuery(FeatureStore* store, std::span<const Box> probes,
+        FeatureTypes types, const MatcherHolder* matcher,
+        const Filter* filter);
+    BatchQuery(FeatureStore* store, std::span<const Coordinate> points,
+        FeatureTypes types, const MatcherHolder* matcher,
+        const Filter* filter);
+
+    /// Runs the query, calling `consumer` for each match.
+    ///
+    /// @param bounds       only matches whose probe and feature
+    ///                     intersect within this box are reported
+    /// @param threadCount  the number of threads that scan tiles
+    ///                     (0 = one per core)
+    void run(const Consumer& consumer, const Box& bounds = Box::ofWorld(),
+        int threadCount = 0);
+
+    /// The maximum number of tiles whose matches are waiting
+    /// to be consumed (per scanning thread)
+    static constexpr int MAX_QUEUED_TILES = 4;
+
+private:
+    using ProbeTree = RTree<const Box>;
+
+    struct TileTask
+    {
+        Tip tip;
+        Box bounds;
+    };
+
+    struct Match
+    {
+        uint32_t probe;
+        uint32_t offset;        // of the feature, relative to its tile
+    };
+
+    struct TileResults
+    {
+        DataPtr pTile;
+        TilePin pin;
+        std::vector<Match> matches;
+    };
+
+    /// The state of a tile scan
+    struct TileScan
+    {
+        const ProbeTree& tree;
+        Box tileBounds;
+        Box bounds;             // the query's bounds
+        TileResults& results;
+    };
+
+    void scanTile(const TileTask& task, const ProbeTree& tree,
+        const Box& bounds, TileResults& results) const;
+    void matchFeature(FeaturePtr feature, const TileScan& scan) const;
+    static bool reportedByOtherTile(FeaturePtr feature, const Box& featureBounds,
+        const Box& overlap, const Box& tileBounds);
+    bool acceptProbe(FeaturePtr feature, const Box& probe) const;
+
+    FeatureStore* store_;
+    std::vector<Box> probes_;
+    FeatureTypes types_;
+    const MatcherHolder* matcher_;
+    const Filter* filter_;
+    bool points_;
+};
+
+// \endcond
+
+} // namespace geodesk
@@ -0,0 +1,143 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <geodesk/export.h>
+#include <geodesk/feature/FeatureTypes.h>
+#include <geodesk/feature/types.h>
+#include <geodesk/geom/Box.h>
+
+namespace geodesk {
+
+/// \cond lowlevel
+
+/// Evaluates the cheap criteria of a spatial query (bounding box and
+/// feature type) for a block of spatial-index leaf entries at once,
+/// producing a bitmask of candidates. Only the candidates need to be
+/// checked by the (far more expensive) Matcher and Filter.
+///
+/// The scanning kernel is chosen at runtime, based on the capabilities
+/// of the CPU (AVX2, SSE2 or plain scalar code).
+///
+class GEODESK_API LeafScanner
+{
+public:
+    enum class Kernel
+    {
+        SCALAR,
+        SSE2,
+        AVX2
+    };
+
+    /// The maximum number of entries scanned per call
+    static constexpr int BLOCK_SIZE = 32;
+
+    /// @param box    the query's bounding box
+    /// @param types  the accepted feature types
+    /// @param northwestFlags  MULTITILE_NORTH and/or MULTITILE_WEST,
+    ///   if the query visits the tile to the north/west of the
+    ///   current tile (features that have a copy in such a tile
+    ///   are skipped, since the other tile returns them)
+    LeafScanner(const Box& box, FeatureTypes types, uint32_t northwestFlags) :
+        LeafScanner(box, types, northwestFlags, bestKernel())
+    {
+    }
+
+    LeafScanner(const Box& box, FeatureTypes types, uint32_t northwestFlags,
+        Kernel kernel);
+
+    /// Scans up to BLOCK_SIZE entries of a way/area/relation leaf
+    /// (32 bytes each: bbox, followed by the feature's header)
+    ///
+    /// @param p           the first entry of the block
+    /// @param candidates  receives the bitmask of candidates
+    ///                    (bit i = the i-th entry of the block)
+    /// @return the first entry of the next block, or `nullptr`
+    ///   if the leaf's last entry has been scanned
+    const uint8_t* scanFeatures(const uint8_t* p, uint32_t* candidates) const
+    {
+        return scanFeatures_(*this, p, candidates);
+    }
+
+    /// Scans up to BLOCK_SIZE entries of a node leaf (20 or 24 bytes
+    /// each: coordinate, followed by the node's header)
+    ///
+    /// @param p           the first entry of the block
+    /// @param candidates  receives the bitmask of candidates
+    /// @param offsets     receives the offset (relative to `p`)
+    ///                    of each scanned entry
+    /// @return the first entry of the next block, or `nullptr`
+    ///   if the leaf's last entry has been scanned
+    const uint8_t* scanNodes(const uint8_t* p, uint32_t* candidates,
+        uint16_t* offsets) const
+    {
+        return scanNodes_(*this, p, candidates, offsets);
+    }
+
+    Kernel kernel() const noexcept { return kernel_; }
+
+    /// The fastest kernel supported by this CPU
+    static Kernel bestKernel() noexcept { return BEST_KERNEL; }
+    static bool isSupported(Kernel kernel) noexcept;
+
+private:
+    using FeatureScanFunc = const uint8_t* (*)(const LeafScanner& scanner,
+        const uint8_t* p, uint32_t* candidates);
+    using NodeScanFunc = const uint8_t* (*)(const LeafScanner& scanner,
+        const uint8_t* p, uint32_t* candidates, uint16_t* offsets);
+
+    static Kernel detectKernel() noexcept;
+    static const Kernel BEST_KERNEL;
+
+    // Kernels (implemented in LeafScanner.cpp)
+    static const uint8_t* scanFeaturesScalar(const LeafScanner& scanner,
+        const uint8_t* p, uint32_t* candidates);
+    static const uint8_t* scanNodesScalar(const LeafScanner& scanner,
+        const uint8_t* p, uint32_t* candidates, uint16_t* offsets);
+    static const uint8_t* scanFeaturesSse2(const LeafScanner& scanner,
+        const uint8_t* p, uint32_t* candidates);
+    static const uint8_t* scanNodesSse2(const LeafScanner& scanner,
+        const uint8_t* p, uint32_t* candidates, uint16_t* offsets);
+    static const uint8_t* scanFeaturesAvx2(const LeafScanner& scanner,
+        const uint8_t* p, uint32_t* candidates);
+
+    /// Returns 1 if a feature with the given flags is of an accepted
+    /// type, and is not returned by the tile to the north/west
+    uint32_t acceptFeatureFlags(int32_t flags) const noexcept
+    {
+        uint32_t typeOk = (types_ >> ((flags >> 1) & 0x1f)) & 1;
+        uint32_t multiTile = static_cast<uint32_t>(flags) &
+            (FeatureFlags::MULTITILE_NORTH | FeatureFlags::MULTITILE_WEST);
+        uint32_t skip = (multiTile != (FeatureFlags::MULTITILE_NORTH |
+            FeatureFlags::MULTITILE_WEST)) & ((multiTile & northwestFlags_) != 0);
+        return typeOk & (skip ^ 1);
+    }
+
+    uint32_t acceptNodeFlags(int32_t flags) const noexcept
+    {
+        return (types_ >> ((flags >> 1) & 0x1f)) & 1;
+    }
+
+    /// Returns 1 if the feature leaf entry at `p` (whose flags
+    /// are given) is a candidate
+    uint32_t acceptFeature(const uint8_t* p, int32_t flags) const noexcept;
+    /// Returns 1 if the node leaf entry at `p` (whose flags
+    /// are given) is a candidate
+    uint32_t acceptNode(const uint8_t* p, int32_t flags) const noexcept;
+
+    // Bounds for feature entries
+    int32_t minX_, minY_, maxX_, maxY_;
+    // Bounds for node entries (normalized for an Antimeridian-crossing box)
+    int32_t nodeMinX_, nodeMaxX_;
+    uint32_t types_;
+    uint32_t northwestFlags_;
+    Kernel kernel_;
+    FeatureScanFunc scanFeatures_;
+    NodeScanFunc scanNodes_;
+};
+
+// \endcond
+
+} // namespace geodesk
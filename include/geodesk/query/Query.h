@@ -4,8 +4,10 @@
 #pragma once
 
 #include "AbstractQuery.h"
+#include <atomic>
 #include <condition_variable>
-#include <unordered_set>
+#include <optional>
+#include <clarisma/data/OpenHashSet.h>
 #include <geodesk/query/QueryResults.h>
 #include <geodesk/query/TileIndexWalker.h>
 #include <geodesk/feature/FeatureStore.h>
@@ -20,47 +22,164 @@ class Filter;
 class Query : public AbstractQuery
 {
 public:
+    /// The reduction performed by the TileQueryTasks. If other than
+    /// NONE, each task sums up the measure of the features it finds
+    /// (instead of placing them into result buckets), and the Query
+    /// merely adds up the per-tile partials (see aggregate()).
+    /// Features that require deduplication are still delivered
+    /// individually, and are measured on the consumer thread.
+    enum class Aggregate : uint8_t
+    {
+        NONE,
+        COUNT,
+        LENGTH,
+        AREA
+    };
+
+    /// The scheduling priority of the Query's tiles. Tiles of
+    /// HIGH-priority queries are scanned before those of NORMAL ones.
+    /// (This is a low-level option: queries issued via Features
+    /// always run at NORMAL priority.)
+    enum class Priority : uint8_t
+    {
+        NORMAL,
+        HIGH
+    };
+
+    static constexpr uint64_t UNLIMITED = UINT64_MAX;
+    static constexpr uint32_t DEFAULT_PREFETCH_DISTANCE = 0;
+
+    struct Options
+    {
+        Options() :
+            limit(UNLIMITED),
+            bucketSize(QueryResults::DEFAULT_BUCKET_SIZE),
+            prefetchDistance(DEFAULT_PREFETCH_DISTANCE),
+            aggregate(Aggregate::NONE),
+            priority(Priority::NORMAL)
+        {
+        }
+
+        /// Stop scanning once this many features have been found
+        /// (next() returns no more than `limit` features)
+        uint64_t limit;
+        /// The number of features per result bucket. Full buckets
+        /// are handed to the consumer while the tile is still being
+        /// scanned, so smaller buckets reduce the time to the first
+        /// feature (at the cost of more hand-offs)
+        uint32_t bucketSize;
+        /// The number of tiles (beyond those already handed to the
+        /// executor) whose data is prefetched, so the OS can read them
+        /// from disk while earlier tiles are scanned (0 = no prefetching).
+        /// Prefetching walks the tile index a second time (including the
+        /// filter's tile checks), so it only pays off for cold GOLs
+        uint32_t prefetchDistance;
+        Aggregate aggregate;
+        Priority priority;
+    };
+
     Query(FeatureStore* store, const Box& box, FeatureTypes types, 
-        const MatcherHolder* matcher, const Filter* filter); 
+        const MatcherHolder* matcher, const Filter* filter,
+        const Options& options = Options());
     ~Query();
     const Box& bounds() const { return tileIndexWalker_.bounds(); }
     FeatureTypes types() const { return types_; }
     const MatcherHolder* matcher() const { return matcher_; }
     const Filter* filter() const { return filter_; }
     FeatureStore* store() const { return store_; }
-    void offer(QueryResults* results);
+    Aggregate aggregateMode() const { return aggregate_; }
+    Priority priority() const { return priority_; }
+    uint64_t limit() const { return limit_; }
+    uint32_t bucketSize() const { return bucketSize_; }
+
+    // Called by the TileQueryTasks:
+    void publish(QueryResults* bucket, uint32_t uniqueCount);
+    void offer(QueryResults* results, double partial = 0, uint32_t uniqueCount = 0);
+    QueryResults* takeFreeBuckets();
+    void recycle(QueryResults* first, QueryResults* last);
+    void limitReached();
+    /// Returns `true` if the TileQueryTasks should stop scanning
+    /// (because the Query has been cancelled or its limit has been reached)
+    bool isStopped() const
+    {
+        return stopFlags_.load(std::memory_order_relaxed) != 0;
+    }
+
     void cancel();
+    bool isCancelled() const
+    {
+        return stopFlags_.load(std::memory_order_relaxed) & CANCELLED;
+    }
 
     FeaturePtr next();
 
+    /// Consumes the remaining results of an aggregating Query,
+    /// returning the total of the per-tile partials (plus the
+    /// measures of any features that required deduplication)
+    double aggregate();
+    static double measure(FeatureStore* store, FeaturePtr feature,
+        Aggregate aggregate);
+
     static constexpr uint32_t REQUIRES_DEDUP = 0x8000'0000;
 
 private:
+    static constexpr uint8_t CANCELLED = 1;
+    static constexpr uint8_t LIMIT_REACHED = 2;
+
     const QueryResults* take();
+    void park();
+    void wakeConsumer();
+    void pushResults(QueryResults* first, QueryResults* last);
+    void countFound(uint32_t uniqueCount);
     void requestTiles();
+    void prefetchTiles();
+    void recycle(const QueryResults* res);
     static void deleteResults(const QueryResults* res);
 
     // FeatureStore* store_;  // moved to AbstractQuery
     FeatureTypes types_;
     const MatcherHolder* matcher_;
     const Filter* filter_;
+    Aggregate aggregate_;
+    Priority priority_;
+    uint32_t bucketSize_;
+    uint64_t limit_;
+    uint64_t returnedCount_;
     int32_t pendingTiles_;      // TODO: rearrange to avoid needless gaps
     const QueryResults* currentResults_;
     int32_t currentPos_;
     bool allTilesRequested_;
-    std::unordered_set<uint64_t> potentialDupes_;
+    double total_;
+    /// IDs of multi-tile features that have been returned from one
+    /// tile, but whose twin has not been seen yet
+    clarisma::OpenHashSet<uint64_t> potentialDupes_;
     TileIndexWalker tileIndexWalker_;
+    /// Runs ahead of tileIndexWalker_, prefetching upcoming tiles
+    std::optional<TileIndexWalker> prefetchWalker_;
+    uint32_t prefetchDistance_;
+    uint32_t requestedTiles_;
+    uint32_t prefetchedTiles_;
 
     // these are used by multiple threads:
     // TODO: padding to avoid false sharing
     // maybe use TileIndexWalker for padding as it has lots
     // of unused entries?
 
-    std::mutex mutex_;
-    std::condition_variable resultsReady_;  // requires mutex_
-    QueryResults* queuedResults_;           // requires mutex_
-    int32_t completedTiles_;                // requires mutex_
-    // bool isCancelled_;                      // requires mutex_
+    /// Set in completedTiles_ while the consumer is parked; the
+    /// producer that clears it is responsible for waking the consumer
+    /// (Producers that publish buckets of a tile they are still
+    /// scanning may also clear it)
+    static constexpr uint32_t CONSUMER_PARKED = 0x8000'0000;
+
+    std::atomic<QueryResults*> queuedResults_;  // lock-free stack of buckets
+    std::atomic<uint32_t> completedTiles_;      // count | CONSUMER_PARKED
+    std::atomic<double> queuedTotal_;
+    std::atomic<QueryResults*> freeBuckets_;    // lock-free stack of buckets
+    std::atomic<uint64_t> foundCount_;          // towards limit_
+    std::mutex parkMutex_;
+    std::condition_variable resultsReady_;      // requires parkMutex_
+    bool consumerWoken_;                        // requires parkMutex_
+    std::atomic<uint8_t> stopFlags_;            // CANCELLED | LIMIT_REACHED
 };
 
 
@@ -4,7 +4,9 @@
 #pragma once
 
 #include <cstdint>
+#include <new>
 #include <clarisma/util/DataPtr.h>
+#include <geodesk/feature/TileCache.h>
 
 namespace geodesk {
 
@@ -17,8 +19,16 @@ struct QueryResultsHeader
     QueryResults* next;
     clarisma::DataPtr pTile;
     uint32_t count;
+    uint32_t capacity;
+    TilePin tilePin;        // keeps a decompressed tile alive
+                            // until its results have been consumed
 };
 
+/// A bucket of query results (pointers to features, relative to
+/// the start of their tile). The items are stored right after the
+/// header; the number of items a bucket can hold is chosen per Query
+/// (see Query::Options::bucketSize).
+///
 struct QueryResults : public QueryResultsHeader
 {
     static const uint32_t DEFAULT_BUCKET_SIZE = 256;
@@ -27,12 +37,39 @@ struct QueryResults : public QueryResultsHeader
     static QueryResultsHeader EMPTY_HEADER;
     static QueryResults* const EMPTY;
 
+    static QueryResults* create(uint32_t capacity)
+    {
+        void* p = ::operator new(sizeof(QueryResultsHeader) +
+            capacity * sizeof(uint32_t));
+        QueryResults* res = static_cast<QueryResults*>(p);
+        res->capacity = capacity;
+        new(&res->tilePin) TilePin();
+        return res;
+    }
+
+    static void destroy(const QueryResults* res)
+    {
+        QueryResults* mutableRes = const_cast<QueryResults*>(res);
+        mutableRes->tilePin.~TilePin();
+        ::operator delete(mutableRes);
+    }
+
     bool isFull() const
     {
-        return count == DEFAULT_BUCKET_SIZE;
+        return count == capacity;
     }
 
-    uint32_t items[DEFAULT_BUCKET_SIZE];
+    uint32_t* items()
+    {
+        return reinterpret_cast<uint32_t*>(
+            reinterpret_cast<uint8_t*>(this) + sizeof(QueryResultsHeader));
+    }
+
+    const uint32_t* items() const
+    {
+        return reinterpret_cast<const uint32_t*>(
+            reinterpret_cast<const uint8_t*>(this) + sizeof(QueryResultsHeader));
+    }
 };
 
 // \endcond
@@ -0,0 +1,277 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <clarisma/util/Bits.h>
+#include <clarisma/util/DataPtr.h>
+#include <geodesk/feature/FeaturePtr.h>
+#include <geodesk/feature/types.h>
+#include <geodesk/filter/Filter.h>
+#include <geodesk/geom/Box.h>
+#include <geodesk/match/Matcher.h>
+#include <geodesk/query/LeafScanner.h>
+
+namespace geodesk {
+
+/// \cond lowlevel
+
+/// Walks the spatial indexes of a tile, and reports the features
+/// that lie in a bounding box, are of the requested types and are
+/// accepted by matcher and filter. This is the scan shared by
+/// TileQueryTask and BatchQuery; they differ only in what they
+/// do with the features that are found.
+///
+/// - Roots for key categories the matcher can't accept are skipped
+/// - If the filter can classify branches (FAST_BRANCH_FILTER),
+///   branches it rejects are skipped, and branches whose features
+///   it accepts in full are scanned without the filter
+/// - Leaves are checked a block at a time by a LeafScanner
+/// - A filter with BATCH_NODE_FILTER is handed the candidate
+///   nodes in batches of up to NODE_BATCH_SIZE
+///
+/// The Visitor must provide:
+///
+///     bool isStopped();                 // abandon the scan?
+///     void foundNode(FeaturePtr node);
+///     void foundFeature(FeaturePtr feature);
+///
+/// Features are reported in the order of the tile's indexes.
+///
+template <typename Visitor>
+class TileIndexScan
+{
+public:
+    /// Number of candidate nodes handed to a filter with
+    /// BATCH_NODE_FILTER at once
+    static constexpr int NODE_BATCH_SIZE = 256;
+
+    /// @param northwestFlags  see LeafScanner
+    TileIndexScan(Visitor& visitor, FeatureStore* store, const Box& bounds,
+        FeatureTypes types, const MatcherHolder* matcher, const Filter* filter,
+        FastFilterHint fastFilterHint, uint32_t northwestFlags) :
+        visitor_(visitor),
+        store_(store),
+        bounds_(bounds),
+        types_(types),
+        matcher_(matcher),
+        filter_(filter),
+        fastFilterHint_(fastFilterHint),
+        scanner_(bounds, types, northwestFlags)
+    {
+    }
+
+    void scan(DataPtr pTile)
+    {
+        if (types_ & FeatureTypes::NODES)
+        {
+            scanIndex<true>(pTile + 8, FeatureIndexType::NODES);
+        }
+        if (types_ & FeatureTypes::NONAREA_WAYS)
+        {
+            scanIndex<false>(pTile + 12, FeatureIndexType::WAYS);
+        }
+        if (types_ & FeatureTypes::AREAS)
+        {
+            scanIndex<false>(pTile + 16, FeatureIndexType::AREAS);
+        }
+        if (types_ & FeatureTypes::NONAREA_RELATIONS)
+        {
+            scanIndex<false>(pTile + 20, FeatureIndexType::RELATIONS);
+        }
+    }
+
+private:
+    template <bool NODES>
+    void scanIndex(DataPtr ppRoot, FeatureIndexType indexType)
+    {
+        int32_t ptr = ppRoot.getInt();
+        if (ptr == 0) return;
+        if ((ptr & 1) == 0)
+        {
+            scanRoot<NODES>(ppRoot);
+            return;
+        }
+
+        // Multiple roots (one per key category)
+        DataPtr p = ppRoot + (ptr ^ 1);
+        for (;;)
+        {
+            int32_t last = p.getInt() & 1;
+            int32_t keys = (p+4).getInt();
+            if (matcher_->acceptIndex(indexType, keys)) scanRoot<NODES>(p);
+            if (last != 0) break;
+            p += 8;
+        }
+    }
+
+    template <bool NODES>
+    void scanRoot(DataPtr ppRoot)
+    {
+        int32_t ptr = ppRoot.getInt();
+        if (ptr & 0xffff'fffc)
+        {
+            DataPtr p = ppRoot + (ptr & 0xffff'fffc);
+            if (ptr & 2)
+            {
+                scanLeaf<NODES>(p, filter_);
+            }
+            else
+            {
+                scanBranch<NODES>(p, filter_);
+            }
+        }
+    }
+
+    // Checks whether the filter can classify index branches as a whole
+    // (This is only worth doing if the tile itself is not accelerated,
+    // since the filter will then take its fast path anyway)
+    bool classifiesBranches(const Filter* filter) const
+    {
+        return filter && (filter->flags() & FilterFlags::FAST_BRANCH_FILTER) &&
+            fastFilterHint_.turboFlags == 0;
+    }
+
+    // If the filter rejects a branch, we skip it entirely; if it accepts
+    // all of the branch's features, we scan it without the filter
+    template <bool NODES>
+    void scanBranch(DataPtr p, const Filter* filter)
+    {
+        if (visitor_.isStopped()) return;
+        bool classify = classifiesBranches(filter);
+        for (;;)
+        {
+            int32_t ptr = p.getInt();
+            int32_t last = ptr & 1;
+            const Box& branchBounds = *reinterpret_cast<const Box*>(p.ptr() + 4);
+            if (bounds_.intersects(branchBounds))
+            {
+                int accept = classify ? filter->acceptBranch(branchBounds) : 0;
+                if (accept >= 0)
+                {
+                    const Filter* childFilter = accept > 0 ? nullptr : filter;
+                    DataPtr pChild = p + (ptr & 0xffff'fffc);
+                    if (ptr & 2)
+                    {
+                        scanLeaf<NODES>(pChild, childFilter);
+                    }
+                    else
+                    {
+                        scanBranch<NODES>(pChild, childFilter);     // NOLINT recursion
+                    }
+                }
+            }
+            if (last != 0) break;
+            p += 20;
+        }
+    }
+
+    template <bool NODES>
+    void scanLeaf(DataPtr p, const Filter* filter)
+    {
+        if (visitor_.isStopped()) return;
+        if constexpr (NODES)
+        {
+            scanNodeLeaf(p, filter);
+        }
+        else
+        {
+            scanFeatureLeaf(p, filter);
+        }
+    }
+
+    // The scanner checks the coordinates and types of a block of nodes
+    // at once; only its candidates are checked by matcher and filter
+    // (Entries have different sizes, so it also reports their offsets)
+    // A filter that can test nodes in batches is handed the nodes
+    // accepted by the matcher in groups of up to NODE_BATCH_SIZE
+    // (nodes are still reported in the order of the leaf)
+    void scanNodeLeaf(DataPtr p, const Filter* filter)
+    {
+        const Matcher& matcher = matcher_->mainMatcher();
+        const uint8_t* pBlock = p.ptr();
+        uint16_t offsets[LeafScanner::BLOCK_SIZE];
+        bool batch = filter && (filter->flags() & FilterFlags::BATCH_NODE_FILTER);
+        FeaturePtr batchNodes[NODE_BATCH_SIZE];
+        int batchCount = 0;
+        while (pBlock)
+        {
+            uint32_t candidates;
+            const uint8_t* pNextBlock = scanner_.scanNodes(pBlock, &candidates, offsets);
+            while (candidates)
+            {
+                int i = clarisma::Bits::countTrailingZerosInNonZero(candidates);
+                candidates &= candidates - 1;
+                FeaturePtr pFeature(DataPtr(pBlock + offsets[i]) + 8);
+                if (!matcher.accept(pFeature)) continue;
+                if (batch)
+                {
+                    batchNodes[batchCount++] = pFeature;
+                    if (batchCount == NODE_BATCH_SIZE)
+                    {
+                        addNodeBatch(filter, batchNodes, batchCount);
+                        batchCount = 0;
+                    }
+                }
+                else if (filter == nullptr || filter->accept(store_,
+                    pFeature, fastFilterHint_))
+                {
+                    visitor_.foundNode(pFeature);
+                }
+            }
+            pBlock = pNextBlock;
+        }
+        if (batchCount) addNodeBatch(filter, batchNodes, batchCount);
+    }
+
+    void addNodeBatch(const Filter* filter, const FeaturePtr* nodes, int count)
+    {
+        bool accepted[NODE_BATCH_SIZE];
+        filter->acceptNodes(store_, nodes, count, fastFilterHint_, accepted);
+        for (int i = 0; i < count; i++)
+        {
+            if (accepted[i]) visitor_.foundNode(nodes[i]);
+        }
+    }
+
+    // The scanner checks the bounding boxes and types of a block of
+    // entries at once, and produces a bitmask of candidates; only these
+    // are checked by matcher and filter
+    void scanFeatureLeaf(DataPtr p, const Filter* filter)
+    {
+        const Matcher& matcher = matcher_->mainMatcher();
+        const uint8_t* pBlock = p.ptr();
+        while (pBlock)
+        {
+            uint32_t candidates;
+            const uint8_t* pNextBlock = scanner_.scanFeatures(pBlock, &candidates);
+            while (candidates)
+            {
+                int i = clarisma::Bits::countTrailingZerosInNonZero(candidates);
+                candidates &= candidates - 1;
+                FeaturePtr pFeature(DataPtr(pBlock) + (i * 32 + 16));
+                if (!matcher.accept(pFeature)) continue;
+                if (filter == nullptr || filter->accept(store_,
+                    pFeature, fastFilterHint_))
+                {
+                    visitor_.foundFeature(pFeature);
+                }
+            }
+            pBlock = pNextBlock;
+        }
+    }
+
+    Visitor& visitor_;
+    FeatureStore* store_;
+    Box bounds_;
+    FeatureTypes types_;
+    const MatcherHolder* matcher_;
+    const Filter* filter_;
+    FastFilterHint fastFilterHint_;
+    LeafScanner scanner_;
+};
+
+// \endcond
+
+} // namespace geodesk
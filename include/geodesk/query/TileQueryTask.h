@@ -12,6 +12,7 @@
 namespace geodesk {
 
 class Query;
+template <typename Visitor> class TileIndexScan;
 
 /// \cond lowlevel
 ///
@@ -22,7 +23,11 @@ public:
         query_(query),
         tipAndFlags_(tipAndFlags),
         fastFilterHint_(fastFilterHint),     
-        results_(QueryResults::EMPTY)
+        results_(QueryResults::EMPTY),
+        freeBuckets_(nullptr),
+        dupeFlag_(0),
+        partial_(0),
+        uniqueCount_(0)
     {
     }
 
@@ -32,21 +37,27 @@ public:
     void operator()();
 
 private:
-    void searchNodeIndexes();
-    void searchNodeRoot(DataPtr ppRoot);
-    void searchNodeBranch(DataPtr p);
-    void searchNodeLeaf(DataPtr p);
-    void searchIndexes(FeatureIndexType indexType);
-    void searchRoot(DataPtr ppRoot);
-    void searchBranch(DataPtr p);
-    void searchLeaf(DataPtr p);
+    // Callbacks of TileIndexScan
+    bool isStopped() const;
+    void foundNode(FeaturePtr node);
+    void foundFeature(FeaturePtr feature);
+
     void addResult(uint32_t item);
+    QueryResults* allocateResults();
+
+    friend class TileIndexScan<TileQueryTask>;
 
     Query* query_;
     uint32_t tipAndFlags_;
     FastFilterHint fastFilterHint_;
     DataPtr pTile_;
+    TilePin tilePin_;
     QueryResults* results_;
+    QueryResults* freeBuckets_;
+    uint32_t dupeFlag_;     // REQUIRES_DEDUP, or 0 if the query lies within the tile
+    double partial_;        // used only by aggregating queries
+    uint32_t uniqueCount_;  // results (other than potential duplicates)
+                            // not yet reported to the Query
 };
 
 // \endcond
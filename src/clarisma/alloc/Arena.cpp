@@ -85,6 +85,7 @@ void Arena::allocChunk(size_t size)
 	current_ = newChunk;
 	p_ = newChunkRaw + sizeof(Chunk);
 	end_ = p_ + size;
+	capacity_ += size;
 	// Console::debug("******** Allocating chunk with %lld bytes, p = %p", size, p_);
 }
 } // namespace clarisma
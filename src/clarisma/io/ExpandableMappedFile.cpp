@@ -41,7 +41,7 @@ void ExpandableMappedFile::open(const char* filename, int /* OpenMode */ mode)
 		mainMappingSize_ = fileSize;
 	}
 	mainMapping_ = reinterpret_cast<byte*>(map(0, mainMappingSize_,
-		mode & (MappingMode::READ | MappingMode::WRITE)));
+		mode & (MappingMode::READ | MappingMode::WRITE | MappingMode::POPULATE)));
 	// Console::msg("Created main mapping at %p (size %llu)", mainMapping_, mainMappingSize_);
 }
 
@@ -3,6 +3,7 @@
 
 #include <clarisma/io/MappedFile.h>
 #include <stdexcept>
+#include <vector>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -13,7 +14,11 @@ namespace clarisma {
 void* MappedFile::map(uint64_t offset, uint64_t length, int mode)
 {
     int prot = (mode & MappingMode::WRITE) ? (PROT_READ | PROT_WRITE) : PROT_READ;
-    void* mappedAddress = mmap(nullptr, length, prot, MAP_SHARED, fileHandle_, offset);
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (mode & MappingMode::POPULATE) flags |= MAP_POPULATE;
+#endif
+    void* mappedAddress = mmap(nullptr, length, prot, flags, fileHandle_, offset);
     if (mappedAddress == MAP_FAILED)
     {
         // Error mapping file
@@ -40,11 +45,72 @@ void MappedFile::unmap(void* address, uint64_t length)
 
 void MappedFile::prefetch(void* address, uint64_t length)
 {
+    // madvise() requires a page-aligned address
+    uintptr_t pageMask = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE)) - 1;
+    uintptr_t start = reinterpret_cast<uintptr_t>(address) & ~pageMask;
+    length += reinterpret_cast<uintptr_t>(address) - start;
+    address = reinterpret_cast<void*>(start);
     if (madvise(address, length, MADV_WILLNEED) != 0)
     {
         IOException::checkAndThrow();
     }
 }
 
+
+uint64_t MappedFile::residentBytes(const void* address, uint64_t length)
+{
+    uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = reinterpret_cast<uintptr_t>(address) & ~(pageSize - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(address) + length;
+    size_t pageCount = (end - start + pageSize - 1) / pageSize;
+#ifdef __APPLE__
+    std::vector<char> pages(pageCount);
+#else
+    std::vector<unsigned char> pages(pageCount);
+#endif
+    if (mincore(reinterpret_cast<void*>(start), end - start, pages.data()) != 0)
+    {
+        IOException::checkAndThrow();
+    }
+    uint64_t count = 0;
+    for (auto page : pages) count += page & 1;
+    return count * pageSize;
+}
+
+bool MappedFile::lock(const void* address, uint64_t length)
+{
+    return mlock(address, length) == 0;
+}
+
+bool MappedFile::advise(const void* address, uint64_t length, Advice advice)
+{
+    int flag;
+    switch (advice)
+    {
+    case Advice::NORMAL:
+        flag = MADV_NORMAL;
+        break;
+    case Advice::RANDOM:
+        flag = MADV_RANDOM;
+        break;
+    case Advice::SEQUENTIAL:
+        flag = MADV_SEQUENTIAL;
+        break;
+    case Advice::HUGE_PAGES:
+#ifdef MADV_HUGEPAGE
+        flag = MADV_HUGEPAGE;
+        break;
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+    uintptr_t pageMask = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE)) - 1;
+    uintptr_t start = reinterpret_cast<uintptr_t>(address) & ~pageMask;
+    length += reinterpret_cast<uintptr_t>(address) - start;
+    return madvise(reinterpret_cast<void*>(start), length, flag) == 0;
+}
+
 } // namespace clarisma
 
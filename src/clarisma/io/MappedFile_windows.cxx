@@ -3,6 +3,8 @@
 
 #include <clarisma/io/MappedFile.h>
 #include <memoryapi.h>
+#include <psapi.h>
+#include <vector>
 
 namespace clarisma {
 
@@ -34,6 +36,12 @@ void* MappedFile::map(uint64_t offset, uint64_t length, int mode)
         // Error mapping view of file
         IOException::checkAndThrow();
     }
+    if (mode & MappingMode::POPULATE)
+    {
+        // Windows has no equivalent of MAP_POPULATE, so the best
+        // we can do is to start reading the pages in the background
+        prefetch(mappedAddress, length);
+    }
     return mappedAddress;
 }
 
@@ -56,5 +64,40 @@ void MappedFile::prefetch(void* address, uint64_t length)
     PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
 }
 
+uint64_t MappedFile::residentBytes(const void* address, uint64_t length)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    uint64_t pageSize = info.dwPageSize;
+    uintptr_t start = reinterpret_cast<uintptr_t>(address) & ~(pageSize - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(address) + length;
+    size_t pageCount = (end - start + pageSize - 1) / pageSize;
+    std::vector<PSAPI_WORKING_SET_EX_INFORMATION> pages(pageCount);
+    for (size_t i = 0; i < pageCount; i++)
+    {
+        pages[i].VirtualAddress = reinterpret_cast<void*>(start + i * pageSize);
+    }
+    if (!QueryWorkingSetEx(GetCurrentProcess(), pages.data(),
+        static_cast<DWORD>(pageCount * sizeof(PSAPI_WORKING_SET_EX_INFORMATION))))
+    {
+        IOException::checkAndThrow();
+    }
+    uint64_t count = 0;
+    for (const auto& page : pages) count += page.VirtualAttributes.Valid;
+    return count * pageSize;
+}
+
+bool MappedFile::lock(const void* address, uint64_t length)
+{
+    return VirtualLock(const_cast<void*>(address), length) != 0;
+}
+
+bool MappedFile::advise(const void* /* address */, uint64_t /* length */, Advice advice)
+{
+    // Windows does not take read-ahead hints for existing views, and
+    // large pages are not available for file mappings
+    return advice == Advice::NORMAL;
+}
+
 } // namespace clarisma
 
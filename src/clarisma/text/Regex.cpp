@@ -0,0 +1,820 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <clarisma/text/Regex.h>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <utility>
+
+namespace clarisma {
+
+namespace {
+
+struct RegexNode
+{
+    enum Kind
+    {
+        EMPTY,
+        BYTES,
+        CONCAT,
+        ALTERNATE,
+        REPEAT,
+        BEGIN,
+        END
+    };
+
+    explicit RegexNode(Kind k) : kind(k) {}
+
+    /// Returns the byte, if this node matches exactly one byte
+    bool isLiteral(uint8_t* pByte) const
+    {
+        if (kind != BYTES) return false;
+        int count = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            if (bytes.contains(static_cast<uint8_t>(b)))
+            {
+                *pByte = static_cast<uint8_t>(b);
+                count++;
+            }
+        }
+        return count == 1;
+    }
+
+    Kind kind;
+    int min = 0;
+    int max = 0;                // -1 = unbounded
+    Regex::ByteSet bytes;
+    std::vector<RegexNode> children;
+};
+
+
+class RegexParser
+{
+public:
+    explicit RegexParser(std::string_view pattern) :
+        p_(pattern.data()),
+        end_(pattern.data() + pattern.size())
+    {
+    }
+
+    RegexNode parse()
+    {
+        RegexNode root = alternation(0);
+        if (p_ != end_) error("Unmatched ')'");
+        return root;
+    }
+
+private:
+    static constexpr int MAX_NESTING = 256;
+    static constexpr int MAX_REPEAT = 1000;
+
+    [[noreturn]] static void error(const char* msg)
+    {
+        throw RegexException(msg);
+    }
+
+    bool atEnd() const { return p_ == end_; }
+    char peek() const { return *p_; }
+
+    RegexNode alternation(int depth)
+    {
+        if (depth > MAX_NESTING) error("Regex is nested too deeply");
+        RegexNode first = concatenation(depth);
+        if (atEnd() || peek() != '|') return first;
+        RegexNode alt(RegexNode::ALTERNATE);
+        alt.children.push_back(std::move(first));
+        while (!atEnd() && peek() == '|')
+        {
+            p_++;
+            alt.children.push_back(concatenation(depth));
+        }
+        return alt;
+    }
+
+    RegexNode concatenation(int depth)
+    {
+        RegexNode seq(RegexNode::CONCAT);
+        while (!atEnd() && peek() != '|' && peek() != ')')
+        {
+            RegexNode node = quantified(atom(depth));
+            if (node.kind == RegexNode::CONCAT)
+            {
+                for (RegexNode& child : node.children)
+                {
+                    seq.children.push_back(std::move(child));
+                }
+            }
+            else if (node.kind != RegexNode::EMPTY)
+            {
+                seq.children.push_back(std::move(node));
+            }
+        }
+        if (seq.children.empty()) return RegexNode(RegexNode::EMPTY);
+        if (seq.children.size() == 1) return std::move(seq.children[0]);
+        return seq;
+    }
+
+    RegexNode quantified(RegexNode node)
+    {
+        if (atEnd()) return node;
+        int min, max;
+        const char* start = p_;
+        switch (peek())
+        {
+        case '*':
+            min = 0;
+            max = -1;
+            p_++;
+            break;
+        case '+':
+            min = 1;
+            max = -1;
+            p_++;
+            break;
+        case '?':
+            min = 0;
+            max = 1;
+            p_++;
+            break;
+        case '{':
+            if (!repetition(&min, &max))
+            {
+                p_ = start;     // not a quantifier, '{' is a literal
+                return node;
+            }
+            break;
+        default:
+            return node;
+        }
+        if (node.kind == RegexNode::BEGIN || node.kind == RegexNode::END)
+        {
+            error("Nothing to repeat");
+        }
+        if (!atEnd() && peek() == '?') p_++;
+            // Lazy and greedy quantifiers accept the same strings
+        if (!atEnd() && (peek() == '*' || peek() == '+' || peek() == '?'))
+        {
+            error("Nothing to repeat");
+        }
+        RegexNode repeat(RegexNode::REPEAT);
+        repeat.min = min;
+        repeat.max = max;
+        repeat.children.push_back(std::move(node));
+        return repeat;
+    }
+
+    bool repetition(int* pMin, int* pMax)
+    {
+        p_++;   // '{'
+        if (!number(pMin)) return false;
+        *pMax = *pMin;
+        if (!atEnd() && peek() == ',')
+        {
+            p_++;
+            if (!number(pMax)) *pMax = -1;
+        }
+        if (atEnd() || peek() != '}') return false;
+        p_++;
+        if (*pMax >= 0 && *pMax < *pMin) error("Invalid range in {}");
+        return true;
+    }
+
+    bool number(int* pValue)
+    {
+        if (atEnd() || peek() < '0' || peek() > '9') return false;
+        int n = 0;
+        while (!atEnd() && peek() >= '0' && peek() <= '9')
+        {
+            n = n * 10 + (*p_++ - '0');
+            if (n > MAX_REPEAT) error("Repetition count is too large");
+        }
+        *pValue = n;
+        return true;
+    }
+
+    RegexNode atom(int depth)
+    {
+        char ch = *p_++;
+        switch (ch)
+        {
+        case '(':
+        {
+            if (!atEnd() && peek() == '?')
+            {
+                if (end_ - p_ < 2 || p_[1] != ':')
+                {
+                    error("Lookaround and named groups are not supported");
+                }
+                p_ += 2;
+            }
+            RegexNode node = alternation(depth + 1);
+            if (atEnd() || peek() != ')') error("Missing ')'");
+            p_++;
+            return node;
+        }
+        case '[':
+            return characterClass();
+        case '.':
+        {
+            RegexNode node(RegexNode::BYTES);
+            node.bytes.invert();
+            node.bytes.bits['\n' >> 6] &= ~(uint64_t{1} << ('\n' & 63));
+            node.bytes.bits['\r' >> 6] &= ~(uint64_t{1} << ('\r' & 63));
+            return node;
+        }
+        case '^':
+            return RegexNode(RegexNode::BEGIN);
+        case '$':
+            return RegexNode(RegexNode::END);
+        case '*':
+        case '+':
+        case '?':
+            error("Nothing to repeat");
+        case '\\':
+            return escape();
+        default:
+            return literal(static_cast<uint8_t>(ch));
+        }
+    }
+
+    static RegexNode literal(uint8_t b)
+    {
+        RegexNode node(RegexNode::BYTES);
+        node.bytes.add(b);
+        return node;
+    }
+
+    static bool classEscape(char ch, Regex::ByteSet& set)
+    {
+        Regex::ByteSet s;
+        switch (ch)
+        {
+        case 'd':
+        case 'D':
+            s.addRange('0', '9');
+            break;
+        case 'w':
+        case 'W':
+            s.addRange('a', 'z');
+            s.addRange('A', 'Z');
+            s.addRange('0', '9');
+            s.add('_');
+            break;
+        case 's':
+        case 'S':
+            s.add(' ');
+            s.addRange('\t', '\r');     // \t \n \v \f \r
+            break;
+        default:
+            return false;
+        }
+        if (ch >= 'A' && ch <= 'Z') s.invert();
+        set.add(s);
+        return true;
+    }
+
+    int hexDigits(int count)
+    {
+        int value = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (atEnd()) error("Invalid escape");
+            char ch = *p_++;
+            int digit;
+            if (ch >= '0' && ch <= '9')
+            {
+                digit = ch - '0';
+            }
+            else if (ch >= 'a' && ch <= 'f')
+            {
+                digit = ch - 'a' + 10;
+            }
+            else if (ch >= 'A' && ch <= 'F')
+            {
+                digit = ch - 'A' + 10;
+            }
+            else
+            {
+                error("Invalid escape");
+            }
+            value = (value << 4) | digit;
+        }
+        return value;
+    }
+
+    /// Parses a single-character escape (after the backslash);
+    /// returns the code point, or -1 if it is a class escape
+    int characterEscape(bool inClass)
+    {
+        if (atEnd()) error("Trailing backslash");
+        char ch = *p_++;
+        switch (ch)
+        {
+        case 't': return '\t';
+        case 'n': return '\n';
+        case 'r': return '\r';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        case '0': return 0;
+        case 'x': return hexDigits(2);
+        case 'u': return hexDigits(4);
+        case 'b':
+            if (inClass) return '\b';
+            error("Word boundaries are not supported");
+        case 'B':
+            error("Word boundaries are not supported");
+        case 'd': case 'D': case 'w': case 'W': case 's': case 'S':
+            p_--;
+            return -1;
+        default:
+            if (ch >= '1' && ch <= '9') error("Backreferences are not supported");
+            return static_cast<uint8_t>(ch);
+        }
+    }
+
+    RegexNode escape()
+    {
+        int cp = characterEscape(false);
+        if (cp < 0)
+        {
+            RegexNode node(RegexNode::BYTES);
+            classEscape(*p_++, node.bytes);
+            return node;
+        }
+        if (cp < 0x80) return literal(static_cast<uint8_t>(cp));
+
+        // A code point outside the ASCII range matches its UTF-8 encoding
+        RegexNode seq(RegexNode::CONCAT);
+        if (cp < 0x800)
+        {
+            seq.children.push_back(literal(static_cast<uint8_t>(0xc0 | (cp >> 6))));
+        }
+        else
+        {
+            seq.children.push_back(literal(static_cast<uint8_t>(0xe0 | (cp >> 12))));
+            seq.children.push_back(literal(static_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3f))));
+        }
+        seq.children.push_back(literal(static_cast<uint8_t>(0x80 | (cp & 0x3f))));
+        return seq;
+    }
+
+    RegexNode characterClass()
+    {
+        RegexNode node(RegexNode::BYTES);
+        bool negated = false;
+        if (!atEnd() && peek() == '^')
+        {
+            negated = true;
+            p_++;
+        }
+        for (;;)
+        {
+            if (atEnd()) error("Missing ']'");
+            char ch = *p_++;
+            if (ch == ']') break;
+            int from;
+            if (ch == '\\')
+            {
+                from = characterEscape(true);
+                if (from < 0)
+                {
+                    classEscape(*p_++, node.bytes);
+                    continue;
+                }
+            }
+            else
+            {
+                from = static_cast<uint8_t>(ch);
+            }
+            int to = from;
+            if (end_ - p_ >= 2 && peek() == '-' && p_[1] != ']')
+            {
+                p_++;
+                ch = *p_++;
+                if (ch == '\\')
+                {
+                    to = characterEscape(true);
+                    if (to < 0) error("Invalid range in character class");
+                }
+                else
+                {
+                    to = static_cast<uint8_t>(ch);
+                }
+                if (to < from) error("Invalid range in character class");
+            }
+            if (to > 0x7f) error("Non-ASCII escapes are not supported in character classes");
+            node.bytes.addRange(static_cast<uint8_t>(from), static_cast<uint8_t>(to));
+        }
+        if (negated) node.bytes.invert();
+        return node;
+    }
+
+    const char* p_;
+    const char* end_;
+};
+
+} // anonymous namespace
+
+
+class RegexCompiler
+{
+public:
+    explicit RegexCompiler(Regex& regex) : regex_(regex) {}
+
+    void compile(const RegexNode& root)
+    {
+        emit(root);
+        add(Regex::Instruction::MATCH);
+        extractLiterals(root);
+    }
+
+private:
+    using Instruction = Regex::Instruction;
+
+    size_t add(Instruction::Opcode opcode, int32_t x = 0, int32_t y = 0)
+    {
+        std::vector<Instruction>& program = regex_.program_;
+        if (program.size() >= Regex::MAX_PROGRAM_SIZE)
+        {
+            throw RegexException("Regex is too complex");
+        }
+        program.push_back({ opcode, x, y });
+        return program.size() - 1;
+    }
+
+    int32_t here() const
+    {
+        return static_cast<int32_t>(regex_.program_.size());
+    }
+
+    int32_t setIndex(const Regex::ByteSet& set)
+    {
+        std::vector<Regex::ByteSet>& sets = regex_.sets_;
+        for (size_t i = 0; i < sets.size(); i++)
+        {
+            if (sets[i] == set) return static_cast<int32_t>(i);
+        }
+        sets.push_back(set);
+        return static_cast<int32_t>(sets.size() - 1);
+    }
+
+    void emit(const RegexNode& node)
+    {
+        std::vector<Instruction>& program = regex_.program_;
+        switch (node.kind)
+        {
+        case RegexNode::EMPTY:
+            break;
+        case RegexNode::BYTES:
+            add(Instruction::BYTES, setIndex(node.bytes));
+            break;
+        case RegexNode::CONCAT:
+            for (const RegexNode& child : node.children) emit(child);
+            break;
+        case RegexNode::ALTERNATE:
+        {
+            std::vector<size_t> jumps;
+            for (size_t i = 0; i < node.children.size(); i++)
+            {
+                if (i == node.children.size() - 1)
+                {
+                    emit(node.children[i]);
+                    break;
+                }
+                size_t split = add(Instruction::SPLIT, here() + 1);
+                emit(node.children[i]);
+                jumps.push_back(add(Instruction::JUMP));
+                program[split].y = here();
+            }
+            for (size_t jump : jumps) program[jump].x = here();
+            break;
+        }
+        case RegexNode::REPEAT:
+        {
+            const RegexNode& child = node.children[0];
+            for (int i = 0; i < node.min; i++) emit(child);
+            if (node.max < 0)
+            {
+                size_t loop = add(Instruction::SPLIT, here() + 1);
+                emit(child);
+                add(Instruction::JUMP, static_cast<int32_t>(loop));
+                program[loop].y = here();
+            }
+            else
+            {
+                std::vector<size_t> splits;
+                for (int i = node.min; i < node.max; i++)
+                {
+                    splits.push_back(add(Instruction::SPLIT, here() + 1));
+                    emit(child);
+                }
+                for (size_t split : splits) program[split].y = here();
+            }
+            break;
+        }
+        case RegexNode::BEGIN:
+            add(Instruction::BEGIN);
+            break;
+        case RegexNode::END:
+            add(Instruction::END);
+            break;
+        }
+    }
+
+    // Looks for literal text at the top level of the pattern. Since
+    // the entire string must match, anchors at the start or end of
+    // the pattern have no effect, and can be skipped.
+
+    void extractLiterals(const RegexNode& root)
+    {
+        std::vector<const RegexNode*> seq;
+        if (root.kind == RegexNode::CONCAT)
+        {
+            for (const RegexNode& child : root.children) seq.push_back(&child);
+        }
+        else if (root.kind != RegexNode::EMPTY)
+        {
+            seq.push_back(&root);
+        }
+        size_t start = 0;
+        size_t end = seq.size();
+        while (start < end && seq[start]->kind == RegexNode::BEGIN) start++;
+        while (end > start && seq[end - 1]->kind == RegexNode::END) end--;
+
+        std::string run;
+        std::string longest;
+        bool allLiteral = true;
+        for (size_t i = start; i < end; i++)
+        {
+            uint8_t b;
+            if (seq[i]->isLiteral(&b))
+            {
+                run += static_cast<char>(b);
+                continue;
+            }
+            if (allLiteral) regex_.prefix_ = run;
+            allLiteral = false;
+            if (run.size() > longest.size()) longest = run;
+            run.clear();
+        }
+
+        regex_.isLiteral_ = allLiteral;
+        if (allLiteral)
+        {
+            regex_.prefix_ = run;
+            return;
+        }
+        regex_.suffix_ = run;
+        if (run.size() > longest.size()) longest = run;
+        if (longest.size() > regex_.prefix_.size() &&
+            longest.size() > regex_.suffix_.size())
+        {
+            regex_.required_ = std::move(longest);
+        }
+    }
+
+    Regex& regex_;
+};
+
+
+Regex::Regex(std::string_view pattern) :
+    classCount_(0),
+    isLiteral_(false)
+{
+    RegexParser parser(pattern);
+    RegexNode root = parser.parse();
+    RegexCompiler compiler(*this);
+    compiler.compile(root);
+    if (isLiteral_) return;     // no automaton needed
+    buildByteClasses();
+    buildDfa();
+}
+
+
+/// Partitions the bytes into classes, so that all bytes of a class
+/// are treated the same by every instruction. The DFA then only needs
+/// one transition per class, rather than per byte.
+void Regex::buildByteClasses()
+{
+    memset(byteClasses_, 0, sizeof(byteClasses_));
+    classCount_ = 1;
+    for (const ByteSet& set : sets_)
+    {
+        int remap[512];
+        std::fill(std::begin(remap), std::end(remap), -1);
+        int count = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            int key = byteClasses_[b] * 2 + set.contains(static_cast<uint8_t>(b));
+            if (remap[key] < 0) remap[key] = count++;
+            byteClasses_[b] = static_cast<uint8_t>(remap[key]);
+        }
+        classCount_ = count;
+    }
+}
+
+
+void Regex::Scratch::newGeneration(size_t programSize)
+{
+    if (visited.size() < programSize) visited.resize(programSize, 0);
+    if (++generation == 0)
+    {
+        // Wrapped around: marks of the oldest generations would
+        // look current again
+        std::fill(visited.begin(), visited.end(), 0);
+        generation = 1;
+    }
+}
+
+
+void Regex::addClosure(int32_t pc, bool atStart, bool atEnd, Threads& threads,
+    Scratch& scratch, bool* matched) const
+{
+    Threads& stack = scratch.stack;
+    stack.clear();
+    stack.push_back(pc);
+    while (!stack.empty())
+    {
+        pc = stack.back();
+        stack.pop_back();
+        if (!scratch.visit(pc)) continue;
+        const Instruction& inst = program_[pc];
+        switch (inst.opcode)
+        {
+        case Instruction::BYTES:
+            if (!atEnd) threads.push_back(pc);
+            break;
+        case Instruction::SPLIT:
+            stack.push_back(inst.y);
+            stack.push_back(inst.x);
+            break;
+        case Instruction::JUMP:
+            stack.push_back(inst.x);
+            break;
+        case Instruction::BEGIN:
+            if (atStart) stack.push_back(pc + 1);
+            break;
+        case Instruction::END:
+            if (atEnd)
+            {
+                stack.push_back(pc + 1);
+            }
+            else
+            {
+                threads.push_back(pc);     // waits for the end of input
+            }
+            break;
+        case Instruction::MATCH:
+            if (matched) *matched = true;
+            if (!atEnd) threads.push_back(pc);
+            break;
+        }
+    }
+}
+
+
+void Regex::start(Threads& threads, Scratch& scratch) const
+{
+    threads.clear();
+    scratch.newGeneration(program_.size());
+    addClosure(0, true, false, threads, scratch, nullptr);
+    std::sort(threads.begin(), threads.end());
+}
+
+
+void Regex::step(const Threads& current, uint8_t b, Threads& next,
+    Scratch& scratch) const
+{
+    next.clear();
+    scratch.newGeneration(program_.size());
+    for (int32_t pc : current)
+    {
+        const Instruction& inst = program_[pc];
+        if (inst.opcode == Instruction::BYTES && sets_[inst.x].contains(b))
+        {
+            addClosure(pc + 1, false, false, next, scratch, nullptr);
+        }
+    }
+    std::sort(next.begin(), next.end());
+}
+
+
+bool Regex::accepts(const Threads& threads, bool atStart, Scratch& scratch) const
+{
+    scratch.newGeneration(program_.size());
+    bool matched = false;
+    Threads none;
+    for (int32_t pc : threads)
+    {
+        Instruction::Opcode op = program_[pc].opcode;
+        if (op == Instruction::MATCH) return true;
+        if (op == Instruction::END)
+        {
+            addClosure(pc + 1, atStart, true, none, scratch, &matched);
+            if (matched) return true;
+        }
+    }
+    return false;
+}
+
+
+/// Converts the NFA into a DFA via subset construction. State 0 is the
+/// dead state, state 1 the start state. We give up (and simulate the
+/// NFA instead) if the DFA grows too large.
+void Regex::buildDfa()
+{
+    Scratch scratch;
+    uint8_t representatives[256];
+    for (int b = 255; b >= 0; b--) representatives[byteClasses_[b]] = static_cast<uint8_t>(b);
+
+    // The start state is the only one that can pass a ^ anchor, so
+    // we mark it with a sentinel to keep it apart from any other
+    // state with the same threads
+    std::map<Threads, uint32_t> states;
+    std::vector<Threads> pending;
+    Threads dead;
+    Threads startThreads;
+    start(startThreads, scratch);
+    startThreads.push_back(-1);
+    states[dead] = 0;
+    states[startThreads] = 1;
+    pending.push_back(dead);
+    pending.push_back(startThreads);
+
+    Threads next;
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+        if (pending.size() > MAX_DFA_STATES)
+        {
+            transitions_.clear();
+            accepting_.clear();
+            return;
+        }
+        Threads current = pending[i];
+        bool atStart = !current.empty() && current.back() == -1;
+        if (atStart) current.pop_back();
+        accepting_.push_back(accepts(current, atStart, scratch));
+        for (int c = 0; c < classCount_; c++)
+        {
+            step(current, representatives[c], next, scratch);
+            auto it = states.find(next);
+            uint32_t target;
+            if (it == states.end())
+            {
+                target = static_cast<uint32_t>(pending.size());
+                states.emplace(next, target);
+                pending.push_back(next);
+            }
+            else
+            {
+                target = it->second;
+            }
+            transitions_.push_back(target);
+        }
+    }
+}
+
+
+bool Regex::matchNfa(std::string_view s) const
+{
+    static thread_local Scratch scratch;
+    Threads& current = scratch.current;
+    Threads& next = scratch.next;
+    start(current, scratch);
+    bool atStart = true;
+    for (char ch : s)
+    {
+        step(current, static_cast<uint8_t>(ch), next, scratch);
+        if (next.empty()) return false;
+        std::swap(current, next);
+        atStart = false;
+    }
+    return accepts(current, atStart, scratch);
+}
+
+
+bool Regex::match(std::string_view s) const
+{
+    if (isLiteral_) return s == prefix_;
+    if (s.size() < prefix_.size() + suffix_.size()) return false;
+    if (s.compare(0, prefix_.size(), prefix_) != 0) return false;
+    if (s.compare(s.size() - suffix_.size(), suffix_.size(), suffix_) != 0) return false;
+    if (!required_.empty() && s.find(required_) == std::string_view::npos) return false;
+        // The prefix and suffix are separated by at least one
+        // non-literal element of the pattern, so they never overlap
+
+    if (transitions_.empty()) return matchNfa(s);
+
+    const uint32_t* transitions = transitions_.data();
+    uint32_t state = 1;
+    for (char ch : s)
+    {
+        state = transitions[state * classCount_ + byteClasses_[static_cast<uint8_t>(ch)]];
+        if (state == 0) return false;
+    }
+    return accepting_[state];
+}
+
+} // namespace clarisma
@@ -0,0 +1,161 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <clarisma/util/Lz4.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace clarisma {
+
+namespace {
+
+inline uint32_t read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint8_t* writeLength(uint8_t* p, size_t len)
+{
+    while (len >= 255)
+    {
+        *p++ = 255;
+        len -= 255;
+    }
+    *p++ = static_cast<uint8_t>(len);
+    return p;
+}
+
+inline size_t readLength(const uint8_t* src, size_t srcLen, size_t& ip)
+{
+    size_t len = 0;
+    uint8_t b;
+    do
+    {
+        if (ip >= srcLen) throw Lz4Exception("Truncated LZ4 block");
+        b = src[ip++];
+        len += b;
+    }
+    while (b == 255);
+    return len;
+}
+
+} // namespace
+
+
+// A greedy single-pass compressor: each position is looked up in a
+// hash table of recently seen 4-byte sequences. This is the same
+// strategy as LZ4's fast mode, without the acceleration heuristics.
+
+size_t Lz4::compress(const uint8_t* src, size_t size, uint8_t* dest)
+{
+    constexpr uint32_t NONE = 0xffff'ffff;
+    std::unique_ptr<uint32_t[]> table(new uint32_t[size_t{1} << HASH_BITS]);
+    std::fill_n(table.get(), size_t{1} << HASH_BITS, NONE);
+
+    uint8_t* op = dest;
+    size_t anchor = 0;
+    size_t ip = 0;
+    size_t limit = size > MATCH_SAFE_DISTANCE ? size - MATCH_SAFE_DISTANCE : 0;
+    size_t maxMatchEnd = size - LAST_LITERALS;
+
+    while (ip < limit)
+    {
+        uint32_t seq = read32(src + ip);
+        uint32_t hash = (seq * 2654435761U) >> (32 - HASH_BITS);
+        uint32_t ref = table[hash];
+        table[hash] = static_cast<uint32_t>(ip);
+        if (ref == NONE || ip - ref > MAX_DISTANCE || read32(src + ref) != seq)
+        {
+            ip++;
+            continue;
+        }
+
+        size_t matchEnd = ip + MIN_MATCH;
+        while (matchEnd < maxMatchEnd && src[matchEnd] == src[ref + matchEnd - ip])
+        {
+            matchEnd++;
+        }
+
+        size_t literalCount = ip - anchor;
+        size_t matchLen = matchEnd - ip - MIN_MATCH;
+        uint8_t* token = op++;
+        *token = static_cast<uint8_t>(
+            ((literalCount < 15 ? literalCount : 15) << 4) |
+            (matchLen < 15 ? matchLen : 15));
+        if (literalCount >= 15) op = writeLength(op, literalCount - 15);
+        memcpy(op, src + anchor, literalCount);
+        op += literalCount;
+        uint32_t distance = static_cast<uint32_t>(ip - ref);
+        *op++ = static_cast<uint8_t>(distance);
+        *op++ = static_cast<uint8_t>(distance >> 8);
+        if (matchLen >= 15) op = writeLength(op, matchLen - 15);
+
+        ip = matchEnd;
+        anchor = ip;
+    }
+
+    // The block always ends with a run of literals
+    size_t literalCount = size - anchor;
+    *op++ = static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4);
+    if (literalCount >= 15) op = writeLength(op, literalCount - 15);
+    memcpy(op, src + anchor, literalCount);
+    op += literalCount;
+    return op - dest;
+}
+
+
+void Lz4::decompress(const uint8_t* src, size_t compressedSize,
+    uint8_t* dest, size_t size)
+{
+    size_t ip = 0;
+    size_t op = 0;
+    for (;;)
+    {
+        if (ip >= compressedSize) throw Lz4Exception("Truncated LZ4 block");
+        uint8_t token = src[ip++];
+
+        size_t literalCount = token >> 4;
+        if (literalCount == 15) literalCount += readLength(src, compressedSize, ip);
+        if (literalCount > compressedSize - ip || literalCount > size - op)
+        {
+            throw Lz4Exception("Invalid literal length in LZ4 block");
+        }
+        memcpy(dest + op, src + ip, literalCount);
+        ip += literalCount;
+        op += literalCount;
+        if (ip == compressedSize) break;        // last sequence has no match
+
+        if (compressedSize - ip < 2) throw Lz4Exception("Truncated LZ4 block");
+        size_t distance = src[ip] | (static_cast<size_t>(src[ip + 1]) << 8);
+        ip += 2;
+        if (distance == 0 || distance > op)
+        {
+            throw Lz4Exception("Invalid match distance in LZ4 block");
+        }
+        size_t matchLen = token & 15;
+        if (matchLen == 15) matchLen += readLength(src, compressedSize, ip);
+        matchLen += MIN_MATCH;
+        if (matchLen > size - op)
+        {
+            throw Lz4Exception("Invalid match length in LZ4 block");
+        }
+
+        const uint8_t* match = dest + op - distance;
+        if (distance >= matchLen)
+        {
+            memcpy(dest + op, match, matchLen);
+        }
+        else
+        {
+            // Overlapping copy (repeats the last `distance` bytes)
+            for (size_t i = 0; i < matchLen; i++) dest[op + i] = match[i];
+        }
+        op += matchLen;
+    }
+    if (op != size) throw Lz4Exception("LZ4 block has the wrong size");
+}
+
+} // namespace clarisma
@@ -56,7 +56,7 @@ FeaturePtr FastMemberIterator::next()
         if (!pForeignTile_)
         {
             // foreign tile not resolved yet
-            pForeignTile_ = store_->fetchTile(currentTip_);
+            pForeignTile_ = store_->fetchTile(currentTip_, foreignTilePin_);
         }
         feature = FeaturePtr(pForeignTile_ +
             ((currentMember_ & 0xffff'fff0) >> 2));
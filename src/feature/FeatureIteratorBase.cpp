@@ -19,8 +19,24 @@ enum IterType
 };
 
 
+// Query options for a view that may be limited: If the caller only
+// wants a handful of features, we also use smaller buckets, so the
+// first results are handed over sooner
+static Query::Options queryOptions(const View& view)
+{
+    Query::Options options;
+    options.limit = view.limit();
+    options.prefetchDistance = view.store()->prefetchDistance();
+    if (options.limit < options.bucketSize)
+    {
+        options.bucketSize = static_cast<uint32_t>(options.limit);
+    }
+    return options;
+}
+
 FeatureIteratorBase::FeatureIteratorBase(const View& view) :
-    current_(view.store())
+    current_(view.store()),
+    remaining_(view.limit())
 {
     switch (view.view())
     {
@@ -33,7 +49,7 @@ FeatureIteratorBase::FeatureIteratorBase(const View& view) :
     case View::WORLD:
         type_ = WORLD;
         new (&storage_.worldQuery) Query(view.store(), view.bounds(),
-            view.types(), view.matcher(), view.filter());
+            view.types(), view.matcher(), view.filter(), queryOptions(view));
         break;
     case View::MEMBERS:
         type_ = RELATION_MEMBERS;
@@ -103,7 +119,8 @@ void FeatureIteratorBase::initParentWaysIterator(const View& view)
     }
     new (&storage_.parents.parentWayQuery) Query(
         view.store(), Box(xy),
-        view.types() & FeatureTypes::WAYS, view.matcher(), filter);
+        view.types() & FeatureTypes::WAYS, view.matcher(), filter,
+        queryOptions(view));
 }
 
 void FeatureIteratorBase::initParentRelationsIterator(FeatureStore* store, FeaturePtr member,
@@ -196,6 +213,19 @@ void FeatureIteratorBase::switchToParentRelationsIterator()
 }
 
 void FeatureIteratorBase::fetchNext()
+{
+    if (remaining_ == 0) [[unlikely]]
+    {
+        // The view's limit has been reached (a world query
+        // enforces the limit itself, but the other iterators don't)
+        current_.setNull();
+        return;
+    }
+    remaining_--;
+    fetchNextUnlimited();
+}
+
+void FeatureIteratorBase::fetchNextUnlimited()
 {
     switch (type_)
     {
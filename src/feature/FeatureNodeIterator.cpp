@@ -50,7 +50,7 @@ NodePtr FeatureNodeIterator::next()
                 }
                 tipDelta >>= 1;     // signed
                 currentTip_ += tipDelta;
-                pForeignTile_ = store_->fetchTile(currentTip_);
+                pForeignTile_ = store_->fetchTile(currentTip_, foreignTilePin_);
             }
             feature = NodePtr(pForeignTile_ + ((currentNode_ & 0xffff'fff0) >> 2));
         }
@@ -2,7 +2,12 @@
 // SPDX-License-Identifier: LGPL-3.0-only
 
 #include <geodesk/feature/FeatureStore.h>
+#include <algorithm>
 #include <filesystem>
+#include <thread>
+#include <geodesk/query/TileIndexWalker.h>
+#include <clarisma/thread/Threads.h>
+#include <clarisma/util/Crc32.h>
 #include <clarisma/util/log.h>
 #include <clarisma/util/PbfDecoder.h>
 #ifdef GEODESK_PYTHON
@@ -27,11 +32,15 @@ FeatureStore::FeatureStore()
 	emptyTags_(nullptr),
 	emptyFeatures_(nullptr),
 	#endif
-	executor_(/* 1 */ std::thread::hardware_concurrency(), 0)  // TODO: disabled for testing
+	executor_(/* 1 */ std::thread::hardware_concurrency(), 0),  // TODO: disabled for testing
+	mappingStats_ {}
 {
 }
 
-FeatureStore* FeatureStore::openSingle(std::string_view relativeFileName)
+// If the store is already open, its policy is only replaced if the
+// caller has asked for one explicitly
+FeatureStore* FeatureStore::openSingle(std::string_view relativeFileName,
+	const MappingPolicy* policy)
 {
 	std::filesystem::path path;
 	try
@@ -63,10 +72,11 @@ FeatureStore* FeatureStore::openSingle(std::string_view relativeFileName)
 		{
 			store = it->second;
 			store->addref();
+			if (policy) store->setMappingPolicy(*policy);
 			return store;
 		}
 		store = new FeatureStore();
-		store->open(fileName.data());
+		store->open(fileName.data(), policy ? *policy : DEFAULT_MAPPING_POLICY);
 		openStores[fileName] = store;
 		return store;
 	}
@@ -77,6 +87,88 @@ FeatureStore* FeatureStore::openSingle(std::string_view relativeFileName)
 	}
 }
 
+void FeatureStore::open(const char* fileName, const MappingPolicy& policy)
+{
+	BlobStore::open(fileName, policy.populate ? Store::OpenMode::POPULATE : 0);
+		// TODO: open mode
+	applyMappingPolicy(policy);
+}
+
+
+void FeatureStore::setMappingPolicy(const MappingPolicy& policy)
+{
+	applyMappingPolicy(policy);
+	if (policy.populate)
+	{
+		try
+		{
+			prefetch(mainMapping(), mainMappingSize());
+		}
+		catch (...)
+		{
+			// prefetching is merely a hint
+		}
+	}
+}
+
+
+void FeatureStore::applyMappingPolicy(const MappingPolicy& policy)
+{
+	MappingStats stats = {};
+	stats.policy = policy;
+	stats.mappedBytes = mainMappingSize();
+
+	MappedFile::Advice advice;
+	switch (policy.access)
+	{
+	case MappingPolicy::Access::RANDOM:
+		advice = MappedFile::Advice::RANDOM;
+		break;
+	case MappingPolicy::Access::SEQUENTIAL:
+		advice = MappedFile::Advice::SEQUENTIAL;
+		break;
+	default:
+		advice = MappedFile::Advice::NORMAL;
+		break;
+	}
+	stats.accessApplied = MappedFile::advise(
+		mainMapping(), mainMappingSize(), advice);
+
+	if (policy.hugePageIndex)
+	{
+		// The tile index is consulted by every query, but it is small;
+		// a range shorter than a huge page can never be backed by one,
+		// so we round it out to huge-page boundaries (2 MB)
+		constexpr uintptr_t HUGE_PAGE_MASK = (2 * 1024 * 1024) - 1;
+		stats.tileIndexBytes = tileIndexSize();
+		uintptr_t mapStart = reinterpret_cast<uintptr_t>(mainMapping());
+		uintptr_t mapEnd = mapStart + mainMappingSize();
+		uintptr_t start = reinterpret_cast<uintptr_t>(tileIndex().ptr());
+		uintptr_t end = start + stats.tileIndexBytes;
+		start = std::max(start & ~HUGE_PAGE_MASK, mapStart);
+		end = std::min((end + HUGE_PAGE_MASK) & ~HUGE_PAGE_MASK, mapEnd);
+		stats.hugePagesRequested = MappedFile::advise(
+			reinterpret_cast<const void*>(start), end - start,
+			MappedFile::Advice::HUGE_PAGES);
+	}
+	mappingStats_ = stats;
+}
+
+
+/// Returns the length of the tile index (including the child-tile
+/// mask that may follow the last entry).
+uint64_t FeatureStore::tileIndexSize()
+{
+	uint32_t maxTip = 0;
+	TileIndexWalker walker(tileIndex(), zoomLevels(), Box::ofWorld(), nullptr);
+	while (walker.next())
+	{
+		maxTip = std::max(maxTip, static_cast<uint32_t>(walker.currentTip()));
+	}
+	return (maxTip + 3ULL) * 4;
+}
+
+
 void FeatureStore::initialize()
 {
 	strings_.create(getPointer(STRING_TABLE_PTR_OFS));
@@ -99,15 +191,207 @@ FeatureStore::~FeatureStore()
 }
 
 // TODO: Return TilePtr
-DataPtr FeatureStore::fetchTile(Tip tip)
+DataPtr FeatureStore::fetchTile(Tip tip, TilePin& pin)
 {
 	uint32_t pageEntry = (tileIndex() + (tip * 4)).getUnsignedInt();
 	// Bit 0 is a flag bit (page vs. child pointer)
-	// TODO: load tiles
 
-	return pagePointer(pageEntry >> 1);
+	DataPtr pBlob = pagePointer(pageEntry >> 1);
+	if (TileCache::isCompressed(pBlob)) return tileCache_.fetch(tip, pBlob, pin);
+	pin.reset();
+	return pBlob;
+}
+
+GolIdentity FeatureStore::identity()
+{
+	const Header* header = reinterpret_cast<const Header*>(mainMapping());
+	Crc32 crc;
+	crc.update(tileIndex().ptr(), tileIndexSize());
+	return { header->creationTimestamp, header->totalPageCount, crc.get() };
+}
+
+// An index that was built for a different version of the GOL is
+// ignored, since its locations would point at arbitrary data
+IdIndex* FeatureStore::idIndex()
+{
+	std::lock_guard<std::mutex> lock(idIndexMutex_);
+	if (!idIndexChecked_)
+	{
+		idIndexChecked_ = true;
+		std::string path = IdIndex::defaultPath(fileName());
+		if (std::filesystem::is_directory(path))
+		{
+			std::unique_ptr<IdIndex> index(new IdIndex());
+			if (index->open(path, identity()))
+			{
+				idIndex_ = std::move(index);
+			}
+			else
+			{
+				LOG("Ignoring out-of-date ID index %s", path.c_str());
+			}
+		}
+	}
+	return idIndex_.get();
+}
+
+void FeatureStore::buildIdIndex()
+{
+	std::lock_guard<std::mutex> lock(idIndexMutex_);
+	idIndex_.reset();
+	std::string path = IdIndex::defaultPath(fileName());
+	GolIdentity golIdentity = identity();
+	IdIndex::build(this, path, golIdentity);
+	std::unique_ptr<IdIndex> index(new IdIndex());
+	index->open(path, golIdentity);
+	idIndex_ = std::move(index);
+	idIndexChecked_ = true;
+}
+
+// Shares the mutex with idIndex(), since both are rarely contended
+MCIndexFile* FeatureStore::mcIndexFile()
+{
+	std::lock_guard<std::mutex> lock(idIndexMutex_);
+	if (!mcIndexFileChecked_)
+	{
+		mcIndexFileChecked_ = true;
+		std::string path = MCIndexFile::defaultPath(fileName());
+		if (std::filesystem::is_regular_file(path))
+		{
+			std::unique_ptr<MCIndexFile> file(new MCIndexFile());
+			if (file->open(path, identity()))
+			{
+				mcIndexFile_ = std::move(file);
+			}
+			else
+			{
+				LOG("Ignoring out-of-date prepared-index file %s", path.c_str());
+			}
+		}
+	}
+	return mcIndexFile_.get();
 }
 
+void FeatureStore::prefetchTile(Tip tip) noexcept
+{
+	uint32_t pageEntry = (tileIndex() + (tip * 4)).getUnsignedInt();
+	if (pageEntry == 0) return;		// tile is not present
+	try
+	{
+		prefetchBlob(pagePointer(pageEntry >> 1));
+	}
+	catch (...)
+	{
+		// A failed prefetch only means that the tile will be
+		// loaded on demand, as usual
+	}
+}
+
+
+
+/// Returns the locations of the tiles covering the given box, followed
+/// by the part of the tile index that covers them and the string table.
+std::vector<FeatureStore::DataRange> FeatureStore::dataRanges(
+	const Box& box, uint32_t* pTileCount)
+{
+	std::vector<DataRange> ranges;
+	DataPtr pIndex = tileIndex();
+	uint32_t maxTip = 0;
+	TileIndexWalker walker(pIndex, zoomLevels(), box, nullptr);
+	while (walker.next())
+	{
+		Tip tip = walker.currentTip();
+		maxTip = std::max(maxTip, static_cast<uint32_t>(tip));
+		uint32_t pageEntry = (pIndex + (tip * 4)).getUnsignedInt();
+		if (pageEntry == 0) continue;
+		DataPtr pTile = pagePointer(pageEntry >> 1);
+		uint32_t size = pTile.getUnsignedInt() & 0x3fff'ffff;
+		ranges.push_back({ pTile.ptr(), size + 4ULL });
+	}
+	*pTileCount = static_cast<uint32_t>(ranges.size());
+	ranges.push_back({ pIndex.ptr(), (maxTip + 3ULL) * 4 });
+		// the walker also reads the child-tile mask after each entry
+	ranges.push_back({ strings_.data(), strings_.dataSize() });
+	return ranges;
+}
+
+
+FeatureStore::Residency FeatureStore::residency(const Box& box)
+{
+	Residency result = {};
+	std::vector<DataRange> ranges = dataRanges(box, &result.tileCount);
+	for (const DataRange& range : ranges)
+	{
+		result.totalBytes += range.length;
+		result.residentBytes += std::min(range.length,
+			MappedFile::residentBytes(range.start, range.length));
+	}
+	return result;
+}
+
+
+FeatureStore::Residency FeatureStore::warm(const Box& box, FeatureTypes types,
+	bool lock, int threadCount)
+{
+	if (types == 0) return {};
+	Residency result = {};
+	std::vector<DataRange> ranges = dataRanges(box, &result.tileCount);
+
+	// Start the I/O for all ranges, then have the reader threads
+	// touch every page (in chunks, so the work is spread evenly
+	// even if a few tiles are much larger than the rest)
+
+	for (const DataRange& range : ranges)
+	{
+		try
+		{
+			prefetch(const_cast<uint8_t*>(range.start), range.length);
+		}
+		catch (...)
+		{
+			// prefetching is merely a hint; the pages are
+			// read below in any case
+		}
+	}
+
+	constexpr uint64_t CHUNK_SIZE = 1024 * 1024;
+	constexpr uint64_t PAGE_SIZE = 4096;
+	struct Chunk
+	{
+		const uint8_t* start;
+		uint64_t length;
+	};
+	std::vector<Chunk> chunks;
+	for (const DataRange& range : ranges)
+	{
+		for (uint64_t ofs = 0; ofs < range.length; ofs += CHUNK_SIZE)
+		{
+			chunks.push_back({ range.start + ofs,
+				std::min(CHUNK_SIZE, range.length - ofs) });
+		}
+	}
+
+	Threads::parallelFor(chunks.size(), threadCount, [&chunks](size_t n)
+	{
+		const Chunk& chunk = chunks[n];
+		for (uint64_t ofs = 0; ofs < chunk.length; ofs += PAGE_SIZE)
+		{
+			*reinterpret_cast<const volatile uint8_t*>(chunk.start + ofs);
+		}
+	}, 1);
+
+	for (const DataRange& range : ranges)
+	{
+		result.totalBytes += range.length;
+		if (lock && MappedFile::lock(range.start, range.length))
+		{
+			result.lockedBytes += range.length;
+		}
+		result.residentBytes += std::min(range.length,
+			MappedFile::residentBytes(range.start, range.length));
+	}
+	return result;
+}
 
 
 void FeatureStore::readIndexSchema()
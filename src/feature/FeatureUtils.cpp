@@ -2,23 +2,39 @@
 // SPDX-License-Identifier: LGPL-3.0-only
 
 #include <geodesk/feature/FeatureUtils.h>
+#include <algorithm>
+#include <vector>
 #include <clarisma/text/Format.h>
 #include <clarisma/util/StringBuilder.h>
 #include <geodesk/feature/FeatureIterator.h>
 #include <geodesk/feature/Tags.h>
+#include <geodesk/feature/NodePtr.h>
+#include <geodesk/feature/QueryException.h>
 #include <geodesk/feature/View.h>
 
 using namespace clarisma;
 
 namespace geodesk {
 
-uint64_t FeatureUtils::countWorld(const View &view)
+// The per-feature measures are calculated by the TileQueryTasks
+// on the worker threads; the Query merely adds up their partials
+static double aggregateWorld(const View& view, FeatureTypes types,
+    Query::Aggregate aggregate)
 {
-    uint64_t count = 0;
+    types &= view.types();
+    if (types == 0) return 0;
+    Query::Options options;
+    options.aggregate = aggregate;
+    options.prefetchDistance = view.store()->prefetchDistance();
     Query query(view.store(), view.bounds(),
-        view.types(), view.matcher(), view.filter());
-    while (!query.next().isNull()) count++;
-    return count;
+        types, view.matcher(), view.filter(), options);
+    return query.aggregate();
+}
+
+uint64_t FeatureUtils::countWorld(const View &view)
+{
+    return static_cast<uint64_t>(aggregateWorld(view,
+        FeatureTypes::ALL, Query::Aggregate::COUNT));
 }
 
 uint64_t FeatureUtils::countGeneric(const View &view)
@@ -42,10 +58,14 @@ uint64_t FeatureUtils::count(const View &view)
     case View::WAY_NODES:
         if (!view.usesMatcherOrFilter())
         {
-            return WayPtr(view.relatedFeature()).nodeCount();
+            return std::min<uint64_t>(
+                WayPtr(view.relatedFeature()).nodeCount(), view.limit());
         }
         break;
     case View::WORLD:
+        // The aggregates cannot tell which features fall within
+        // the limit, so a limited view must be iterated
+        if (view.isLimited()) break;
         return countWorld(view);
     default:
         break;
@@ -53,6 +73,52 @@ uint64_t FeatureUtils::count(const View &view)
     return countGeneric(view);
 }
 
+double FeatureUtils::length(const View& view)
+{
+    switch (view.view())
+    {
+    case View::EMPTY:
+        return 0;
+    case View::WORLD:
+        if (view.isLimited()) break;
+        return aggregateWorld(view, FeatureTypes::WAYS | FeatureTypes::RELATIONS,
+            Query::Aggregate::LENGTH);
+    default:
+        break;
+    }
+    double total = 0;
+    FeatureIterator<Feature> iter(view);
+    while (iter != nullptr)
+    {
+        total += (*iter).length();
+        ++iter;
+    }
+    return total;
+}
+
+double FeatureUtils::area(const View& view)
+{
+    switch (view.view())
+    {
+    case View::EMPTY:
+        return 0;
+    case View::WORLD:
+        if (view.isLimited()) break;
+        return aggregateWorld(view, FeatureTypes::AREAS,
+            Query::Aggregate::AREA);
+    default:
+        break;
+    }
+    double total = 0;
+    FeatureIterator<Feature> iter(view);
+    while (iter != nullptr)
+    {
+        total += (*iter).area();
+        ++iter;
+    }
+    return total;
+}
+
 bool FeatureUtils::isEmpty(const View& view)
 {
     if(view.view() == View::EMPTY) return true;
@@ -105,4 +171,104 @@ std::string FeatureUtils::label(const Tags& tags)
     return str.toString();
 }
 
+
+static IdIndex* requireIdIndex(FeatureStore* store)
+{
+    IdIndex* index = store->idIndex();
+    if (!index)
+    {
+        throw QueryException("%s has no ID index (or it is out of date)",
+            store->fileName().c_str());
+    }
+    return index;
+}
+
+/// Checks whether a feature that has been looked up by ID meets the
+/// type, tag and spatial constraints of the view (Membership in other
+/// collections, such as the nodes of a way, is not checked)
+bool FeatureUtils::accept(const View& view, FeaturePtr feature)
+{
+    if (!view.types().acceptFlags(feature.flags())) return false;
+    if (view.usesMatcher() && !view.matcher()->mainMatcher().accept(feature))
+    {
+        return false;
+    }
+    if (view.view() == View::WORLD)
+    {
+        Box bounds = feature.isNode() ? NodePtr(feature).bounds() : feature.bounds();
+        if (!view.bounds().intersects(bounds)) return false;
+    }
+    return !view.usesFilter() ||
+        view.filter()->accept(view.store(), feature, FastFilterHint());
+}
+
+// The features returned by byId() and byIds() outlive the pins of
+// their tiles, which is only safe if the tiles can't be evicted (i.e.
+// they are stored uncompressed, or the tile cache has no budget)
+static DataPtr fetchLookupTile(FeatureStore* store, Tip tip, TilePin& pin)
+{
+    DataPtr pTile = store->fetchTile(tip, pin);
+    if (!pin.isEmpty() && store->tileCache().budget() != TileCache::UNLIMITED)
+    {
+        throw QueryException("Lookup by ID requires an unlimited tile cache "
+            "budget, since the tiles of %s are compressed", store->fileName().c_str());
+    }
+    return pTile;
+}
+
+FeaturePtr FeatureUtils::byId(const View& view, FeatureType type, uint64_t id)
+{
+    FeatureStore* store = view.store();
+    IdIndex::Location loc = requireIdIndex(store)->get(type, id);
+    if (loc.isNull()) return FeaturePtr();
+    TilePin pin;
+    FeaturePtr feature(fetchLookupTile(store, loc.tip, pin) + loc.offset);
+    return accept(view, feature) ? feature : FeaturePtr();
+}
+
+// The lookups are sorted by tile and offset, so each tile is fetched
+// only once, and its features are visited in address order
+
+void FeatureUtils::byIds(const View& view, FeatureType type,
+    const uint64_t* ids, size_t count, FeaturePtr* results)
+{
+    FeatureStore* store = view.store();
+    IdIndex* index = requireIdIndex(store);
+    struct Lookup
+    {
+        IdIndex::Location loc;
+        size_t n;
+    };
+    std::vector<Lookup> lookups;
+    lookups.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        results[i] = FeaturePtr();
+        IdIndex::Location loc = index->get(type, ids[i]);
+        if (!loc.isNull()) lookups.push_back({ loc, i });
+    }
+    std::sort(lookups.begin(), lookups.end(), [](const Lookup& a, const Lookup& b)
+    {
+        if (a.loc.tip != b.loc.tip)
+        {
+            return static_cast<uint32_t>(a.loc.tip) < static_cast<uint32_t>(b.loc.tip);
+        }
+        return a.loc.offset < b.loc.offset;
+    });
+
+    TilePin pin;
+    Tip currentTip;
+    DataPtr pTile;
+    for (const Lookup& lookup : lookups)
+    {
+        if (pTile.ptr() == nullptr || !(lookup.loc.tip == currentTip))
+        {
+            currentTip = lookup.loc.tip;
+            pTile = fetchLookupTile(store, currentTip, pin);
+        }
+        FeaturePtr feature(pTile + lookup.loc.offset);
+        if (accept(view, feature)) results[lookup.n] = feature;
+    }
+}
+
 } // namespace geodesk
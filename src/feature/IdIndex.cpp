@@ -0,0 +1,190 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <geodesk/feature/IdIndex.h>
+#include <filesystem>
+#include <clarisma/io/File.h>
+#include <clarisma/io/IOException.h>
+#include <clarisma/util/Bits.h>
+#include <geodesk/feature/FeaturePtr.h>
+#include <geodesk/feature/FeatureStore.h>
+#include <geodesk/query/LeafScanner.h>
+#include <geodesk/query/TileIndexWalker.h>
+
+namespace geodesk {
+
+using namespace clarisma;
+
+const char* const IdIndex::FILE_NAMES[3] = { "nodes", "ways", "relations" };
+const char* const IdIndex::IDENTITY_FILE_NAME = "gol.id";
+
+bool IdIndex::open(const std::string& path, const GolIdentity& identity)
+{
+	std::filesystem::path identityPath = std::filesystem::path(path) / IDENTITY_FILE_NAME;
+	if (!std::filesystem::is_regular_file(identityPath)) return false;
+	GolIdentity indexed;
+	File file;
+	file.open(identityPath, File::OpenMode::READ);
+	if (file.read(&indexed, sizeof(indexed)) != sizeof(indexed) ||
+		!(indexed == identity))
+	{
+		return false;
+	}
+	open(path, File::OpenMode::READ);
+	return true;
+}
+
+void IdIndex::open(const std::string& path, int mode)
+{
+	std::filesystem::path dir(path);
+	for (int i = 0; i < 3; i++)
+	{
+		std::string name(FILE_NAMES[i]);
+		tips_[i].bits(24);
+		tips_[i].open((dir / (name + ".tip")).string().c_str(), mode);
+		offsets_[i].bits(24);
+		offsets_[i].open((dir / (name + ".ofs")).string().c_str(), mode);
+	}
+}
+
+std::string IdIndex::defaultPath(const std::string& golFileName)
+{
+	return std::filesystem::path(golFileName).replace_extension(".idx").string();
+}
+
+
+void IdIndex::put(FeatureType type, uint64_t id, Location loc)
+{
+	int t = static_cast<int>(type);
+	if (offsets_[t].get(id) != 0) return;
+		// multi-tile feature that has already been indexed
+	offsets_[t].put(id, loc.offset >> 2);
+	tips_[t].put(id, loc.tip);
+}
+
+
+void IdIndex::build(FeatureStore* store, const std::string& path,
+	const GolIdentity& identity)
+{
+	std::filesystem::create_directories(path);
+	std::filesystem::path identityPath = std::filesystem::path(path) / IDENTITY_FILE_NAME;
+	std::filesystem::remove(identityPath);
+	{
+		IdIndex index;
+		index.open(path, File::OpenMode::READ | File::OpenMode::WRITE |
+			File::OpenMode::CREATE | File::OpenMode::REPLACE_EXISTING);
+		TileIndexWalker walker(store->tileIndex(), store->zoomLevels(),
+			Box::ofWorld(), nullptr);
+		TilePin pin;
+		while (walker.next())
+		{
+			Tip tip = walker.currentTip();
+			uint32_t pageEntry = (store->tileIndex() + tip * 4).getUnsignedInt();
+			if (pageEntry == 0) continue;		// tile is missing
+			DataPtr pTile = store->fetchTile(tip, pin);
+			if ((pTile.getUnsignedInt() & 0x3fff'ffff) >= MAX_TILE_SIZE)
+			{
+				char buf[16];
+				throw std::runtime_error(std::string("Tile ") + tip.format(buf) +
+					" is too large to be indexed");
+			}
+			index.indexTile(tip, pTile.ptr());
+		}
+	}
+	// The index files have been closed, so the index is complete
+	File::writeAll(identityPath, &identity, sizeof(identity));
+}
+
+
+void IdIndex::indexTile(Tip tip, const uint8_t* pTile)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		// The root pointers of the indexes for nodes, ways,
+		// areas and relations
+		const uint8_t* ppRoot = pTile + 8 + i * 4;
+		int32_t ptr = DataPtr(ppRoot).getInt();
+		if (ptr == 0) continue;
+		if ((ptr & 1) == 0)
+		{
+			indexRoot(tip, pTile, ppRoot, i == 0);
+			continue;
+		}
+		// Multiple roots (one per key category)
+		const uint8_t* p = ppRoot + (ptr ^ 1);
+		for (;;)
+		{
+			int32_t last = DataPtr(p).getInt() & 1;
+			indexRoot(tip, pTile, p, i == 0);
+			if (last != 0) break;
+			p += 8;
+		}
+	}
+}
+
+
+void IdIndex::indexRoot(Tip tip, const uint8_t* pTile,
+	const uint8_t* ppRoot, bool nodes)
+{
+	int32_t ptr = DataPtr(ppRoot).getInt();
+	if (ptr == 0) return;
+	const uint8_t* p = ppRoot + (ptr & 0xffff'fffc);
+	if (ptr & 2)
+	{
+		indexLeaf(tip, pTile, p, nodes);
+	}
+	else
+	{
+		indexBranch(tip, pTile, p, nodes);
+	}
+}
+
+
+void IdIndex::indexBranch(Tip tip, const uint8_t* pTile,
+	const uint8_t* p, bool nodes)
+{
+	for (;;)
+	{
+		int32_t ptr = DataPtr(p).getInt();
+		const uint8_t* pChild = p + (ptr & 0xffff'fffc);
+		if (ptr & 2)
+		{
+			indexLeaf(tip, pTile, pChild, nodes);
+		}
+		else
+		{
+			indexBranch(tip, pTile, pChild, nodes);		// NOLINT recursion
+		}
+		if (ptr & 1) break;
+		p += 20;
+	}
+}
+
+
+void IdIndex::indexLeaf(Tip tip, const uint8_t* pTile,
+	const uint8_t* p, bool nodes)
+{
+	// We use a LeafScanner that accepts everything,
+	// since it knows the layout of the leaf entries
+	LeafScanner scanner(Box::ofWorld(), FeatureTypes::ALL, 0);
+	uint16_t offsets[LeafScanner::BLOCK_SIZE];
+	while (p)
+	{
+		uint32_t candidates;
+		const uint8_t* pNext = nodes ?
+			scanner.scanNodes(p, &candidates, offsets) :
+			scanner.scanFeatures(p, &candidates);
+		while (candidates)
+		{
+			int i = Bits::countTrailingZerosInNonZero(candidates);
+			candidates &= candidates - 1;
+			FeaturePtr pFeature(nodes ?
+				DataPtr(p + offsets[i]) + 8 : DataPtr(p) + (i * 32 + 16));
+			put(pFeature.type(), pFeature.id(), { tip,
+				static_cast<uint32_t>(pFeature.ptr() - pTile) });
+		}
+		p = pNext;
+	}
+}
+
+} // namespace geodesk
@@ -126,7 +126,7 @@ FeaturePtr MemberIterator::next()
                 if (!pForeignTile_)
                 {
                     // foreign tile not resolved yet
-                    pForeignTile_ = store_->fetchTile(currentTip_);
+                    pForeignTile_ = store_->fetchTile(currentTip_, foreignTilePin_);
                 }
                 feature = FeaturePtr(pForeignTile_ +
                     ((currentMember_ & 0xffff'fff0) >> 2));
@@ -43,7 +43,7 @@ RelationPtr ParentRelationIterator::next()
                 }
                 tipDelta >>= 1;     // signed
                 currentTip_ += tipDelta;
-                pForeignTile_ = store_->fetchTile(currentTip_);
+                pForeignTile_ = store_->fetchTile(currentTip_, foreignTilePin_);
             }
             rel = RelationPtr(pForeignTile_ + ((currentRel_ & 0xffff'fff0) >> 2));
         }
@@ -0,0 +1,155 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <geodesk/feature/TileCache.h>
+#include <cstring>
+#include <clarisma/util/Lz4.h>
+
+namespace geodesk {
+
+using namespace clarisma;
+
+TileCache::TileCache() :
+	budget_(UNLIMITED)
+{
+}
+
+TileCache::~TileCache()
+{
+	for (Shard& shard : shards_)
+	{
+		for (Entry* entry : shard.clock) delete entry;
+	}
+}
+
+
+DataPtr TileCache::fetch(Tip tip, DataPtr pBlob, TilePin& pin)
+{
+	Shard& shard = shardOf(tip);
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto it = shard.entries.find(tip);
+		if (it != shard.entries.end())
+		{
+			shard.hits++;
+			Entry* entry = it->second;
+			TilePin::addref(entry);
+			entry->referenced.store(true, std::memory_order_relaxed);
+			pin.reset();
+			pin.entry_ = entry;
+			return DataPtr(entry->data.get());
+		}
+		shard.misses++;
+	}
+
+	// Decompress without holding the lock
+
+	uint32_t compressedSize = (pBlob.getUnsignedInt() & 0x3fff'ffff) - 4;
+	uint32_t payloadSize = (pBlob + 4).getUnsignedInt();
+	std::unique_ptr<Entry> newEntry(new Entry);
+	newEntry->pins.store(1, std::memory_order_relaxed);
+	newEntry->referenced.store(true, std::memory_order_relaxed);
+	newEntry->tip = tip;
+	newEntry->size = payloadSize + 4;
+	newEntry->data.reset(new uint8_t[newEntry->size]);
+	memcpy(newEntry->data.get(), &payloadSize, 4);
+	Lz4::decompress(pBlob.ptr() + 8, compressedSize,
+		newEntry->data.get() + 4, payloadSize);
+
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	Entry* entry;
+	auto it = shard.entries.find(tip);
+	if (it != shard.entries.end())
+	{
+		// Another thread has decompressed the same tile in the meantime
+		entry = it->second;
+		TilePin::addref(entry);
+	}
+	else
+	{
+		entry = newEntry.release();
+		shard.entries.emplace(tip, entry);
+		shard.clock.push_back(entry);
+		shard.bytes += entry->size;
+		uint64_t budget = budget_.load(std::memory_order_relaxed);
+		if (budget != UNLIMITED) evict(shard, budget / SHARD_COUNT);
+	}
+	pin.reset();
+	pin.entry_ = entry;
+	return DataPtr(entry->data.get());
+}
+
+
+void TileCache::evict(Shard& shard, uint64_t maxBytes)
+{
+	// Each tile is visited at most twice (once to clear its reference
+	// bit, once to evict it), so we stop if all remaining tiles are pinned
+	size_t steps = shard.clock.size() * 2;
+	while (shard.bytes > maxBytes && steps-- > 0)
+	{
+		if (shard.hand >= shard.clock.size()) shard.hand = 0;
+		Entry* entry = shard.clock[shard.hand];
+		if (entry->pins.load(std::memory_order_acquire) != 0)
+		{
+			shard.hand++;
+			continue;
+		}
+		if (entry->referenced.exchange(false, std::memory_order_relaxed))
+		{
+			shard.hand++;
+			continue;
+		}
+		shard.entries.erase(entry->tip);
+		shard.clock[shard.hand] = shard.clock.back();
+		shard.clock.pop_back();
+		shard.bytes -= entry->size;
+		shard.evictions++;
+		delete entry;
+	}
+}
+
+
+void TileCache::setBudget(uint64_t bytes)
+{
+	budget_.store(bytes, std::memory_order_relaxed);
+	if (bytes == UNLIMITED) return;
+	for (Shard& shard : shards_)
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		evict(shard, bytes / SHARD_COUNT);
+	}
+}
+
+
+/// Evicts all tiles that are not pinned.
+void TileCache::clear()
+{
+	for (Shard& shard : shards_)
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for (Entry* entry : shard.clock)
+		{
+			entry->referenced.store(false, std::memory_order_relaxed);
+		}
+		evict(shard, 0);
+	}
+}
+
+
+TileCache::Stats TileCache::stats()
+{
+	Stats stats = {};
+	for (Shard& shard : shards_)
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		stats.hits += shard.hits;
+		stats.misses += shard.misses;
+		stats.evictions += shard.evictions;
+		stats.tileCount += shard.clock.size();
+		stats.bytes += shard.bytes;
+	}
+	stats.budget = budget_.load(std::memory_order_relaxed);
+	return stats;
+}
+
+} // namespace geodesk
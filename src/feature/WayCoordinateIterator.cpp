@@ -2,6 +2,9 @@
 // SPDX-License-Identifier: LGPL-3.0-only
 
 #include <geodesk/feature/WayCoordinateIterator.h>
+#include <algorithm>
+#include <cstring>
+#include <clarisma/util/Bits.h>
 
 namespace geodesk {
 
@@ -51,4 +54,81 @@ Coordinate WayCoordinateIterator::next()
     return c;
 }
 
+
+// Decodes a zigzag-encoded varint (up to 5 bytes) without branching
+// on its length: We load 8 bytes at once, find the first byte without
+// a continuation bit, and then gather the 7-bit groups of the bytes
+// that belong to the varint. The caller must ensure that 8 bytes
+// can be read at p.
+static inline int32_t readSignedVarint32Block(const uint8_t*& p)
+{
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));     // little-endian
+    uint64_t stops = ~word & 0x8080'8080'8080'8080ULL;
+    int bits = Bits::countTrailingZerosInNonZero(stops) + 1;
+    word &= (1ULL << bits) - 1;
+    uint64_t val =
+        (word & 0x7f) |
+        ((word >> 1) & (0x7fULL << 7)) |
+        ((word >> 2) & (0x7fULL << 14)) |
+        ((word >> 3) & (0x7fULL << 21)) |
+        ((word >> 4) & (0x7fULL << 28));
+    p += bits >> 3;
+    int64_t v = static_cast<int64_t>(val);
+    return static_cast<int32_t>((v >> 1) ^ -(v & 1));
+}
+
+
+// Decodes the `count` stored coordinates that follow the current one
+// into `out`; afterward, the last of these is the current coordinate.
+// Does not change remaining_ (the caller adjusts it).
+void WayCoordinateIterator::decodeBlock(Coordinate* out, int count)
+{
+    const uint8_t* p = p_;
+    int32_t x = x_;
+    int32_t y = y_;
+    Coordinate* end = out + count;
+
+    // Since every varint occupies at least one byte, we can safely read
+    // 8 bytes ahead as long as at least 5 pairs remain in the way body
+    // (The encoded pairs that follow the current coordinate number
+    // remaining_ - 1)
+    Coordinate* fastEnd = out + std::clamp(remaining_ - 5, 0, count);
+    while (out < fastEnd)
+    {
+        x += readSignedVarint32Block(p);
+        y += readSignedVarint32Block(p);
+        *out++ = Coordinate(x, y);
+    }
+    while (out < end)
+    {
+        x += readSignedVarint32(p);
+        y += readSignedVarint32(p);
+        *out++ = Coordinate(x, y);
+    }
+    p_ = p;
+    x_ = x;
+    y_ = y;
+}
+
+
+int WayCoordinateIterator::nextBlock(Coordinate* buf, int maxCount)
+{
+    int n = 0;
+    if (remaining_ > 0 && maxCount > 0)
+    {
+        // The current coordinate has already been decoded
+        buf[0] = Coordinate(x_, y_);
+        n = std::min(remaining_, maxCount);
+        decodeBlock(buf + 1, n - 1);
+        remaining_ -= n - 1;
+        next();     // consumes the last coordinate of the block
+    }
+    if (n < maxCount && remaining_ == 0 && duplicateFirst_)
+    {
+        buf[n++] = next();
+    }
+    return n;
+}
+
 } // namespace geodesk
@@ -7,6 +7,7 @@ namespace geodesk {
 
 // Filter combination rules:
 // - Combined filter is FAST_TILE_FILTER if *either* is FAST_TILE_FILTER
+// - Combined filter is FAST_BRANCH_FILTER if *either* is FAST_BRANCH_FILTER
 // - Combined filter is USES_BBOX if *either* USES_BBOX
 // - Combined filter is STRICT_BBOX if *both* are STRICT_BBOX
 // - If combined filter is USES_BBOX:
@@ -19,7 +20,8 @@ ComboFilter::ComboFilter(const Filter* a, const Filter* b)
     int aFlags = a->flags();
     int bFlags = b->flags();
     int totalCount = 0;
-    int fastTileFlag = (aFlags | bFlags) & FilterFlags::FAST_TILE_FILTER;
+    int fastTileFlag = (aFlags | bFlags) &
+        (FilterFlags::FAST_TILE_FILTER | FilterFlags::FAST_BRANCH_FILTER);
     int usesBoundsFlag = (aFlags | bFlags) & FilterFlags::USES_BBOX;
     int strictBoundsFlag = a->flags() & b->flags() & FilterFlags::STRICT_BBOX;
     acceptedTypes_ = a->acceptedTypes() & b->acceptedTypes();
@@ -94,4 +96,18 @@ int ComboFilter::acceptTile(Tile tile) const
     }
     return fast;
 }
+
+// A branch is rejected if any filter rejects it, and accepted
+// in its entirety only if all filters accept it
+int ComboFilter::acceptBranch(const Box& bounds) const
+{
+    int result = 1;
+    for (auto it = filters_.begin(); it != filters_.end(); ++it)
+    {
+        int accept = (*it)->acceptBranch(bounds);
+        if (accept < 0) return accept;
+        result &= accept;
+    }
+    return result;
+}
 } // namespace geodesk
@@ -9,7 +9,13 @@ namespace geodesk {
 
 int CrossesFilter::acceptTile(Tile tile) const
 {
-	return index_.locateBox(tile.bounds()) == 0 ? 0 : -1;
+	return acceptBranch(tile.bounds());
+}
+
+// Features that lie entirely inside or outside cannot cross
+int CrossesFilter::acceptBranch(const Box& bounds) const
+{
+	return index_.locateBox(bounds) == 0 ? 0 : -1;
 }
 
 bool CrossesFilter::acceptWay(WayPtr way) const
@@ -77,7 +77,9 @@ bool IntersectsPolygonFilter::acceptAreaRelation(FeatureStore* store, RelationPt
 
 bool IntersectsPolygonFilter::accept(FeatureStore* store, FeaturePtr feature, FastFilterHint fast) const
 {
-	if (fast.turboFlags) return true;
+	// A feature whose bbox merely intersects a tile that lies inside the
+	// polygon may still have all of its geometry outside the tile
+	if (fast.turboFlags && liesWithinTile(feature, fast.tile)) return true;
 	return acceptFeature(store, feature);
 }
 
@@ -90,6 +92,13 @@ int IntersectsPolygonFilter::acceptTile(Tile tile) const
 	return loc;
 }
 
+// Unlike a tile, a branch encloses the bounding boxes of its features,
+// so if it lies inside the polygon, all of its features intersect
+int IntersectsPolygonFilter::acceptBranch(const Box& bounds) const
+{
+	return index_.locateBox(bounds);
+}
+
 
 bool IntersectsLinealFilter::acceptWay(WayPtr way) const
 {
@@ -116,9 +125,21 @@ bool IntersectsLinealFilter::acceptAreaRelation(FeatureStore* store, RelationPtr
 
 bool IntersectsLinealFilter::accept(FeatureStore* store, FeaturePtr feature, FastFilterHint fast) const
 {
-	if (fast.turboFlags) return true;
+	// A line has no interior, so tiles are never accepted in their entirety
 	return acceptFeature(store, feature);
 }
 
+int IntersectsLinealFilter::acceptTile(Tile tile) const
+{
+	// Any feature that intersects the line must also be present in a
+	// tile that contains one of the line's monotone chains
+	return acceptBranch(tile.bounds());
+}
+
+int IntersectsLinealFilter::acceptBranch(const Box& bounds) const
+{
+	return index_.anyChainsIntersect(bounds) ? 0 : -1;
+}
+
 
 } // namespace geodesk
@@ -2,23 +2,46 @@
 // SPDX-License-Identifier: LGPL-3.0-only
 
 #include <geodesk/filter/PointDistanceFilter.h>
+#include <algorithm>
 #include <geodesk/feature/FeatureStore.h>
 #include <geodesk/feature/FastMemberIterator.h>
 #include <geodesk/feature/WayPtr.h>
 #include <geodesk/geom/polygon/PointInPolygon.h>
 #include <geodesk/geom/Distance.h>
+#include <geodesk/geom/GeodesicKernels.h>
 
 namespace geodesk {
 
-// TODO: Conditionally accelerate if distance is far enough that
-// some tiles could lie outside the circle
-
 PointDistanceFilter::PointDistanceFilter(double meters, Coordinate point)
 	: point_(point)
 {
 	double d = Mercator::unitsFromMeters(meters, point.y);
 	bounds_ = Box::unitsAroundXY((int32_t)std::ceil(d), point);
 	distanceSquared_ = d * d;
+	flags_ |= FilterFlags::FAST_TILE_FILTER | FilterFlags::FAST_BRANCH_FILTER;
+}
+
+
+// Tiles in the corners of the bounding box may lie entirely outside
+// the circle, and (for large radii) tiles near the center entirely
+// inside it
+int PointDistanceFilter::acceptTile(Tile tile) const
+{
+	return acceptBranch(tile.bounds());
+}
+
+
+int PointDistanceFilter::acceptBranch(const Box& b) const
+{
+	double x = point_.x;
+	double y = point_.y;
+	double nearX = std::clamp(x, static_cast<double>(b.minX()), static_cast<double>(b.maxX()));
+	double nearY = std::clamp(y, static_cast<double>(b.minY()), static_cast<double>(b.maxY()));
+	if (Distance::pointsSquared(nearX, nearY, x, y) >= distanceSquared_) return -1;
+	double farX = (x - b.minX() > b.maxX() - x) ? b.minX() : b.maxX();
+	double farY = (y - b.minY() > b.maxY() - y) ? b.minY() : b.maxY();
+	if (Distance::pointsSquared(farX, farY, x, y) < distanceSquared_) return 1;
+	return 0;
 }
 
 
@@ -26,22 +49,18 @@ bool PointDistanceFilter::segmentsWithinDistance(WayPtr way, int areaFlag) const
 {
     WayCoordinateIterator iter;
     iter.start(way, areaFlag);
-    Coordinate c = iter.next();
-    double x1 = c.x;
-    double y1 = c.y;
-    for(;;)
+    // Each block starts with the last coordinate of the previous block
+    Coordinate coords[WayCoordinateIterator::BLOCK_SIZE + 1];
+    int count = iter.nextBlock(coords, WayCoordinateIterator::BLOCK_SIZE + 1);
+    while (count > 1)
     {
-        c = iter.next();
-        if (c.isNull()) break;
-        double x2 = c.x;
-        double y2 = c.y;
-        if (Distance::pointSegmentSquared(x1, y1, x2, y2,
-            point_.x, point_.y) < distanceSquared_)
+        if (GeodesicKernels::minPointSegmentSquared(coords, count, point_)
+            < distanceSquared_)
         {
             return true;
         }
-        x1 = x2;
-        y1 = y2;
+        coords[0] = coords[count - 1];
+        count = iter.nextBlock(&coords[1], WayCoordinateIterator::BLOCK_SIZE) + 1;
     }
     return false;
 }
@@ -107,6 +126,9 @@ bool PointDistanceFilter::isAreaWithinDistance(FeatureStore* store, RelationPtr
 
 bool PointDistanceFilter::accept(FeatureStore* store, FeaturePtr feature, FastFilterHint fast) const
 {
+    // Every point of a tile that lies inside the circle is within
+    // the distance, and so is any feature contained in the tile
+    if (fast.turboFlags && liesWithinTile(feature, fast.tile)) return true;
     FeatureType type = feature.type();
     if (type == FeatureType::WAY)
     {
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: LGPL-3.0-only
 
 #include <geodesk/filter/PreparedFilterFactory.h>
+#include <geodesk/feature/FeatureStore.h>
 #include <geodesk/geom/geos/Geos.h>
 
 namespace geodesk {
@@ -12,14 +13,17 @@ const Filter* PreparedFilterFactory::forFeature(FeatureStore* store, FeaturePtr
 	{
 		RelationPtr relation(feature);
 		bounds_ = relation.bounds();
-		indexBuilder_.segmentizeAreaRelation(store, relation);
+		if (!useCachedIndex(store, feature))
+		{
+			indexBuilder_.segmentizeAreaRelation(store, relation);
+		}
 		return forPolygonal();
 	}
 	if (feature.isType(FeatureTypes::WAYS & FeatureTypes::AREAS))
 	{
 		WayPtr way(feature);
 		bounds_ = way.bounds();
-		indexBuilder_.segmentizeWay(way);
+		if (!useCachedIndex(store, feature)) indexBuilder_.segmentizeWay(way);
 		return forPolygonal();
 	}
 	if (feature.isNode())
@@ -30,18 +34,51 @@ const Filter* PreparedFilterFactory::forFeature(FeatureStore* store, FeaturePtr
 	if (feature.isRelation())
 	{
 		RelationPtr relation(feature);
-		RecursionGuard guard(relation);
 		bounds_ = relation.bounds();
-		indexBuilder_.segmentizeMembers(store, relation, guard);
+		if (!useCachedIndex(store, feature))
+		{
+			RecursionGuard guard(relation);
+			indexBuilder_.segmentizeMembers(store, relation, guard);
+		}
 		return forNonAreaRelation(store, relation);
 	}
 	assert(feature.isWay());
 	WayPtr way(feature);
 	bounds_ = way.bounds();
-	indexBuilder_.segmentizeWay(way);
+	if (!useCachedIndex(store, feature)) indexBuilder_.segmentizeWay(way);
 	return forLineal();
 }
 
+
+// Looks up the feature's index in the store's prepared-index file
+// and cache; if it isn't in either, buildIndex() will add the index
+// to the cache once it has been built
+bool PreparedFilterFactory::useCachedIndex(FeatureStore* store, FeaturePtr feature)
+{
+	cacheKey_ = feature.idBits();
+	MCIndexFile* file = store->mcIndexFile();
+	if (file)
+	{
+		cachedIndex_ = file->get(cacheKey_);
+		if (cachedIndex_) return true;
+	}
+	cache_ = &store->mcIndexCache();
+	cachedIndex_ = cache_->get(cacheKey_);
+	return cachedIndex_ != nullptr;
+}
+
+
+MCIndexCache::Handle PreparedFilterFactory::buildIndex()
+{
+	if (cachedIndex_) return cachedIndex_;
+	if (cache_)
+	{
+		return cache_->put(cacheKey_, indexBuilder_.build(bounds_),
+			indexBuilder_.indexSize());
+	}
+	return std::make_shared<const MCIndex>(indexBuilder_.build(bounds_));
+}
+
 #ifdef GEODESK_WITH_GEOS
 const Filter* PreparedFilterFactory::forGeometry(GEOSContextHandle_t context, GEOSGeometry* geom)
 {
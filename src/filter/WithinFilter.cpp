@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: LGPL-3.0-only
 
 #include <geodesk/filter/WithinFilter.h>
+#include <algorithm>
 #include <geodesk/feature/FastMemberIterator.h>
 #include <geodesk/geom/Mercator.h>
 #include <geodesk/geom/polygon/PointInPolygon.h>
@@ -63,6 +64,38 @@ bool WithinPolygonFilter::acceptNode(NodePtr node) const
 }
 
 
+void WithinPolygonFilter::acceptNodes(FeatureStore* /* store */, const FeaturePtr* nodes,
+	int count, FastFilterHint fast, bool* accepted) const
+{
+	// Nodes always lie within their tile, so all of them
+	// are accepted if the tile is
+	if (fast.turboFlags)
+	{
+		std::fill(accepted, accepted + count, true);
+		return;
+	}
+
+	// A node must lie in the interior (not on the boundary)
+	const int BATCH_SIZE = 256;
+	Coordinate points[BATCH_SIZE];
+	int8_t locations[BATCH_SIZE];
+	MCIndex::LocateBuffer buffer;
+	for (int start = 0; start < count; start += BATCH_SIZE)
+	{
+		int n = std::min(count - start, BATCH_SIZE);
+		for (int i = 0; i < n; i++)
+		{
+			points[i] = NodePtr(nodes[start + i]).xy();
+		}
+		index_.locatePoints(points, n, locations, buffer);
+		for (int i = 0; i < n; i++)
+		{
+			accepted[start + i] = locations[i] > 0;
+		}
+	}
+}
+
+
 bool WithinPolygonFilter::acceptMembers(FeatureStore* store, RelationPtr relation, RecursionGuard* guard) const
 {
 	return locateMembers(store, relation, guard) > 0;
@@ -142,21 +175,9 @@ bool WithinPolygonFilter::acceptAreaRelation(FeatureStore* store, RelationPtr re
 
 bool WithinPolygonFilter::accept(FeatureStore* store, FeaturePtr feature, FastFilterHint fast) const
 {
-	if (fast.turboFlags)
-	{
-		if ((feature.flags() &
-			(FeatureFlags::MULTITILE_NORTH | FeatureFlags::MULTITILE_WEST)) == 0)
-		{
-			// If feature lies completely within the current tile,
-			// we can fast-accept it
-
-			if (feature.minY() >= fast.tile.bottomY() &&
-				feature.maxX() <= fast.tile.rightX())
-			{
-				return true;
-			}
-		}
-	}
+	// If feature lies completely within the current tile,
+	// we can fast-accept it
+	if (fast.turboFlags && liesWithinTile(feature, fast.tile)) return true;
 	return acceptFeature(store, feature);
 }
 
@@ -170,6 +191,11 @@ int WithinPolygonFilter::acceptTile(Tile tile) const
 	return loc; 
 }
 
+int WithinPolygonFilter::acceptBranch(const Box& bounds) const
+{
+	return index_.locateBox(bounds);
+}
+
 /*
 bool WithinPolygonFilter::accept(FeatureStore* store, FeatureRef feature, FastFilterHint fast) const
 {
@@ -240,14 +266,18 @@ int WithinPolygonFilter::locateWayNodes(WayPtr way) const
 	int where = 0;
 	WayCoordinateIterator iter;
 	iter.start(way, 0);
+	Coordinate coords[WayCoordinateIterator::BLOCK_SIZE];
+	int8_t locations[WayCoordinateIterator::BLOCK_SIZE];
 	for (;;)
 	{
-		Coordinate c = iter.next();
-		if (c.isNull()) break;
-
-		int pointLocation = index_.locatePoint(c);
-		if (pointLocation < 0) return pointLocation;
-		where = std::max(where, pointLocation);
+		int count = iter.nextBlock(coords, WayCoordinateIterator::BLOCK_SIZE);
+		index_.locatePoints(coords, count, locations);
+		for (int i = 0; i < count; i++)
+		{
+			if (locations[i] < 0) return locations[i];
+			where = std::max<int>(where, locations[i]);
+		}
+		if (count < WayCoordinateIterator::BLOCK_SIZE) break;
 	}
 	return where;
 }
@@ -129,13 +129,17 @@ void GeometryWriter::writeWayCoordinates(WayPtr way, bool group)
     bool isFirst = true;
     if(group) writeByte(coordGroupStartChar_);
     writeByte(coordGroupStartChar_);
+    Coordinate coords[WayCoordinateIterator::BLOCK_SIZE];
     for (;;)
     {
-        Coordinate c = iter.next();
-        if (c.isNull()) break;
-        if (!isFirst) writeByte(',');  // TODO: always comma for all formats?
-        isFirst = false;
-        writeCoordinate(c);
+        int count = iter.nextBlock(coords, WayCoordinateIterator::BLOCK_SIZE);
+        for (int i = 0; i < count; i++)
+        {
+            if (!isFirst) writeByte(',');  // TODO: always comma for all formats?
+            isFirst = false;
+            writeCoordinate(coords[i]);
+        }
+        if (count < WayCoordinateIterator::BLOCK_SIZE) break;
     }
     writeByte(coordGroupEndChar_);
     if (group) writeByte(coordGroupEndChar_);
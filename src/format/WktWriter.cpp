@@ -52,9 +52,9 @@ void WktWriter::writeWayGeometry(WayPtr way)
 
 void WktWriter::writeAreaRelationGeometry(FeatureStore* store, RelationPtr relation)
 {
-	Polygonizer polygonizer;
-	polygonizer.createRings(store, relation);
-	polygonizer.assignAndMergeHoles();
+	PolygonizerCache::Handle rings =
+		store->polygonizerCache().rings(store, relation, true);
+	const Polygonizer& polygonizer = *rings;
 	const Polygonizer::Ring* ring = polygonizer.outerRings();
 	int count = ring ? (ring->next() ? 2 : 1) : 0;
 	if (count > 1)
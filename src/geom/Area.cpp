@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: LGPL-3.0-only
 
 #include <geodesk/geom/Area.h>
+#include <geodesk/feature/FeatureStore.h>
+#include <geodesk/geom/GeodesicKernels.h>
 #include "geom/polygon/RingCoordinateIterator.h"
 
 namespace geodesk {
@@ -33,12 +35,35 @@ double Area::ofWaySigned(const WayRef way)
 */
 
 
-double Area::signedMercatorOfWay(const WayPtr way)
+double Area::signedMercatorOfWay(const WayPtr way, bool exact)
 {
     assert(way.isArea());
     WayCoordinateIterator iter;
     iter.start(way, FeatureFlags::AREA);
-    return signedMercatorOfAbstractRing(iter);
+    // Each block starts with the last two coordinates of the
+    // previous block, since every term of the sum involves a
+    // vertex and both of its neighbors
+    Coordinate coords[WayCoordinateIterator::BLOCK_SIZE + 2];
+    int count = iter.nextBlock(coords, WayCoordinateIterator::BLOCK_SIZE + 2);
+    if (count < 2) return 0;
+    double x0 = coords[0].x;
+    double sum = 0.0;
+    while (count > 2)
+    {
+        sum += GeodesicKernels::signedMercatorAreaSum(coords, count, x0, exact);
+        coords[0] = coords[count - 2];
+        coords[1] = coords[count - 1];
+        count = iter.nextBlock(&coords[2], WayCoordinateIterator::BLOCK_SIZE) + 2;
+    }
+    return sum / 2.0;
+}
+
+
+double Area::signedMercatorOfRing(const Coordinate* coords, int count, bool exact)
+{
+    if (count < 3) return 0;
+    return GeodesicKernels::signedMercatorAreaSum(
+        coords, count, coords[0].x, exact) / 2.0;
 }
 
 
@@ -57,8 +82,9 @@ double Area::ofRelation(FeatureStore* store, const RelationPtr relation)
     scale *= scale;     // squared for square meters
     double totalArea = 0;
 
-    Polygonizer polygonizer;
-    polygonizer.createRings(store, relation);
+    PolygonizerCache::Handle rings =
+        store->polygonizerCache().rings(store, relation, false);
+    const Polygonizer& polygonizer = *rings;
     const Polygonizer::Ring* ring = polygonizer.outerRings();
     while (ring)
     {
@@ -3,6 +3,7 @@
 
 #include <geodesk/geom/Centroid.h>
 #include <geodesk/feature/FeatureStore.h>
+#include <geodesk/geom/GeodesicKernels.h>
 #include <geodesk/geom/polygon/Polygonizer.h>
 #include "geom/polygon/RingCoordinateIterator.h"
 
@@ -12,11 +13,10 @@ namespace geodesk {
 
 Coordinate Centroid::ofWay(WayPtr way)
 {
-	WayCoordinateIterator iter(way);
 	if (way.isArea())
 	{
 		Centroid::Areal centroid;
-		centroid.addRing(iter, true);
+		centroid.addWayRing(way);
 		return centroid.centroid();
 	}
 	else
@@ -30,8 +30,9 @@ Coordinate Centroid::ofWay(WayPtr way)
 
 void Centroid::Areal::addAreaRelation(FeatureStore* store, RelationPtr relation)
 {
-	Polygonizer polygonizer;
-	polygonizer.createRings(store, relation);
+	PolygonizerCache::Handle rings =
+		store->polygonizerCache().rings(store, relation, false);
+	const Polygonizer& polygonizer = *rings;
 	const Polygonizer::Ring* ring = polygonizer.outerRings();
 	while (ring)
 	{
@@ -76,10 +77,9 @@ Coordinate Centroid::ofRelation(FeatureStore* store, RelationPtr relation)
 
 void Centroid::addWay(WayPtr way)
 {
-	WayCoordinateIterator iter(way);
 	if (way.isArea())
 	{
-		areal_.addRing(iter, true);
+		areal_.addWayRing(way);
 	}
 	else
 	{
@@ -120,25 +120,39 @@ void Centroid::addRelation(FeatureStore* store, RelationPtr rel, RecursionGuard&
 }
 
 
+void Centroid::Areal::addWayRing(WayPtr way)
+{
+	double ringSum = 0;
+	double ringCentroidX = 0;
+	double ringCentroidY = 0;
+
+	WayCoordinateIterator iter(way);
+	// Each block starts with the last coordinate of the previous block
+	Coordinate coords[WayCoordinateIterator::BLOCK_SIZE + 1];
+	int count = iter.nextBlock(coords, WayCoordinateIterator::BLOCK_SIZE + 1);
+	while (count > 1)
+	{
+		GeodesicKernels::addRingCentroid(coords, count,
+			ringSum, ringCentroidX, ringCentroidY);
+		coords[0] = coords[count - 1];
+		count = iter.nextBlock(&coords[1], WayCoordinateIterator::BLOCK_SIZE) + 1;
+	}
+	addRingTerms(ringSum, ringCentroidX, ringCentroidY, true);
+}
+
+
 void Centroid::Lineal::addLineSegments(WayPtr way)
 {
 	WayCoordinateIterator iter(way);
-	Coordinate c = iter.next();
-	double x1 = c.x;
-	double y1 = c.y;
-	for (int count = iter.coordinatesRemaining(); count > 0; count--)
+	// Each block starts with the last coordinate of the previous block
+	Coordinate coords[WayCoordinateIterator::BLOCK_SIZE + 1];
+	int count = iter.nextBlock(coords, WayCoordinateIterator::BLOCK_SIZE + 1);
+	while (count > 1)
 	{
-		c = iter.next();
-		double x2 = c.x;
-		double y2 = c.y;
-		double xDelta = x1 - x2;
-		double yDelta = y1 - y2;
-		double d = sqrt(xDelta * xDelta + yDelta * yDelta);
-		totalLength_ += d;
-		lineCentroidX_ += (x1 + x2) * d;
-		lineCentroidY_ += (y1 + y2) * d;
-		x1 = x2;
-		y1 = y2;
+		GeodesicKernels::addLineCentroid(coords, count,
+			totalLength_, lineCentroidX_, lineCentroidY_);
+		coords[0] = coords[count - 1];
+		count = iter.nextBlock(&coords[1], WayCoordinateIterator::BLOCK_SIZE) + 1;
 	}
 }
 
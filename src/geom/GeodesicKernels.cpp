@@ -0,0 +1,261 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <geodesk/geom/GeodesicKernels.h>
+#include <algorithm>
+#include <limits>
+#include <geodesk/geom/Distance.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GEODESK_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace geodesk {
+
+#ifdef GEODESK_KERNELS_SSE2
+
+// Loads two consecutive coordinates as (x1, x2) and (y1, y2)
+static inline void loadPair(const Coordinate* p, __m128d& x, __m128d& y)
+{
+    __m128i xy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    xy = _mm_shuffle_epi32(xy, _MM_SHUFFLE(3, 1, 2, 0));
+    x = _mm_cvtepi32_pd(xy);
+    y = _mm_cvtepi32_pd(_mm_srli_si128(xy, 8));
+}
+
+static inline double horizontalSum(__m128d v)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+#endif
+
+
+double GeodesicKernels::length(const Coordinate* coords, int count, bool exact)
+{
+    if (count < 2) return 0;
+    if (!exact)
+    {
+        int32_t minY = coords[0].y;
+        int32_t maxY = minY;
+        for (int i = 1; i < count; i++)
+        {
+            minY = std::min(minY, coords[i].y);
+            maxY = std::max(maxY, coords[i].y);
+        }
+        if (LocalMercatorScale::covers(minY, maxY))
+        {
+            LocalMercatorScale scale((static_cast<double>(minY) + maxY) / 2);
+            return scaledLength(coords, count, scale);
+        }
+    }
+    double d = 0;
+    for (int i = 1; i < count; i++)
+    {
+        d += Distance::metersBetween(coords[i - 1], coords[i]);
+    }
+    return d;
+}
+
+
+double GeodesicKernels::scaledLength(const Coordinate* coords, int count,
+    const LocalMercatorScale& scale)
+{
+    double sum = 0;
+    int i = 0;
+#ifdef GEODESK_KERNELS_SSE2
+    const __m128d center = _mm_set1_pd(scale.center());
+    const __m128d c0 = _mm_set1_pd(scale.c0());
+    const __m128d c1 = _mm_set1_pd(scale.c1());
+    const __m128d c2 = _mm_set1_pd(scale.c2());
+    const __m128d half = _mm_set1_pd(0.5);
+    __m128d acc = _mm_setzero_pd();
+    for (; i + 2 < count; i += 2)
+    {
+        __m128d x1, y1, x2, y2;
+        loadPair(coords + i, x1, y1);
+        loadPair(coords + i + 1, x2, y2);
+        __m128d dx = _mm_sub_pd(x2, x1);
+        __m128d dy = _mm_sub_pd(y2, y1);
+        __m128d d = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)));
+        __m128d ym = _mm_sub_pd(_mm_mul_pd(_mm_add_pd(y1, y2), half), center);
+        __m128d w = _mm_add_pd(c0, _mm_mul_pd(ym, _mm_add_pd(c1, _mm_mul_pd(ym, c2))));
+        acc = _mm_add_pd(acc, _mm_mul_pd(d, w));
+    }
+    sum = horizontalSum(acc);
+#endif
+    for (i++; i < count; i++)
+    {
+        double dx = static_cast<double>(coords[i].x) - coords[i - 1].x;
+        double dy = static_cast<double>(coords[i].y) - coords[i - 1].y;
+        double ym = (static_cast<double>(coords[i].y) + coords[i - 1].y) / 2;
+        sum += std::sqrt(dx * dx + dy * dy) * scale.metersPerUnitAtY(ym);
+    }
+    return sum;
+}
+
+
+double GeodesicKernels::signedMercatorAreaSum(const Coordinate* coords, int count,
+    double x0, bool exact)
+{
+    double sum = 0;
+    int i = 1;
+#ifdef GEODESK_KERNELS_SSE2
+    if (!exact)
+    {
+        const __m128d vx0 = _mm_set1_pd(x0);
+        __m128d acc = _mm_setzero_pd();
+        for (; i + 2 < count; i += 2)
+        {
+            __m128d xPrev, yPrev, x, y, xNext, yNext;
+            loadPair(coords + i - 1, xPrev, yPrev);
+            loadPair(coords + i, x, y);
+            loadPair(coords + i + 1, xNext, yNext);
+            acc = _mm_add_pd(acc, _mm_mul_pd(_mm_sub_pd(x, vx0), _mm_sub_pd(yPrev, yNext)));
+        }
+        sum = horizontalSum(acc);
+    }
+#endif
+    for (; i < count - 1; i++)
+    {
+        double x = coords[i].x - x0;
+        double y1 = coords[i + 1].y;
+        double y2 = coords[i - 1].y;
+        sum += x * (y2 - y1);
+    }
+    return sum;
+}
+
+
+void GeodesicKernels::addLineCentroid(const Coordinate* coords, int count,
+    double& totalLength, double& centroidX, double& centroidY, bool exact)
+{
+    if (count < 2) return;
+    int i = 0;
+#ifdef GEODESK_KERNELS_SSE2
+    if (!exact)
+    {
+        __m128d accLength = _mm_setzero_pd();
+        __m128d accX = _mm_setzero_pd();
+        __m128d accY = _mm_setzero_pd();
+        for (; i + 2 < count; i += 2)
+        {
+            __m128d x1, y1, x2, y2;
+            loadPair(coords + i, x1, y1);
+            loadPair(coords + i + 1, x2, y2);
+            __m128d dx = _mm_sub_pd(x1, x2);
+            __m128d dy = _mm_sub_pd(y1, y2);
+            __m128d d = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)));
+            accLength = _mm_add_pd(accLength, d);
+            accX = _mm_add_pd(accX, _mm_mul_pd(_mm_add_pd(x1, x2), d));
+            accY = _mm_add_pd(accY, _mm_mul_pd(_mm_add_pd(y1, y2), d));
+        }
+        totalLength += horizontalSum(accLength);
+        centroidX += horizontalSum(accX);
+        centroidY += horizontalSum(accY);
+    }
+#endif
+    for (i++; i < count; i++)
+    {
+        double x1 = coords[i - 1].x;
+        double y1 = coords[i - 1].y;
+        double x2 = coords[i].x;
+        double y2 = coords[i].y;
+        double xDelta = x1 - x2;
+        double yDelta = y1 - y2;
+        double d = sqrt(xDelta * xDelta + yDelta * yDelta);
+        totalLength += d;
+        centroidX += (x1 + x2) * d;
+        centroidY += (y1 + y2) * d;
+    }
+}
+
+
+void GeodesicKernels::addRingCentroid(const Coordinate* coords, int count,
+    double& areaSum, double& centroidX, double& centroidY, bool exact)
+{
+    if (count < 2) return;
+    int i = 0;
+#ifdef GEODESK_KERNELS_SSE2
+    if (!exact)
+    {
+        __m128d accArea = _mm_setzero_pd();
+        __m128d accX = _mm_setzero_pd();
+        __m128d accY = _mm_setzero_pd();
+        for (; i + 2 < count; i += 2)
+        {
+            __m128d x1, y1, x2, y2;
+            loadPair(coords + i, x1, y1);
+            loadPair(coords + i + 1, x2, y2);
+            __m128d a = _mm_sub_pd(_mm_mul_pd(x1, y2), _mm_mul_pd(x2, y1));
+            accArea = _mm_add_pd(accArea, a);
+            accX = _mm_add_pd(accX, _mm_mul_pd(_mm_add_pd(x1, x2), a));
+            accY = _mm_add_pd(accY, _mm_mul_pd(_mm_add_pd(y1, y2), a));
+        }
+        areaSum += horizontalSum(accArea);
+        centroidX += horizontalSum(accX);
+        centroidY += horizontalSum(accY);
+    }
+#endif
+    for (i++; i < count; i++)
+    {
+        double x1 = coords[i - 1].x;
+        double y1 = coords[i - 1].y;
+        double x2 = coords[i].x;
+        double y2 = coords[i].y;
+        double a = x1 * y2 - x2 * y1;
+        areaSum += a;
+        centroidX += (x1 + x2) * a;
+        centroidY += (y1 + y2) * a;
+    }
+}
+
+
+// The vectorized version projects the point onto each segment (clamped
+// to its endpoints), with all coordinates taken relative to the point;
+// for a degenerate segment, the projection parameter is 0
+double GeodesicKernels::minPointSegmentSquared(const Coordinate* coords, int count,
+    Coordinate pt, bool exact)
+{
+    double minDist = std::numeric_limits<double>::infinity();
+    int i = 0;
+#ifdef GEODESK_KERNELS_SSE2
+    if (!exact)
+    {
+        const __m128d px = _mm_set1_pd(pt.x);
+        const __m128d py = _mm_set1_pd(pt.y);
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d one = _mm_set1_pd(1.0);
+        const __m128d tiny = _mm_set1_pd(std::numeric_limits<double>::min());
+        __m128d acc = _mm_set1_pd(minDist);
+        for (; i + 2 < count; i += 2)
+        {
+            __m128d x1, y1, x2, y2;
+            loadPair(coords + i, x1, y1);
+            loadPair(coords + i + 1, x2, y2);
+            x1 = _mm_sub_pd(x1, px);
+            y1 = _mm_sub_pd(y1, py);
+            __m128d dx = _mm_sub_pd(_mm_sub_pd(x2, px), x1);
+            __m128d dy = _mm_sub_pd(_mm_sub_pd(y2, py), y1);
+            __m128d dot = _mm_sub_pd(zero, _mm_add_pd(_mm_mul_pd(x1, dx), _mm_mul_pd(y1, dy)));
+            __m128d lenSquared = _mm_max_pd(
+                _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), tiny);
+            __m128d t = _mm_min_pd(_mm_max_pd(_mm_div_pd(dot, lenSquared), zero), one);
+            __m128d nx = _mm_add_pd(x1, _mm_mul_pd(t, dx));
+            __m128d ny = _mm_add_pd(y1, _mm_mul_pd(t, dy));
+            acc = _mm_min_pd(acc, _mm_add_pd(_mm_mul_pd(nx, nx), _mm_mul_pd(ny, ny)));
+        }
+        minDist = std::min(_mm_cvtsd_f64(acc), _mm_cvtsd_f64(_mm_unpackhi_pd(acc, acc)));
+    }
+#endif
+    for (i++; i < count; i++)
+    {
+        minDist = std::min(minDist, Distance::pointSegmentSquared(
+            coords[i - 1].x, coords[i - 1].y, coords[i].x, coords[i].y,
+            pt.x, pt.y));
+    }
+    return minDist;
+}
+
+} // namespace geodesk
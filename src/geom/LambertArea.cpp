@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: LGPL-3.0-only
 
 #include "geom/LambertArea.h"
+#include <geodesk/feature/FeatureStore.h>
 #include <geodesk/feature/WayCoordinateIterator.h>
 #include "geom/polygon/RingCoordinateIterator.h"
 
@@ -29,8 +30,9 @@ double LambertArea::ofRelation(FeatureStore* store, const RelationPtr relation)
     assert(relation.isArea());
     double totalArea = 0;
 
-    Polygonizer polygonizer;
-    polygonizer.createRings(store, relation);
+    PolygonizerCache::Handle rings =
+        store->polygonizerCache().rings(store, relation, false);
+    const Polygonizer& polygonizer = *rings;
     const Polygonizer::Ring* ring = polygonizer.outerRings();
     while (ring)
     {
@@ -4,35 +4,47 @@
 #include <geodesk/geom/Length.h>
 #include <geodesk/feature/FastMemberIterator.h>
 #include <geodesk/feature/WayCoordinateIterator.h>
-#include <geodesk/geom/Distance.h>
+#include <geodesk/geom/GeodesicKernels.h>
 
 namespace geodesk {
 
-double Length::ofWay(WayPtr way)
+// If not exact, ways that lie within a narrow band use a single
+// LocalMercatorScale instead of a per-segment scale
+double Length::ofWay(WayPtr way, bool exact)
 {
     double d = 0;
+    bool local = !exact && LocalMercatorScale::covers(way.minY(), way.maxY());
+    LocalMercatorScale scale((static_cast<double>(way.minY()) + way.maxY()) / 2);
     WayCoordinateIterator iter(way);
-    Coordinate p1 = iter.next();
-    for (;;)
+    // Each block starts with the last coordinate of the previous block
+    Coordinate coords[WayCoordinateIterator::BLOCK_SIZE + 1];
+    int count = iter.nextBlock(coords, WayCoordinateIterator::BLOCK_SIZE + 1);
+    while (count > 1)
     {
-        Coordinate p2 = iter.next();
-        if (p2.isNull()) break;
-        d += Distance::metersBetween(p1, p2);
-        p1 = p2;
+        d += local ? GeodesicKernels::scaledLength(coords, count, scale) :
+            GeodesicKernels::length(coords, count, true);
+        coords[0] = coords[count - 1];
+        count = iter.nextBlock(&coords[1], WayCoordinateIterator::BLOCK_SIZE) + 1;
     }
     return d;
 }
 
+double Length::ofLineString(const Coordinate* coords, int count, bool exact)
+{
+    return GeodesicKernels::length(coords, count, exact);
+}
+
 // TODO: Define in spec: what's the "length" of an Area-Relation?
 // Circumference without holes? Right now, we simply add up all the ways
 
-double Length::ofRelation(FeatureStore* store, RelationPtr relation)
+double Length::ofRelation(FeatureStore* store, RelationPtr relation, bool exact)
 {
 	RecursionGuard guard(relation);
-	return ofRelation(store, relation, guard);
+	return ofRelation(store, relation, guard, exact);
 }
 
-double Length::ofRelation(FeatureStore *store, RelationPtr rel, RecursionGuard &guard)
+double Length::ofRelation(FeatureStore *store, RelationPtr rel,
+	RecursionGuard &guard, bool exact)
 {
 	double totalLength = 0;
 	FastMemberIterator iter(store, rel);
@@ -43,14 +55,14 @@ double Length::ofRelation(FeatureStore *store, RelationPtr rel, RecursionGuard &
 		int memberType = member.typeCode();
 		if (memberType == 1)
 		{
-			totalLength += ofWay(WayPtr(member));		// This is placeholder-safe
+			totalLength += ofWay(WayPtr(member), exact);		// This is placeholder-safe
 		}
 		else if (memberType == 2)
 		{
 			RelationPtr childRel(member);
 			if (guard.checkAndAdd(childRel))
 			{
-				totalLength += ofRelation(store, childRel, guard);		// This is placeholder-safe
+				totalLength += ofRelation(store, childRel, guard, exact);		// This is placeholder-safe
 			}
 		}
 	}
@@ -2,9 +2,17 @@
 // SPDX-License-Identifier: LGPL-3.0-only
 
 #include <geodesk/geom/index/MCIndex.h>
+#include <algorithm>
+#include <vector>
+#include <geodesk/geom/index/hilbert.h>
 #include <geodesk/geom/index/MonotoneChain.h>
 #include <clarisma/util/log.h>
 
+#if defined(__x86_64__) || defined(_M_X64)
+#define GEODESK_MCINDEX_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace geodesk {
 
 bool MCIndex::intersects(const MonotoneChain* mc) const
@@ -118,6 +126,220 @@ bool MCIndex::countCrossings(const RTree<const MonotoneChain>::Node* node,
 	return false; // keep going
 }
 
+// The points of a cluster whose rays run through the interior of a
+// chain's Y-range, along with the chain segment each ray may cross;
+// their cross products are calculated in one pass
+namespace {
+
+struct CrossingBatch
+{
+	int32_t x[MCIndex::CLUSTER_SIZE];
+	int32_t y[MCIndex::CLUSTER_SIZE];
+	int32_t startX[MCIndex::CLUSTER_SIZE];
+	int32_t startY[MCIndex::CLUSTER_SIZE];
+	int32_t endX[MCIndex::CLUSTER_SIZE];
+	int32_t endY[MCIndex::CLUSTER_SIZE];
+	uint8_t pointNumber[MCIndex::CLUSTER_SIZE];
+	int count = 0;
+
+	void add(int n, Coordinate c, const Coordinate* segment)
+	{
+		x[count] = c.x;
+		y[count] = c.y;
+		startX[count] = segment[0].x;
+		startY[count] = segment[0].y;
+		endX[count] = segment[1].x;
+		endY[count] = segment[1].y;
+		pointNumber[count] = static_cast<uint8_t>(n);
+		count++;
+	}
+
+	// Uses the same operations (in the same order) as countCrossings(),
+	// so the results are identical
+	void crossProducts(double* products) const
+	{
+		int i = 0;
+#ifdef GEODESK_MCINDEX_SSE2
+		auto load = [](const int32_t* p)
+		{
+			return _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+		};
+		for (; i + 1 < count; i += 2)
+		{
+			__m128d cx = load(x + i);
+			__m128d cy = load(y + i);
+			__m128d sx = load(startX + i);
+			__m128d sy = load(startY + i);
+			__m128d ex = load(endX + i);
+			__m128d ey = load(endY + i);
+			__m128d product = _mm_sub_pd(
+				_mm_mul_pd(_mm_sub_pd(cy, sy), _mm_sub_pd(ex, sx)),
+				_mm_mul_pd(_mm_sub_pd(cx, sx), _mm_sub_pd(ey, sy)));
+			_mm_storeu_pd(products + i, product);
+		}
+#endif
+		for (; i < count; i++)
+		{
+			products[i] =
+				((double)y[i] - (double)startY[i]) * ((double)endX[i] - (double)startX[i]) -
+				((double)x[i] - (double)startX[i]) * ((double)endY[i] - (double)startY[i]);
+		}
+	}
+};
+
+} // namespace
+
+
+void MCIndex::locatePoints(const Coordinate* points, size_t count, int8_t* results,
+	LocateBuffer& buffer) const
+{
+	if (count == 0) return;
+	if (count <= CLUSTER_SIZE)
+	{
+		// A batch that fits into a single cluster doesn't need to be
+		// ordered along the Hilbert curve
+		ClusterPoint cluster[CLUSTER_SIZE];
+		for (size_t i = 0; i < count; i++)
+		{
+			cluster[i].point = points[i];
+			cluster[i].index = static_cast<uint32_t>(i);
+		}
+		locateCluster(index_, cluster, static_cast<int>(count), results);
+		return;
+	}
+
+	std::vector<ClusterPoint>& sorted = buffer.points_;
+	sorted.resize(count);
+	int32_t minX = points[0].x;
+	int32_t minY = points[0].y;
+	int32_t maxX = minX;
+	int32_t maxY = minY;
+	for (size_t i = 0; i < count; i++)
+	{
+		sorted[i].point = points[i];
+		sorted[i].index = static_cast<uint32_t>(i);
+		minX = std::min(minX, points[i].x);
+		minY = std::min(minY, points[i].y);
+		maxX = std::max(maxX, points[i].x);
+		maxY = std::max(maxY, points[i].y);
+	}
+
+	int64_t width = std::max<int64_t>(static_cast<int64_t>(maxX) - minX, 1);
+	int64_t height = std::max<int64_t>(static_cast<int64_t>(maxY) - minY, 1);
+	for (ClusterPoint& p : sorted)
+	{
+		uint32_t hilbertX = static_cast<uint32_t>(
+			(static_cast<int64_t>(p.point.x) - minX) * hilbert::MAX_COORDINATE / width);
+		uint32_t hilbertY = static_cast<uint32_t>(
+			(static_cast<int64_t>(p.point.y) - minY) * hilbert::MAX_COORDINATE / height);
+		p.order = hilbert::calculateHilbertDistance(hilbertX, hilbertY);
+	}
+	std::sort(sorted.begin(), sorted.end(),
+		[](const ClusterPoint& a, const ClusterPoint& b) { return a.order < b.order; });
+
+	for (size_t start = 0; start < count; start += CLUSTER_SIZE)
+	{
+		int clusterCount = static_cast<int>(std::min<size_t>(count - start, CLUSTER_SIZE));
+		locateCluster(index_, &sorted[start], clusterCount, results);
+	}
+}
+
+
+void MCIndex::locateCluster(const RTree<const MonotoneChain>& index,
+	const ClusterPoint* points, int count, int8_t* results)
+{
+	PointCluster cluster;
+	ClusterPoint sorted[CLUSTER_SIZE];
+	std::copy(points, points + count, sorted);
+	std::sort(sorted, sorted + count, [](const ClusterPoint& a, const ClusterPoint& b)
+	{
+		return a.point.y < b.point.y;
+	});
+	int32_t minX = sorted[0].point.x;
+	for (int i = 1; i < count; i++) minX = std::min(minX, sorted[i].point.x);
+
+	cluster.points = sorted;
+	cluster.count = count;
+	cluster.unresolved = count;
+	// The search box covers the rays of all points of the cluster
+	index.search(
+		Box(minX, sorted[0].point.y, std::numeric_limits<int32_t>::max(),
+			sorted[count - 1].point.y),
+		countClusterCrossings, &cluster);
+	for (int i = 0; i < count; i++)
+	{
+		results[sorted[i].index] = static_cast<int8_t>(cluster.locations[i].location());
+	}
+}
+
+
+// Applies the logic of countCrossings() to each point of the cluster
+// whose ray intersects the bounding box of the chain
+bool MCIndex::countClusterCrossings(const RTree<const MonotoneChain>::Node* node,
+	PointCluster* cluster)
+{
+	const Box& bounds = node->bounds;
+	const ClusterPoint* first = cluster->points;
+	const ClusterPoint* end = first + cluster->count;
+	const ClusterPoint* p = std::lower_bound(first, end, bounds.minY(),
+		[](const ClusterPoint& cp, int32_t y) { return cp.point.y < y; });
+
+	// Since the points are sorted by y, the segments they need
+	// to be tested against are found by walking the chain
+	const Coordinate* segment = nullptr;
+	CrossingBatch batch;
+	for (; p < end && p->point.y <= bounds.maxY(); p++)
+	{
+		Coordinate c = p->point;
+		if (c.x > bounds.maxX()) continue;
+		int n = static_cast<int>(p - first);
+		PointLocation& location = cluster->locations[n];
+		if (location.isOnBoundary()) continue;
+		if (c.y == bounds.maxY())
+		{
+			if ((c.y == bounds.minY() && c.x >= bounds.minX()) ||
+				c.x == node->item()->last().x)
+			{
+				location.setOnBoundary();
+				cluster->unresolved--;
+			}
+		}
+		else if (c.x < bounds.minX())
+		{
+			location.addCrossing();
+		}
+		else
+		{
+			if (!segment)
+			{
+				segment = node->item()->findSegmentForY(c.y);
+			}
+			else
+			{
+				while (segment[1].y < c.y) segment++;
+			}
+			batch.add(n, c, segment);
+		}
+	}
+
+	double products[CLUSTER_SIZE];
+	batch.crossProducts(products);
+	for (int i = 0; i < batch.count; i++)
+	{
+		PointLocation& location = cluster->locations[batch.pointNumber[i]];
+		if (products[i] == 0)
+		{
+			location.setOnBoundary();
+			cluster->unresolved--;
+		}
+		else if (products[i] > 0)
+		{
+			location.addCrossing();
+		}
+	}
+	return cluster->unresolved == 0;	// stop once all points are on the boundary
+}
+
 /*
 static bool intersectsLineSegment(const RTree<const MonotoneChain>::Node* node,
 	const Box* bounds)
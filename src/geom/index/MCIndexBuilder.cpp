@@ -92,6 +92,27 @@ void MCIndexBuilder::segmentizeMembers(FeatureStore* store, RelationPtr rel, Rec
 	}
 }
 
+void MCIndexBuilder::segmentizeFeature(FeatureStore* store, FeaturePtr feature)
+{
+	if (feature.isWay())
+	{
+		segmentizeWay(WayPtr(feature));
+	}
+	else if (feature.isRelation())
+	{
+		RelationPtr rel(feature);
+		if (rel.isArea())
+		{
+			segmentizeAreaRelation(store, rel);
+		}
+		else
+		{
+			RecursionGuard guard(rel);
+			segmentizeMembers(store, rel, guard);
+		}
+	}
+}
+
 // TODO: must be able to deal with empty areas (i.e. chainCount_ == 0)
 MCIndex MCIndexBuilder::build(Box bounds)
 {
@@ -0,0 +1,15 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <geodesk/geom/index/MCIndexCache.h>
+
+namespace geodesk {
+
+MCIndexCache::Handle MCIndexCache::put(int64_t key, MCIndex&& index, size_t size)
+{
+	Handle handle = std::make_shared<const MCIndex>(std::move(index));
+	if (size < MIN_CACHED_SIZE) return handle;
+	return BudgetedLruCache::put(key, std::move(handle), size);
+}
+
+} // namespace geodesk
@@ -0,0 +1,217 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <geodesk/geom/index/MCIndexFile.h>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <clarisma/io/IOException.h>
+#include <geodesk/geom/index/MCIndexBuilder.h>
+
+namespace geodesk {
+
+using namespace clarisma;
+
+MCIndexFile::~MCIndexFile()
+{
+	if (data_) MappedFile::unmap(const_cast<uint8_t*>(data_), size_);
+}
+
+
+bool MCIndexFile::open(const std::string& path, const GolIdentity& identity)
+{
+	file_.open(path.c_str(), File::OpenMode::READ);
+	size_ = file_.size();
+	if (size_ < sizeof(Header))
+	{
+		throw IOException("%s: Not a prepared-index file", path.c_str());
+	}
+	data_ = reinterpret_cast<const uint8_t*>(
+		file_.map(0, size_, MappedFile::MappingMode::READ));
+	const Header* header = reinterpret_cast<const Header*>(data_);
+	if (header->magic != MAGIC)
+	{
+		throw IOException("%s: Not a prepared-index file", path.c_str());
+	}
+	if (header->version != VERSION)
+	{
+		throw IOException("%s: Unsupported version (%d)",
+			path.c_str(), static_cast<int>(header->version));
+	}
+	if (header->entriesOffset > size_ ||
+		(size_ - header->entriesOffset) / sizeof(Entry) < header->count)
+	{
+		throw IOException("%s: File is truncated", path.c_str());
+	}
+	const Entry* entries = reinterpret_cast<const Entry*>(data_ + header->entriesOffset);
+	for (size_t i = 0; i < header->count; i++)
+	{
+		// Each blob (which starts with its root node) must lie
+		// between the header and the entry table
+		const Entry& e = entries[i];
+		if (e.offset < sizeof(Header) || (e.offset & 7) ||
+			e.offset > header->entriesOffset ||
+			e.size > header->entriesOffset - e.offset ||
+			e.size < sizeof(RTree<const MonotoneChain>::Node))
+		{
+			throw IOException("%s: File is corrupted", path.c_str());
+		}
+	}
+	if (header->identity != identity) return false;
+	entries_ = entries;
+	count_ = header->count;
+	return true;
+}
+
+
+MCIndexCache::Handle MCIndexFile::get(int64_t key) const
+{
+	const Entry* end = entries_ + count_;
+	const Entry* p = std::lower_bound(entries_, end, key,
+		[](const Entry& e, int64_t k) { return e.key < k; });
+	if (p == end || p->key != key) return {};
+	assert(p->offset + p->size <= size_);
+	return std::make_shared<const MCIndex>(MCIndex::unowned(
+		reinterpret_cast<const RTree<const MonotoneChain>::Node*>(data_ + p->offset)));
+}
+
+
+std::string MCIndexFile::defaultPath(const std::string& golFileName)
+{
+	return std::filesystem::path(golFileName).replace_extension(".mci").string();
+}
+
+
+MCIndexFile::Writer::Writer(const std::string& path, const GolIdentity& identity) :
+	identity_(identity),
+	pos_(sizeof(Header))
+{
+	file_.open(path.c_str(), File::OpenMode::WRITE |
+		File::OpenMode::CREATE | File::OpenMode::REPLACE_EXISTING);
+	Header header = {};
+	file_.write(&header, sizeof(header));
+}
+
+
+MCIndexFile::Writer::~Writer()
+{
+	// If finish() has not been called, the file is left without a
+	// valid header, and hence cannot be opened
+}
+
+
+void MCIndexFile::Writer::writeAligned(const void* data, size_t size)
+{
+	static const uint8_t ZEROES[8] = {};
+	size_t padding = (8 - (pos_ & 7)) & 7;
+	if (padding)
+	{
+		file_.write(ZEROES, padding);
+		pos_ += padding;
+	}
+	file_.write(data, size);
+	pos_ += size;
+}
+
+
+// Finds the number of nodes in the tree (which are stored in a single
+// array, root first) and the range of memory occupied by its chains
+void MCIndexFile::Writer::measure(const Node* p, bool leaf, const Node* root,
+	size_t& nodeCount, const uint8_t*& dataStart, const uint8_t*& dataEnd)
+{
+	for (;; p++)
+	{
+		nodeCount = std::max(nodeCount, static_cast<size_t>(p - root + 1));
+		if (leaf)
+		{
+			const MonotoneChain* chain = p->item();
+			const uint8_t* pChain = reinterpret_cast<const uint8_t*>(chain);
+			dataStart = std::min(dataStart, pChain);
+			dataEnd = std::max(dataEnd, pChain + chain->storageSize());
+		}
+		else
+		{
+			measure(p->child(), p->flags() & Node::LEAF, root,		// NOLINT recursion
+				nodeCount, dataStart, dataEnd);
+		}
+		if (p->endFlag()) break;
+	}
+}
+
+
+// Initializes the nodes of the copy, so their relative offsets
+// point to the copied nodes and chains
+void MCIndexFile::Writer::relocate(const Node* src, Node* dest, bool leaf,
+	const Node* srcRoot, Node* destRoot, const uint8_t* srcData, uint8_t* destData)
+{
+	for (;; src++, dest++)
+	{
+		if (leaf)
+		{
+			const uint8_t* pChain = reinterpret_cast<const uint8_t*>(src->item());
+			dest->init(src->bounds, destData + (pChain - srcData), src->flags());
+		}
+		else
+		{
+			const Node* srcChild = src->child();
+			Node* destChild = destRoot + (srcChild - srcRoot);
+			dest->init(src->bounds, destChild, src->flags());
+			relocate(srcChild, destChild, src->flags() & Node::LEAF,	// NOLINT recursion
+				srcRoot, destRoot, srcData, destData);
+		}
+		if (src->endFlag()) break;
+	}
+}
+
+
+void MCIndexFile::Writer::add(int64_t key, const MCIndex& index)
+{
+	const Node* root = index.root();
+	size_t nodeCount = 0;
+	const uint8_t* dataStart = reinterpret_cast<const uint8_t*>(UINTPTR_MAX);
+	const uint8_t* dataEnd = nullptr;
+	measure(root, false, root, nodeCount, dataStart, dataEnd);
+
+	size_t nodesSize = nodeCount * sizeof(Node);
+	size_t dataSize = dataEnd - dataStart;
+	size_t size = nodesSize + dataSize;
+	std::unique_ptr<uint64_t[]> buf(new uint64_t[(size + 7) / 8]());
+	Node* destRoot = reinterpret_cast<Node*>(buf.get());
+	uint8_t* destData = reinterpret_cast<uint8_t*>(buf.get()) + nodesSize;
+	memcpy(destData, dataStart, dataSize);
+	relocate(root, destRoot, false, root, destRoot, dataStart, destData);
+
+	writeAligned(buf.get(), size);
+	entries_.push_back({ key, pos_ - size, size });
+}
+
+
+void MCIndexFile::Writer::addFeature(FeatureStore* store, FeaturePtr feature)
+{
+	if (feature.isNode()) return;
+	MCIndexBuilder builder;
+	builder.segmentizeFeature(store, feature);
+	if (builder.isEmpty()) return;
+	add(feature.idBits(), builder.build(feature.bounds()));
+}
+
+
+void MCIndexFile::Writer::finish()
+{
+	std::sort(entries_.begin(), entries_.end(),
+		[](const Entry& a, const Entry& b) { return a.key < b.key; });
+	writeAligned(entries_.data(), entries_.size() * sizeof(Entry));
+	Header header;
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.identity = identity_;
+	header.count = entries_.size();
+	header.entriesOffset = pos_ - entries_.size() * sizeof(Entry);
+	file_.seek(0);
+	file_.write(&header, sizeof(header));
+	file_.close();
+}
+
+} // namespace geodesk
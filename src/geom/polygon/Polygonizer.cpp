@@ -9,18 +9,22 @@
 #include "Segment.h"
 #include <geodesk/feature/FeatureStore.h>
 #include <geodesk/feature/MemberIterator.h>
+#include <clarisma/thread/Threads.h>
 
 namespace geodesk {
 
 Polygonizer::Polygonizer() :
 	outerRings_(nullptr),
-	innerRings_(nullptr)
+	innerRings_(nullptr),
+	maxThreads_(1),
+	parallelThreshold_(PARALLEL_THRESHOLD)
 {
 }
 
 
 // TODO: Use a separate path for areas (which be definition don't require assembling)?
 // This way, no need to test for flag
+// The segment's coordinates are filled in later by decodeSegments()
 Polygonizer::Segment* Polygonizer::createSegment(WayPtr way, Segment* next)
 {
 	WayCoordinateIterator iter(way);
@@ -31,17 +35,24 @@ Polygonizer::Segment* Polygonizer::createSegment(WayPtr way, Segment* next)
 	seg->status = Segment::SEGMENT_UNASSIGNED;
 	seg->backward = false;
 	seg->vertexCount = vertexCount;
-	Coordinate* p = seg->coords;
-    Coordinate* end = p + vertexCount;
-	do
-	{
-		*p++ = iter.next();
-	} 
-	while (p < end);
 	return seg;
 }
 
 
+// Decodes the coordinates of the given segments (on multiple
+// threads, if there are many of them)
+void Polygonizer::decodeSegments(const std::vector<Segment*>& segments)
+{
+	int threadCount = (segments.size() >= parallelThreshold_) ? maxThreads_ : 1;
+	clarisma::Threads::parallelFor(segments.size(), threadCount, [&segments](size_t i)
+	{
+		Segment* seg = segments[i];
+		WayCoordinateIterator iter(seg->way);
+		iter.nextBlock(seg->coords, seg->vertexCount);
+	});
+}
+
+
 void Polygonizer::createRings(FeatureStore* store, RelationPtr relation)
 {
     Segment* outerSegments = nullptr;
@@ -57,6 +68,8 @@ void Polygonizer::createRings(FeatureStore* store, RelationPtr relation)
     //  (4/3/24: made it threadsafe by only creating the Pyhon role string object
     //  on demand; since we no longer use the Python object, MI is safe)
     MemberIterator iter(store, pMembers, FeatureTypes::WAYS, store->borrowAllMatcher(), nullptr);
+    std::vector<Segment*> segments;
+    Tip pinnedTip;
     for (;;)
     {
         WayPtr way(iter.next());
@@ -82,13 +95,29 @@ void Polygonizer::createRings(FeatureStore* store, RelationPtr relation)
         {
             outerSegments = createSegment(way, outerSegments);
             outerSegmentCount++;
+            segments.push_back(outerSegments);
         }
         else if (role == "inner")
         {
             innerSegments = createSegment(way, innerSegments);
             innerSegmentCount++;
+            segments.push_back(innerSegments);
+        }
+        else
+        {
+            continue;
+        }
+        if (iter.isCurrentForeign() &&
+            (foreignPins_.empty() || iter.currentTip() != pinnedTip))
+        {
+            // The way's coordinates are decoded after the iterator
+            // has moved on (and the rings refer to the way), so its
+            // tile must stay in memory as long as the rings
+            pinnedTip = iter.currentTip();
+            foreignPins_.push_back(iter.currentTilePin());
         }
     }
+    decodeSegments(segments);
     if (outerSegmentCount > 0)
     {
         outerRings_ = buildRings(outerSegmentCount, outerSegments);
@@ -100,6 +129,15 @@ void Polygonizer::createRings(FeatureStore* store, RelationPtr relation)
 }
 
 
+void Polygonizer::reset()
+{
+    arena_.reset(MAX_RETAINED_MEMORY);
+    outerRings_ = nullptr;
+    innerRings_ = nullptr;
+    foreignPins_.clear();
+}
+
+
 Polygonizer::Ring* Polygonizer::buildRings(int segmentCount, Segment* firstSegment)
 {
     assert(segmentCount > 0);
@@ -140,7 +178,8 @@ void Polygonizer::assignAndMergeHoles()
     }
     else
     {
-        RingAssigner::assignRings(outerRings_, innerRings_, arena_);
+        RingAssigner::assignRings(outerRings_, innerRings_, arena_, maxThreads_,
+            std::min<int>(parallelThreshold_, RingAssigner::PARALLEL_THRESHOLD));
     }
     innerRings_ = nullptr;  
 
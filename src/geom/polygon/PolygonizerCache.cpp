@@ -0,0 +1,59 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <geodesk/geom/polygon/PolygonizerCache.h>
+#include <vector>
+
+namespace geodesk {
+
+// Polygonizers that are ready for reuse by the current thread
+// (A thread rarely needs more than one at a time, unless
+// relations are polygonized while others are still in use)
+static thread_local std::vector<std::unique_ptr<Polygonizer>> threadPool;
+static constexpr size_t MAX_POOLED = 4;
+
+std::unique_ptr<Polygonizer> PolygonizerCache::acquire()
+{
+	if (threadPool.empty()) return std::make_unique<Polygonizer>();
+	std::unique_ptr<Polygonizer> polygonizer = std::move(threadPool.back());
+	threadPool.pop_back();
+	return polygonizer;
+}
+
+
+void PolygonizerCache::recycle(Polygonizer* polygonizer)
+{
+	if (threadPool.size() < MAX_POOLED)
+	{
+		polygonizer->reset();
+		threadPool.emplace_back(polygonizer);
+		return;
+	}
+	delete polygonizer;
+}
+
+
+PolygonizerCache::Handle PolygonizerCache::rings(
+	FeatureStore* store, RelationPtr relation, bool assignHoles)
+{
+	int64_t k = key(relation, assignHoles);
+	Handle cached = cache_.get(k);
+	if (cached) return cached;
+
+	std::unique_ptr<Polygonizer> polygonizer = acquire();
+	polygonizer->setMaxThreads(maxThreads_.load(std::memory_order_relaxed),
+		parallelThreshold_.load(std::memory_order_relaxed));
+	polygonizer->createRings(store, relation);
+	if (assignHoles) polygonizer->assignAndMergeHoles();
+	uint64_t size = polygonizer->memoryUsed();
+	if (size >= MIN_CACHED_SIZE)
+	{
+		return cache_.put(k, Handle(std::move(polygonizer)), size);
+	}
+	return Handle(polygonizer.release(), [](const Polygonizer* p)
+	{
+		recycle(const_cast<Polygonizer*>(p));
+	});
+}
+
+} // namespace geodesk
@@ -3,6 +3,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <clarisma/thread/Threads.h>
+#include <geodesk/geom/index/HilbertTreeBuilder.h>
 #include <geodesk/geom/polygon/Polygonizer.h>
 #include "Ring.h"
 
@@ -11,6 +16,14 @@ namespace geodesk {
 class Polygonizer::RingAssigner
 {
 public:
+    /// If there are more outer rings than this, candidate outers
+    /// are looked up in a spatial index rather than scanned
+    static constexpr int INDEX_THRESHOLD = 16;
+
+    /// By default, inner rings are assigned on multiple threads
+    /// if there are at least this many
+    static constexpr int PARALLEL_THRESHOLD = 256;
+
     /**
      * Matches an inner ring to an outer ring. The candidate outer rings should
      * ideally be arranged in the order of descending test cost, i.e. the largest
@@ -20,14 +33,15 @@ public:
      * test, we assign the inner ring to it; if there is more than one, we have to
      * perform a proper point-in-polygon test.
      * 
-     * This function will always assign the inner ring to an outer ring (by default,
+     * This function will always return an outer ring (by default,
      * the first ring in the list); it does not check the putative multipolygon
-     * for validity.
+     * for validity. It does not modify any rings, so it can be called
+     * for multiple inner rings concurrently.
      */
-    static void assignRing(Ring** outerRings, int outerRingCount, Ring* inner)
+    static Ring* findOuter(Ring* const* outerRings, int outerCount, const Ring* inner)
     {
         Ring* tentativeOuter = nullptr;
-        for (int i = outerRingCount - 1; i > 0; i--)
+        for (int i = outerCount - 1; i > 0; i--)
         {
             Ring* tryOuter = outerRings[i];
 
@@ -39,30 +53,56 @@ public:
                 // definitely contains the inner
                 if (tentativeOuter && tentativeOuter->contains(inner))
                 {
-                    tentativeOuter->addInner(inner);
-                    return;
+                    return tentativeOuter;
                 }
                 tentativeOuter = tryOuter;
             }
         }
-        // If the choice is down to one tentative outer and the first
-        // outer in the list (presumably the largest and hence most 
-        // expensive to check), perofmr a proper containment test
-        // on the tentative candidate
-        // (Remember, we skipped the bbox calculation for the largest
-        // outer to save costs)
-        if (tentativeOuter && tentativeOuter->contains(inner))
+        return resolve(outerRings, tentativeOuter, inner);
+    }
+
+    /**
+     * Same as findOuter(), but the candidates are retrieved from an
+     * index of the outer rings (all except the first). The candidates
+     * are tested in the same order as findOuter() would test them.
+     */
+    static Ring* findOuter(Ring* const* outerRings, const RTree<Ring* const>& index,
+        const Ring* inner)
+    {
+        struct Closure
         {
-            tentativeOuter->addInner(inner);
-            return;
-        }
+            Ring* const* outerRings;
+            const Ring* inner;
+            std::vector<int> candidates;
+        };
+        Closure closure { outerRings, inner, {} };
+        index.search<Closure*>(inner->bounds_,
+            [](const RTree<Ring* const>::Node* node, Closure* c)
+            {
+                Ring* const* pOuter = node->item();
+                if ((*pOuter)->containsBoundsOf(c->inner))
+                {
+                    c->candidates.push_back(static_cast<int>(pOuter - c->outerRings));
+                }
+                return false;
+            }, &closure);
+        std::sort(closure.candidates.begin(), closure.candidates.end(), std::greater<int>());
 
-        // If no other outer rings contain the inner, the largest ring 
-        // is the outer by default
-        outerRings[0]->addInner(inner);
+        Ring* tentativeOuter = nullptr;
+        for (int i : closure.candidates)
+        {
+            if (tentativeOuter && tentativeOuter->contains(inner))
+            {
+                return tentativeOuter;
+            }
+            tentativeOuter = outerRings[i];
+        }
+        return resolve(outerRings, tentativeOuter, inner);
     }
 
-    static void assignRings(Ring* firstOuter, Ring* firstInner, clarisma::Arena& arena)
+    static void assignRings(Ring* firstOuter, Ring* firstInner,
+        clarisma::Arena& arena, int maxThreads,
+        int parallelThreshold = PARALLEL_THRESHOLD)
     {
         // Build an array of rings, with the biggest one first
         // (We use vertex count as a proxy for "big")
@@ -86,26 +126,74 @@ public:
         }
         std::swap(outerRings[0], outerRings[biggestRing]);
 
+        int innerCount = firstInner->number();
+        Ring** innerRings = arena.allocArray<Ring*>(innerCount);
+        p = firstInner;
+        for (int i = 0; i < innerCount; i++)
+        {
+            innerRings[i] = p;
+            p = p->next();
+        }
+
+        int threadCount = (innerCount >= parallelThreshold) ? maxThreads : 1;
+
         // Calculate bboxes of all rings, except for the largest
 
-        for (int i = 1; i < outerCount; i++)
+        clarisma::Threads::parallelFor(outerCount - 1, threadCount, [outerRings](size_t i)
+        {
+            outerRings[i + 1]->calculateBounds();
+        });
+
+        RTree<Ring* const> index;
+        if (outerCount > INDEX_THRESHOLD)
         {
-            outerRings[i]->calculateBounds();
+            std::vector<BoundedItem> items(outerCount - 1);
+            Box totalBounds;
+            for (int i = 1; i < outerCount; i++)
+            {
+                items[i - 1] = { outerRings[i]->bounds_, &outerRings[i] };
+                totalBounds.expandToIncludeSimple(outerRings[i]->bounds_);
+            }
+            HilbertTreeBuilder builder(&arena);
+            index = builder.build<Ring* const>(items.data(), items.size(), 8, totalBounds);
         }
-        
-        Ring* inner = firstInner;
-        do
+
+        // Find the outer ring of each inner (in parallel for large
+        // relations), then assign them in their original order, so
+        // the result is the same as if they had been assigned one by one
+        Ring** assignedOuters = arena.allocArray<Ring*>(innerCount);
+        clarisma::Threads::parallelFor(innerCount, threadCount, [&](size_t i)
         {
+            Ring* inner = innerRings[i];
             inner->calculateBounds();
-            Ring* next = inner->next();
-            // assignRing may change next because it re-chains the rings,
-            // so we retrieve the pointer beforehand
-            assignRing(outerRings, outerCount, inner);
-            inner = next;
+            assignedOuters[i] = index.root() ?
+                findOuter(outerRings, index, inner) :
+                findOuter(outerRings, outerCount, inner);
+        });
+        for (int i = 0; i < innerCount; i++)
+        {
+            assignedOuters[i]->addInner(innerRings[i]);
         }
-        while (inner);
     }
 
+private:
+    static Ring* resolve(Ring* const* outerRings, Ring* tentativeOuter, const Ring* inner)
+    {
+        // If the choice is down to one tentative outer and the first
+        // outer in the list (presumably the largest and hence most 
+        // expensive to check), perofmr a proper containment test
+        // on the tentative candidate
+        // (Remember, we skipped the bbox calculation for the largest
+        // outer to save costs)
+        if (tentativeOuter && tentativeOuter->contains(inner))
+        {
+            return tentativeOuter;
+        }
+
+        // If no other outer rings contain the inner, the largest ring 
+        // is the outer by default
+        return outerRings[0];
+    }
 };
 
 
@@ -0,0 +1,267 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include "KernelMatcher.h"
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <clarisma/math/Math.h>
+#include <clarisma/util/ShortVarString.h>
+#include <geodesk/feature/FeatureStore.h>
+#include <geodesk/feature/TagValues.h>
+#include "Selector.h"
+#include "TagClause.h"
+
+namespace geodesk {
+
+using namespace clarisma;
+
+const MatcherHolder* KernelMatcher::create(FeatureStore* store,
+	const Selector* sel, uint32_t indexBits, int codeNo)
+{
+	if (sel->next != nullptr) return nullptr;	// only single selectors
+
+	Clause clauses[MAX_CLAUSES];
+	int count = 0;
+	for (const TagClause* clause = sel->firstClause; clause; clause = clause->next)
+	{
+		if (count == MAX_CLAUSES) return nullptr;
+		if (!analyzeClause(clause, codeNo, clauses[count])) return nullptr;
+		count++;
+	}
+	if (count == 0) return nullptr;
+		// Clauses of a Selector are already sorted by key code,
+		// which lets us check all of them in a single pass
+
+	MatcherMethod method;
+	switch (count)
+	{
+	case 1: method = acceptFixed<1>; break;
+	case 2: method = acceptFixed<2>; break;
+	case 3: method = acceptFixed<3>; break;
+	case 4: method = acceptFixed<4>; break;
+	default: method = acceptAny; break;
+	}
+
+	uint8_t* data = MatcherHolder::alloc(
+		sizeof(MatcherHolder) + sizeof(KernelMatcher) - sizeof(Matcher));
+	MatcherHolder* self = new(data) MatcherHolder(
+		sel->acceptedTypes, indexBits, indexBits == 0 ? 0 : 1);
+	KernelMatcher* matcher = new(data + offsetof(MatcherHolder, mainMatcher_))
+		KernelMatcher(store, method);
+		// (the KernelMatcher extends past the end of the MatcherHolder)
+	matcher->clauseCount_ = count;
+	for (int i = 0; i < count; i++) matcher->clauses_[i] = clauses[i];
+	return self;
+}
+
+
+/**
+ * Checks whether a clause has one of the supported shapes (as produced
+ * by the MatcherParser), and turns it into a clause descriptor.
+ */
+bool KernelMatcher::analyzeClause(const TagClause* clause, int codeNo, Clause& c)
+{
+	const OpNode* keyOp = &clause->keyOp;
+	if (keyOp->opcode != Opcode::GLOBAL_KEY || keyOp->isNegated()) return false;
+	if (clause->flags & (TagClause::COMPLEX_BOOLEAN_CLAUSE |
+		TagClause::MERGED_CLAUSE))
+	{
+		return false;
+	}
+
+	const OpNode* falseOp = keyOp->next[0];
+	const OpNode* trueOp = &clause->trueOp;
+	const OpNode* op = keyOp->next[1];
+	c.keyBits = static_cast<uint16_t>(keyOp->operand.code << 2);
+	c.codeCount = 0;
+
+	if (op->opcode == Opcode::EQ_CODE && op->isNegated())
+	{
+		// [k] is [k!=no], with a wrong-type value leading to true
+		if (op->operand.code != codeNo || op->next[0] != falseOp ||
+			op->next[1] != trueOp)
+		{
+			return false;
+		}
+		c.kind = Kind::KEY_PRESENT;
+		c.codes[0] = static_cast<uint16_t>(codeNo);
+		return true;
+	}
+
+	if (op->opcode == Opcode::EQ_CODE)
+	{
+		// [k=a,b,...] is an OR-chain of EQ_CODE
+		c.kind = Kind::CODES;
+		for (;;)
+		{
+			if (op->opcode != Opcode::EQ_CODE || op->isNegated() ||
+				op->next[1] != trueOp || c.codeCount == MAX_CODES)
+			{
+				return false;
+			}
+			c.codes[c.codeCount++] = op->operand.code;
+			op = op->next[0];
+			if (op == falseOp) return true;
+		}
+	}
+
+	// [k>a] etc. is a single numeric comparison
+	c.kind = Kind::RANGE;
+	c.range.min = -std::numeric_limits<double>::infinity();
+	c.range.max = std::numeric_limits<double>::infinity();
+	c.range.minInclusive = true;
+	c.range.maxInclusive = true;
+	if (op->opcode < Opcode::EQ_NUM || op->opcode > Opcode::GT ||
+		op->isNegated() || op->next[0] != falseOp || op->next[1] != trueOp)
+	{
+		return false;
+	}
+	return addRangeOp(op->opcode, op->operand.number, c);
+}
+
+
+/**
+ * Sets the bounds of a RANGE clause. Returns false for comparisons
+ * that cannot be expressed as a range (NaN operands).
+ */
+bool KernelMatcher::addRangeOp(int opcode, double value, Clause& c)
+{
+	if (std::isnan(value)) return false;
+	auto& r = c.range;
+	if (opcode == Opcode::EQ_NUM || opcode == Opcode::GE || opcode == Opcode::GT)
+	{
+		bool inclusive = opcode != Opcode::GT;
+		if (value > r.min || (value == r.min && !inclusive))
+		{
+			r.min = value;
+			r.minInclusive = inclusive;
+		}
+	}
+	if (opcode == Opcode::EQ_NUM || opcode == Opcode::LE || opcode == Opcode::LT)
+	{
+		bool inclusive = opcode != Opcode::LT;
+		if (value < r.max || (value == r.max && !inclusive))
+		{
+			r.max = value;
+			r.maxInclusive = inclusive;
+		}
+	}
+	return true;
+}
+
+
+/**
+ * Obtains the numeric value of a tag, converting strings if necessary
+ * (the same conversions as LOAD_NUM/STR_TO_NUM in the MatcherEngine).
+ */
+bool KernelMatcher::numericValue(const KernelMatcher* self, uint32_t key,
+	DataPtr pValue, double* pResult)
+{
+	switch (key & 3)
+	{
+	case 0:		// narrow number
+		*pResult = static_cast<int32_t>(pValue.getUnsignedShort()) + TagValues::MIN_NUMBER;
+		return true;
+	case 2:		// wide number
+		*pResult = TagValues::doubleFromWideNumber(pValue.getUnsignedIntUnaligned());
+		return true;
+	case 1:		// global string
+		return Math::parseDouble(self->store()->strings().getGlobalString(
+			pValue.getUnsignedShort())->toStringView(), pResult);
+	default:	// local string
+	{
+		int32_t rel = pValue.getUnsignedShort();
+		rel |= static_cast<int32_t>((pValue + 2).getShort()) << 16;
+		const ShortVarString* str = reinterpret_cast<const ShortVarString*>(
+			pValue.ptr() + rel);
+		return Math::parseDouble(str->toStringView(), pResult);
+	}
+	}
+}
+
+
+template<>
+bool KernelMatcher::acceptValue<KernelMatcher::Kind::KEY_PRESENT>(
+	const KernelMatcher*, const Clause& c, uint32_t key, DataPtr pValue)
+{
+	return (key & 3) != 1 || pValue.getUnsignedShort() != c.codes[0];
+}
+
+template<>
+bool KernelMatcher::acceptValue<KernelMatcher::Kind::CODES>(
+	const KernelMatcher*, const Clause& c, uint32_t key, DataPtr pValue)
+{
+	if ((key & 3) != 1) return false;
+	uint16_t code = pValue.getUnsignedShort();
+	bool found = false;
+	for (int i = 0; i < c.codeCount; i++) found |= (c.codes[i] == code);
+	return found;
+}
+
+template<>
+bool KernelMatcher::acceptValue<KernelMatcher::Kind::RANGE>(
+	const KernelMatcher* self, const Clause& c, uint32_t key, DataPtr pValue)
+{
+	double v;
+	if (!numericValue(self, key, pValue, &v)) return false;
+	const auto& r = c.range;
+	return (r.minInclusive ? v >= r.min : v > r.min) &&
+		(r.maxInclusive ? v <= r.max : v < r.max);
+}
+
+bool KernelMatcher::acceptClause(const KernelMatcher* self, const Clause& c,
+	uint32_t key, DataPtr pValue)
+{
+	switch (c.kind)
+	{
+	case Kind::KEY_PRESENT:
+		return acceptValue<Kind::KEY_PRESENT>(self, c, key, pValue);
+	case Kind::CODES:
+		return acceptValue<Kind::CODES>(self, c, key, pValue);
+	default:
+		return acceptValue<Kind::RANGE>(self, c, key, pValue);
+	}
+}
+
+
+// Since the clauses are sorted by key, we never have to go back:
+// the scan for each clause resumes where the previous one stopped.
+// The last global tag has bit 15 set in its key, so its key is
+// greater than any key we look for, which stops the scan.
+
+inline bool KernelMatcher::acceptClauses(const KernelMatcher* self, int count,
+	FeaturePtr pFeature)
+{
+	DataPtr p(pFeature.ptr() + 8);
+	p = p.followTagged(~1);
+	for (int i = 0; i < count; i++)
+	{
+		const Clause& c = self->clauses_[i];
+		uint32_t key;
+		for (;;)
+		{
+			key = p.getUnsignedShort();
+			if (key >= c.keyBits) break;
+			p += 4 + (key & 2);
+		}
+		if ((key & 0x7ffc) != c.keyBits) return false;
+		if (!acceptClause(self, c, key, p + 2)) return false;
+	}
+	return true;
+}
+
+template<int N>
+bool KernelMatcher::acceptFixed(const Matcher* matcher, FeaturePtr pFeature)
+{
+	return acceptClauses(static_cast<const KernelMatcher*>(matcher), N, pFeature);
+}
+
+bool KernelMatcher::acceptAny(const Matcher* matcher, FeaturePtr pFeature)
+{
+	const KernelMatcher* self = static_cast<const KernelMatcher*>(matcher);
+	return acceptClauses(self, self->clauseCount_, pFeature);
+}
+
+} // namespace geodesk
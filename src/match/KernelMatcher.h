@@ -0,0 +1,94 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#pragma once
+#include <cstdint>
+#include <geodesk/match/Matcher.h>
+
+namespace geodesk {
+
+struct Selector;
+struct TagClause;
+
+/// A Matcher for the most common query shapes, which checks all of
+/// its tag clauses in a single pass over the feature's global tags,
+/// using pre-instantiated kernels instead of interpreting bytecode.
+///
+/// Supported are single-selector queries whose clauses all refer
+/// to global keys (each key at most once), and are one of:
+///
+/// - [k]         (key present, and value is not "no")
+/// - [k=v,...]   (up to MAX_CODES global-string values)
+/// - [k>=a]      (a single numeric comparison, including [k=n])
+///
+/// Clauses that the Selector has merged with another clause for the
+/// same key (e.g. [k>=a][k<b]) are left to the bytecode, since they
+/// depend on TagClause::absorb().
+///
+/// All other queries are compiled to bytecode for the MatcherEngine.
+///
+class KernelMatcher : public Matcher
+{
+public:
+	static constexpr int MAX_CLAUSES = 8;
+	static constexpr int MAX_CODES = 4;
+
+	/// Creates a MatcherHolder with a KernelMatcher for the given
+	/// selector, or returns `nullptr` if the query's shape is not
+	/// supported.
+	static const MatcherHolder* create(FeatureStore* store,
+		const Selector* sel, uint32_t indexBits, int codeNo);
+
+private:
+	enum class Kind : uint8_t
+	{
+		KEY_PRESENT,
+		CODES,
+		RANGE
+	};
+
+	struct Clause
+	{
+		uint16_t keyBits;		// global-key code << 2
+		Kind kind;
+		uint8_t codeCount;
+		union
+		{
+			uint16_t codes[MAX_CODES];	// CODES (for KEY_PRESENT,
+										// codes[0] is the code of "no")
+			struct
+			{
+				double min;
+				double max;
+				bool minInclusive;
+				bool maxInclusive;
+			}
+			range;						// RANGE
+		};
+	};
+
+	KernelMatcher(FeatureStore* store, MatcherMethod method) :
+		Matcher(method, store), clauseCount_(0) {}
+
+	static bool analyzeClause(const TagClause* clause, int codeNo, Clause& c);
+	static bool addRangeOp(int opcode, double value, Clause& c);
+
+	template<Kind K>
+	static bool acceptValue(const KernelMatcher* self, const Clause& c,
+		uint32_t key, DataPtr pValue);
+	static bool acceptClause(const KernelMatcher* self, const Clause& c,
+		uint32_t key, DataPtr pValue);
+	static bool numericValue(const KernelMatcher* self, uint32_t key,
+		DataPtr pValue, double* pResult);
+
+	template<int N>
+	static bool acceptFixed(const Matcher* matcher, FeaturePtr pFeature);
+	static bool acceptAny(const Matcher* matcher, FeaturePtr pFeature);
+	static bool acceptClauses(const KernelMatcher* self, int count,
+		FeaturePtr pFeature);
+
+	int clauseCount_;
+	Clause clauses_[MAX_CLAUSES];
+};
+
+} // namespace geodesk
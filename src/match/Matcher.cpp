@@ -3,7 +3,7 @@
 
 #include <geodesk/match/Matcher.h>
 #include <cstddef>   // for offsetof
-#include <regex>
+#include <clarisma/text/Regex.h>
 #include <clarisma/util/pointer.h>
 
 namespace geodesk {
@@ -62,15 +62,15 @@ void MatcherHolder::dealloc() const
 	// Destroy regex patterns
 	if (regexCount_)
 	{
-		// static_assert(alignof(std::regex) == 8, "std:regex must be 8-byte aligned");
+		// static_assert(alignof(Regex) == 8, "Regex must be 8-byte aligned");
 		// (all resources are 8-byte aligned to accommodate natural alignment
-		// of pointers, doubes and std::regex)
-		const std::regex* pRegex = reinterpret_cast<const std::regex*>(
+		// of pointers, doubes and Regex)
+		const Regex* pRegex = reinterpret_cast<const Regex*>(
 			p + sizeof(MatcherHolder*) * referencedMatcherHoldersCount_);
-		const std::regex* pEndRegex = pRegex + regexCount_;
+		const Regex* pEndRegex = pRegex + regexCount_;
 		while (pRegex < pEndRegex)
 		{
-			pRegex->std::regex::~regex();
+			pRegex->~Regex();
 			pRegex++;
 		}
 	}
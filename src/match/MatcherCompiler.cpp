@@ -3,6 +3,7 @@
 
 #include <geodesk/match/MatcherCompiler.h>
 #include <geodesk/match/Matcher.h>
+#include "match/KernelMatcher.h"
 #include "match/MatcherDecoder.h"
 #include "match/MatcherEngine.h"
 #include "match/MatcherEmitter.h"
@@ -15,7 +16,126 @@ namespace geodesk {
 
 using namespace clarisma;
 
+MatcherCompiler::~MatcherCompiler()
+{
+	for (const CacheEntry& entry : entries_)
+	{
+		entry.matcher->release();
+	}
+}
+
+
+std::string MatcherCompiler::normalizeQuery(std::string_view query)
+{
+	std::string s;
+	s.reserve(query.size());
+	char quote = 0;
+	bool pendingSpace = false;
+	for (size_t i = 0; i < query.size(); i++)
+	{
+		char ch = query[i];
+		if (quote)
+		{
+			s += ch;
+			if (ch == '\\' && i + 1 < query.size())
+			{
+				s += query[++i];
+			}
+			else if (ch == quote)
+			{
+				quote = 0;
+			}
+			continue;
+		}
+		if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r')
+		{
+			pendingSpace = !s.empty();
+			continue;
+		}
+		if (pendingSpace)
+		{
+			s += ' ';
+			pendingSpace = false;
+		}
+		if (ch == '\'' || ch == '"') quote = ch;
+		s += ch;
+	}
+	return s;
+}
+
+
 const MatcherHolder* MatcherCompiler::getMatcher(const char* query)
+{
+	std::string key = normalizeQuery(query);
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = index_.find(key);
+		if (it != index_.end())
+		{
+			hits_++;
+			entries_.splice(entries_.begin(), entries_, it->second);
+			const MatcherHolder* matcher = it->second->matcher;
+			matcher->addref();
+			return matcher;
+		}
+		misses_++;
+	}
+
+	// Compile without holding the lock (this may take a while,
+	// and throws if the query is invalid)
+	const MatcherHolder* matcher = compile(query);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (cacheCapacity_ == 0) return matcher;
+	auto it = index_.find(key);
+	if (it != index_.end())
+	{
+		// Another thread compiled the same query in the meantime
+		return matcher;
+	}
+	evict(cacheCapacity_ - 1);
+	entries_.push_front({ std::move(key), matcher });
+	index_.emplace(entries_.front().query, entries_.begin());
+	matcher->addref();		// the cache holds its own reference
+	return matcher;
+}
+
+
+MatcherCompiler::CacheStats MatcherCompiler::cacheStats()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return { hits_, misses_, entries_.size(), cacheCapacity_ };
+}
+
+
+void MatcherCompiler::setCacheCapacity(size_t capacity)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	cacheCapacity_ = capacity;
+	evict(capacity);
+}
+
+
+void MatcherCompiler::clearCache()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	evict(0);
+}
+
+
+void MatcherCompiler::evict(size_t maxSize)
+{
+	while (entries_.size() > maxSize)
+	{
+		CacheEntry& entry = entries_.back();
+		index_.erase(entry.query);
+		entry.matcher->release();
+		entries_.pop_back();
+	}
+}
+
+
+const MatcherHolder* MatcherCompiler::compile(const char* query)
 {
 	MatcherParser parser(store_, query);
 	Selector* sel = parser.parse();
@@ -72,6 +192,12 @@ const MatcherHolder* MatcherCompiler::getMatcher(const char* query)
 		}
 	}
 	if (!matcher)
+	{
+		// Common multi-clause queries are handled by specialized
+		// native kernels; all others are compiled to bytecode
+		matcher = KernelMatcher::create(store_, sel, indexBits, parser.codeNo());
+	}
+	if (!matcher)
 	{
 		matcher = compileMatcher(parser.graph(), sel, indexBits);
 #ifdef _DEBUG
@@ -34,11 +34,11 @@ public:
 		return (double*)alloc(sizeof(double));
 	}
 
-	std::regex* allocRegex(RegexOperand* pRegexOperand)		
+	clarisma::Regex* allocRegex(RegexOperand* pRegexOperand)		
 	{
 		// TODO: must use a special area at front of resources!
-		std::regex* pRegex = reinterpret_cast<std::regex*>(alloc(sizeof(std::regex)));
-		new (pRegex) std::regex(std::move(pRegexOperand->regex()));
+		clarisma::Regex* pRegex = reinterpret_cast<clarisma::Regex*>(alloc(sizeof(clarisma::Regex)));
+		new (pRegex) clarisma::Regex(std::move(pRegexOperand->regex()));
 		pRegexOperand->setRegexResource(pRegex);
 		return pRegex;
 	}
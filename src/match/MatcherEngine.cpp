@@ -77,10 +77,10 @@ inline double MatcherEngine::getDoubleOperand()
     return d;
 }
 
-inline const std::regex *MatcherEngine::getRegexOperand()
+inline const Regex *MatcherEngine::getRegexOperand()
 {
     uint16_t opOfs = ip_.getUnsignedShort();
-    std::regex* regex = (std::regex*)(ip_.asBytePointer() - opOfs); // TODO: relative to Matcher*?
+    const Regex* regex = (const Regex*)(ip_.asBytePointer() - opOfs); // TODO: relative to Matcher*?
     ip_ += 2;
     return regex;
 }
@@ -146,8 +146,7 @@ int MatcherEngine::accept(const Matcher* matcher, FeaturePtr pFeature)
 
             case REGEX:
             {
-                std::string_view val = asStringView(stringValue);
-                matched = std::regex_match(val.begin(), val.end(), *ctx.getRegexOperand());
+                matched = ctx.getRegexOperand()->match(asStringView(stringValue));
             }
             break;
 
@@ -3,8 +3,8 @@
 
 #pragma once
 #include <cstdint>
-#include <regex>
 #include <string_view>
+#include <clarisma/text/Regex.h>
 #include <clarisma/util/pointer.h>
 #include <clarisma/util/ShortVarString.h>
 #include <geodesk/match/Matcher.h>
@@ -31,7 +31,7 @@ private:
 		return val->toStringView();
 	}
 	inline double getDoubleOperand();
-	inline const std::regex* getRegexOperand();
+	inline const clarisma::Regex* getRegexOperand();
 	inline uint32_t getFeatureTypeOperand();
 
 	clarisma::pointer ip_;
@@ -269,7 +269,7 @@ RegexOperand* MatcherParser::expectRegex()
 	{
 		return graph_.addRegex(parsed.str, parsed.len);
 	}
-	catch (const std::regex_error& e)
+	catch (const RegexException& e)
 	{
 		pNext_ = pCurrent;		// TODO: mark entire regex as error
 		error(e.what());		// throws
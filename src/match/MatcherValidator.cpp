@@ -23,7 +23,7 @@ OpNode* MatcherValidator::validate(Selector* firstSel)
 	while (pRegex)
 	{
 		regexCount_++;
-		resourceSize_ += (sizeof(std::regex) + 7) & 0xffff'fff8;
+		resourceSize_ += (sizeof(clarisma::Regex) + 7) & 0xffff'fff8;
 		pRegex = pRegex->next();
 	}
 
@@ -2,9 +2,9 @@
 // SPDX-License-Identifier: LGPL-3.0-only
 
 #pragma once
-#include <regex>
 #include <string_view>
 #include <clarisma/alloc/Arena.h>
+#include <clarisma/text/Regex.h>
 #include <geodesk/feature/FeatureTypes.h>
 #include <geodesk/feature/types.h>
 
@@ -94,14 +94,14 @@ class RegexOperand
 {
 public:
 	RegexOperand(const char* s, int len, RegexOperand* next)
-		: next_(next), regexResource_(nullptr), regex_(std::string(s, len)) {}
+		: next_(next), regexResource_(nullptr), regex_(std::string_view(s, len)) {}
 		// Must init next_ first to we have a valid chain in case
 		// regex constructor fails
 	
-	std::regex& regex()  { return regex_; }
+	clarisma::Regex& regex()  { return regex_; }
 	RegexOperand* next() { return next_; }
-	const std::regex* regexResource() const { return regexResource_; }
-	void setRegexResource(const std::regex* pRegex) { regexResource_ = pRegex; }
+	const clarisma::Regex* regexResource() const { return regexResource_; }
+	void setRegexResource(const clarisma::Regex* pRegex) { regexResource_ = pRegex; }
 
 private:
 	/**
@@ -113,14 +113,14 @@ private:
 	 * Pointer to the regex in the MatcherHolder. This is initially null
 	 * and will be assigned an adress by the MatcherEmitter.
 	 */
-	const std::regex* regexResource_;
+	const clarisma::Regex* regexResource_;
 
 	/**
 	 * The compiled regex. Once parsing is successful, this regex will be
 	 * transferred to regexResource_ (using move cosntruction) during 
 	 * opcode generation. 
 	 */
-	std::regex regex_;
+	clarisma::Regex regex_;
 };
 
 struct Operand
@@ -123,7 +123,7 @@ void TagClause::absorb(TagClause* other)
 	}
 	*/
 
-	flags |= other->flags;
+	flags |= other->flags | MERGED_CLAUSE;
 	if ((flags & COMPLEX_BOOLEAN_CLAUSE) != 0 || isOrClause() ||
 		other->isOrClause())
 	{
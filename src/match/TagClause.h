@@ -47,6 +47,12 @@ public:
 		 * Presence of key is required
 		 */
 		KEY_REQUIRED = 1 << 9,
+
+		/**
+		 * Used on key-ops of clauses into which another clause for
+		 * the same key has been merged by absorb()
+		 */
+		MERGED_CLAUSE = 1 << 10,
 	};
 
 	bool isOrClause() const;
@@ -0,0 +1,289 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <geodesk/query/BatchQuery.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <geodesk/feature/types.h>
+#include <geodesk/filter/ContainsPointFilter.h>
+#include <geodesk/geom/index/HilbertTreeBuilder.h>
+#include <geodesk/query/TileIndexScan.h>
+#include <geodesk/query/TileIndexWalker.h>
+
+namespace geodesk {
+
+using namespace clarisma;
+
+BatchQuery::BatchQuery(FeatureStore* store, std::span<const Box> probes,
+	FeatureTypes types, const MatcherHolder* matcher, const Filter* filter) :
+	store_(store),
+	probes_(probes.begin(), probes.end()),
+	types_(types),
+	matcher_(matcher),
+	filter_(filter),
+	points_(false)
+{
+}
+
+BatchQuery::BatchQuery(FeatureStore* store, std::span<const Coordinate> points,
+	FeatureTypes types, const MatcherHolder* matcher, const Filter* filter) :
+	store_(store),
+	types_(types),
+	matcher_(matcher),
+	filter_(filter),
+	points_(true)
+{
+	probes_.reserve(points.size());
+	for (Coordinate pt : points) probes_.emplace_back(pt);
+}
+
+
+void BatchQuery::run(const Consumer& consumer, const Box& bounds, int threadCount)
+{
+	if (probes_.empty()) return;
+
+	// Sort the probes along a Hilbert curve and pack them into an R-tree
+
+	std::vector<BoundedItem> items(probes_.size());
+	Box totalBounds;
+	for (size_t i = 0; i < probes_.size(); i++)
+	{
+		items[i] = { probes_[i], &probes_[i] };
+		totalBounds.expandToIncludeSimple(probes_[i]);
+	}
+	HilbertTreeBuilder builder(nullptr);
+	ProbeTree tree = builder.build<const Box>(items.data(), items.size(),
+		8, totalBounds);
+	totalBounds = Box::simpleIntersection(totalBounds, bounds);
+	if (totalBounds.isEmpty()) return;
+
+	// Walk the tile index once, and keep the tiles that
+	// intersect at least one of the probes
+
+	std::vector<TileTask> tasks;
+	TileIndexWalker walker(store_->tileIndex(), store_->zoomLevels(),
+		totalBounds, nullptr);
+	while (walker.next())
+	{
+		Box tileBounds = walker.currentTile().bounds();
+		bool found = false;
+		tree.search<bool*>(tileBounds, [](const ProbeTree::Node*, bool* pFound)
+		{
+			*pFound = true;
+			return true;
+		}, &found);
+		if (found) tasks.push_back({ walker.currentTip(), tileBounds });
+	}
+	if (tasks.empty()) return;
+
+	// Scan the tiles on worker threads; the matches of each tile are
+	// handed to the calling thread (along with a pin that keeps the
+	// tile in memory until they have been consumed)
+
+	if (threadCount <= 0) threadCount = static_cast<int>(std::thread::hardware_concurrency());
+	threadCount = std::clamp(threadCount, 1, static_cast<int>(tasks.size()));
+
+	std::atomic<size_t> nextTask(0);
+	std::atomic<bool> cancelled(false);
+	std::mutex mutex;
+	std::condition_variable ready;
+	std::condition_variable notFull;
+	std::deque<std::unique_ptr<TileResults>> queue;
+	size_t maxQueued = static_cast<size_t>(threadCount) * MAX_QUEUED_TILES;
+	int activeWorkers = threadCount;
+	std::exception_ptr error;
+
+	auto work = [&]()
+	{
+		try
+		{
+			for (;;)
+			{
+				size_t n = nextTask.fetch_add(1, std::memory_order_relaxed);
+				if (n >= tasks.size() || cancelled.load(std::memory_order_relaxed)) break;
+				std::unique_ptr<TileResults> results(new TileResults);
+				scanTile(tasks[n], tree, totalBounds, *results);
+				if (results->matches.empty()) continue;
+				std::unique_lock<std::mutex> lock(mutex);
+				notFull.wait(lock, [&]
+				{
+					return queue.size() < maxQueued ||
+						cancelled.load(std::memory_order_relaxed);
+				});
+				queue.push_back(std::move(results));
+				ready.notify_one();
+			}
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!error) error = std::current_exception();
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		activeWorkers--;
+		ready.notify_one();
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount);
+	for (int i = 0; i < threadCount; i++) threads.emplace_back(work);
+
+	try
+	{
+		for (;;)
+		{
+			std::unique_ptr<TileResults> results;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				ready.wait(lock, [&] { return !queue.empty() || activeWorkers == 0; });
+				if (queue.empty()) break;
+				results = std::move(queue.front());
+				queue.pop_front();
+				notFull.notify_one();
+			}
+			for (const Match& match : results->matches)
+			{
+				consumer(match.probe, FeaturePtr(results->pTile + match.offset));
+			}
+		}
+	}
+	catch (...)
+	{
+		// The consumer has thrown; stop the workers
+		// (but wait for them, since they refer to this frame)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			cancelled.store(true, std::memory_order_relaxed);
+			notFull.notify_all();
+		}
+		for (std::thread& thread : threads) thread.join();
+		throw;
+	}
+	for (std::thread& thread : threads) thread.join();
+	if (error) std::rethrow_exception(error);
+}
+
+
+void BatchQuery::scanTile(const TileTask& task, const ProbeTree& tree,
+	const Box& bounds, TileResults& results) const
+{
+	// Only the part of the tile covered by its probes needs to be scanned
+	struct Closure
+	{
+		Box probeBounds;
+	};
+	Closure closure;
+	tree.search<Closure*>(task.bounds, [](const ProbeTree::Node* node, Closure* c)
+	{
+		c->probeBounds.expandToIncludeSimple(node->bounds);
+		return false;
+	}, &closure);
+	if (closure.probeBounds.isEmpty()) return;
+	Box scanBounds = Box::simpleIntersection(closure.probeBounds, bounds);
+	if (scanBounds.isEmpty()) return;
+
+	results.pTile = store_->fetchTile(task.tip, results.pin);
+	TileScan scan{ tree, task.bounds, bounds, results };
+
+	// Each candidate is matched against the probes
+	struct Visitor
+	{
+		const BatchQuery* query;
+		const TileScan* scan;
+
+		bool isStopped() const { return false; }
+		void foundNode(FeaturePtr node) { query->matchFeature(node, *scan); }
+		void foundFeature(FeaturePtr feature) { query->matchFeature(feature, *scan); }
+	};
+	Visitor visitor{ this, &scan };
+	TileIndexScan<Visitor> indexScan(visitor, store_, scanBounds,
+		types_, matcher_, filter_, FastFilterHint(), 0);
+	indexScan.scan(results.pTile);
+}
+
+
+void BatchQuery::matchFeature(FeaturePtr feature, const TileScan& scan) const
+{
+	struct Closure
+	{
+		const BatchQuery* self;
+		FeaturePtr feature;
+		Box featureBounds;
+		const TileScan* scan;
+		uint32_t offset;
+	};
+	Closure closure{ this, feature,
+		feature.isNode() ? NodePtr(feature).bounds() : feature.bounds(), &scan,
+		static_cast<uint32_t>(feature.ptr().ptr() - scan.results.pTile.ptr()) };
+
+	// Only look for the probes that intersect the feature within
+	// this tile (a feature that spans tiles is also found in the
+	// other tile, which considers the rest of its bounding box)
+
+	Box searchBounds = Box::simpleIntersection(closure.featureBounds,
+		Box::simpleIntersection(scan.tileBounds, scan.bounds));
+	if (searchBounds.isEmpty()) return;
+	scan.tree.search<Closure*>(searchBounds, [](const ProbeTree::Node* node, Closure* c)
+	{
+		const Box* probe = node->item();
+		Box overlap = Box::simpleIntersection(*probe,
+			Box::simpleIntersection(c->featureBounds, c->scan->bounds));
+		if (!c->feature.isNode() && reportedByOtherTile(c->feature,
+			c->featureBounds, overlap, c->scan->tileBounds))
+		{
+			return false;
+		}
+		if (c->self->acceptProbe(c->feature, *probe))
+		{
+			c->scan->results.matches.push_back({
+				static_cast<uint32_t>(probe - c->self->probes_.data()),
+				c->offset });
+		}
+		return false;
+	}, &closure);
+}
+
+
+// A feature that lives in two tiles is seen by both of them if the
+// area shared by probe and feature (clipped to the query bounds)
+// extends across the tile boundary. In that case, the copy in the
+// tile to the west (or, for tiles in the same column, to the north)
+// reports the match. If a copy has both multi-tile flags, its twin
+// lives in a diagonal neighbor; since the feature's bounding box
+// lies within the two tiles, it tells us on which side.
+bool BatchQuery::reportedByOtherTile(FeaturePtr feature, const Box& featureBounds,
+	const Box& overlap, const Box& tileBounds)
+{
+	int multiTileFlags = feature.flags() &
+		(FeatureFlags::MULTITILE_NORTH | FeatureFlags::MULTITILE_WEST);
+	switch (multiTileFlags)
+	{
+	case 0:
+		return false;
+	case FeatureFlags::MULTITILE_WEST:
+		return overlap.minX() < tileBounds.minX();
+	case FeatureFlags::MULTITILE_NORTH:
+		return overlap.maxY() > tileBounds.maxY();
+	default:
+		if (featureBounds.minX() >= tileBounds.minX()) return false;   // twin is to the east
+		if (overlap.minX() >= tileBounds.minX()) return false;
+		return featureBounds.maxY() > tileBounds.maxY() ?
+			overlap.maxY() > tileBounds.maxY() :
+			overlap.minY() < tileBounds.minY();
+	}
+}
+
+
+bool BatchQuery::acceptProbe(FeaturePtr feature, const Box& probe) const
+{
+	if (!points_) return true;		// bounding boxes intersect
+	ContainsPointFilter filter(Coordinate(probe.minX(), probe.minY()));
+	return filter.accept(store_, feature, FastFilterHint());
+}
+
+} // namespace geodesk
@@ -0,0 +1,436 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <geodesk/query/LeafScanner.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GEODESK_LEAFSCAN_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only allow AVX2 intrinsics in functions that are
+// explicitly compiled for AVX2 (MSVC allows them anywhere)
+#if defined(__GNUC__) || defined(__clang__)
+#define GEODESK_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define GEODESK_TARGET_AVX2
+#endif
+
+namespace geodesk {
+
+// Layout of a feature leaf entry (32 bytes):
+//   0  minX, 4 minY, 8 maxX, 12 maxY
+//   16 flags (bit 0: last entry of the leaf), followed by the
+//      rest of the feature's header
+// Layout of a node leaf entry (20 bytes, or 24 bytes if the node
+// is a relation member, as indicated by flag bit 2):
+//   0  x, 4 y
+//   8  flags (bit 0: last entry of the leaf), ...
+
+static constexpr int FEATURE_ENTRY_SIZE = 32;
+
+static inline int32_t readInt(const uint8_t* p)
+{
+    int32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+const LeafScanner::Kernel LeafScanner::BEST_KERNEL = LeafScanner::detectKernel();
+
+LeafScanner::LeafScanner(const Box& box, FeatureTypes types,
+    uint32_t northwestFlags, Kernel kernel) :
+    minX_(box.minX()),
+    minY_(box.minY()),
+    maxX_(box.maxX()),
+    maxY_(box.maxY()),
+    // Box::contains() treats a box whose minX is greater than its maxX
+    // as crossing the Antimeridian (as long as minY <= maxY); for an
+    // empty box, the Y-test always fails, so the swap does no harm
+    nodeMinX_(std::min(box.minX(), box.maxX())),
+    nodeMaxX_(std::max(box.minX(), box.maxX())),
+    types_(types),
+    northwestFlags_(northwestFlags),
+    kernel_(isSupported(kernel) ? kernel : Kernel::SCALAR)
+{
+    switch (kernel_)
+    {
+    case Kernel::AVX2:
+        scanFeatures_ = scanFeaturesAvx2;
+        scanNodes_ = scanNodesSse2;     // variable-size entries don't benefit from AVX2
+        break;
+    case Kernel::SSE2:
+        scanFeatures_ = scanFeaturesSse2;
+        scanNodes_ = scanNodesSse2;
+        break;
+    default:
+        scanFeatures_ = scanFeaturesScalar;
+        scanNodes_ = scanNodesScalar;
+        break;
+    }
+}
+
+
+bool LeafScanner::isSupported(Kernel kernel) noexcept
+{
+    // Each kernel only uses instructions that are also available
+    // to the more advanced kernels
+    return static_cast<int>(kernel) <= static_cast<int>(BEST_KERNEL);
+}
+
+
+LeafScanner::Kernel LeafScanner::detectKernel() noexcept
+{
+#ifdef GEODESK_LEAFSCAN_X86
+    #ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7)
+    {
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        // The OS must save the YMM registers on a context switch
+        if (osxsave && avx && (_xgetbv(0) & 6) == 6)
+        {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5)) return Kernel::AVX2;
+        }
+    }
+    #else
+    if (__builtin_cpu_supports("avx2")) return Kernel::AVX2;
+    #endif
+    return Kernel::SSE2;
+#else
+    return Kernel::SCALAR;
+#endif
+}
+
+
+uint32_t LeafScanner::acceptFeature(const uint8_t* p, int32_t flags) const noexcept
+{
+    uint32_t hit = !(readInt(p) > maxX_ ||
+        readInt(p + 4) > maxY_ ||
+        readInt(p + 8) < minX_ ||
+        readInt(p + 12) < minY_);
+    return hit & acceptFeatureFlags(flags);
+}
+
+
+uint32_t LeafScanner::acceptNode(const uint8_t* p, int32_t flags) const noexcept
+{
+    int32_t x = readInt(p);
+    int32_t y = readInt(p + 4);
+    uint32_t hit = !(x > nodeMaxX_ || y > maxY_ ||
+        x < nodeMinX_ || y < minY_);
+    return hit & acceptNodeFlags(flags);
+}
+
+
+const uint8_t* LeafScanner::scanFeaturesScalar(const LeafScanner& scanner,
+    const uint8_t* p, uint32_t* candidates)
+{
+    uint32_t mask = 0;
+    for (int i = 0; i < BLOCK_SIZE; i++)
+    {
+        int32_t flags = readInt(p + 16);
+        mask |= scanner.acceptFeature(p, flags) << i;
+        if (flags & 1)
+        {
+            *candidates = mask;
+            return nullptr;
+        }
+        p += FEATURE_ENTRY_SIZE;
+    }
+    *candidates = mask;
+    return p;
+}
+
+
+const uint8_t* LeafScanner::scanNodesScalar(const LeafScanner& scanner,
+    const uint8_t* p, uint32_t* candidates, uint16_t* offsets)
+{
+    const uint8_t* start = p;
+    uint32_t mask = 0;
+    for (int i = 0; i < BLOCK_SIZE; i++)
+    {
+        int32_t flags = readInt(p + 8);
+        mask |= scanner.acceptNode(p, flags) << i;
+        offsets[i] = static_cast<uint16_t>(p - start);
+        if (flags & 1)
+        {
+            *candidates = mask;
+            return nullptr;
+        }
+        p += 20 + (flags & 4);
+    }
+    *candidates = mask;
+    return p;
+}
+
+#ifdef GEODESK_LEAFSCAN_X86
+
+// The SIMD kernels first copy the flags of the block's entries into
+// an array, stopping at the leaf's last entry (so we never read past
+// the end of the leaf). They then transpose the bounding boxes (or
+// coordinates) of 4 (SSE2) or 8 (AVX2) entries into one register per
+// side, test the bounds, feature types and multi-tile flags of all
+// of these entries at once, and compact the per-entry results into
+// a bitmask. The remaining entries of the block are tested one by one.
+
+static int readFeatureFlags(const uint8_t* p, int32_t* flags)
+{
+    for (int i = 0; i < LeafScanner::BLOCK_SIZE; i++)
+    {
+        flags[i] = readInt(p + i * FEATURE_ENTRY_SIZE + 16);
+        if (flags[i] & 1) return i + 1;
+    }
+    return LeafScanner::BLOCK_SIZE;
+}
+
+
+static int readNodeFlags(const uint8_t* p, int32_t* flags, uint16_t* offsets)
+{
+    const uint8_t* start = p;
+    for (int i = 0; i < LeafScanner::BLOCK_SIZE; i++)
+    {
+        offsets[i] = static_cast<uint16_t>(p - start);
+        flags[i] = readInt(p + 8);
+        if (flags[i] & 1) return i + 1;
+        p += 20 + (flags[i] & 4);
+    }
+    return LeafScanner::BLOCK_SIZE;
+}
+
+
+// SSE2 has no per-lane variable shift, so we turn each type index n
+// into (1 << n) via the exponent of a float: 2^n converts exactly for
+// n <= 30, and the out-of-range 2^31 converts to 0x80000000, which
+// happens to be (1 << 31) as well
+static inline __m128i typeBitsSse2(__m128i flags)
+{
+    __m128i index = _mm_and_si128(_mm_srli_epi32(flags, 1), _mm_set1_epi32(0x1f));
+    __m128i exponent = _mm_slli_epi32(_mm_add_epi32(index, _mm_set1_epi32(127)), 23);
+    return _mm_cvttps_epi32(_mm_castsi128_ps(exponent));
+}
+
+
+static inline uint32_t movemaskSse2(__m128i v)
+{
+    return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(v)));
+}
+
+
+const uint8_t* LeafScanner::scanFeaturesSse2(const LeafScanner& scanner,
+    const uint8_t* p, uint32_t* candidates)
+{
+    int32_t flags[BLOCK_SIZE];
+    int count = readFeatureFlags(p, flags);
+
+    const __m128i minX = _mm_set1_epi32(scanner.minX_);
+    const __m128i minY = _mm_set1_epi32(scanner.minY_);
+    const __m128i maxX = _mm_set1_epi32(scanner.maxX_);
+    const __m128i maxY = _mm_set1_epi32(scanner.maxY_);
+    const __m128i types = _mm_set1_epi32(static_cast<int32_t>(scanner.types_));
+    const __m128i northwest = _mm_set1_epi32(static_cast<int32_t>(scanner.northwestFlags_));
+    const __m128i bothTiles = _mm_set1_epi32(
+        FeatureFlags::MULTITILE_NORTH | FeatureFlags::MULTITILE_WEST);
+    const __m128i zero = _mm_setzero_si128();
+
+    uint32_t mask = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const uint8_t* e = p + i * FEATURE_ENTRY_SIZE;
+        __m128i e0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(e));
+        __m128i e1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(e + FEATURE_ENTRY_SIZE));
+        __m128i e2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(e + FEATURE_ENTRY_SIZE * 2));
+        __m128i e3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(e + FEATURE_ENTRY_SIZE * 3));
+        __m128i lo01 = _mm_unpacklo_epi32(e0, e1);     // minX0 minX1 minY0 minY1
+        __m128i lo23 = _mm_unpacklo_epi32(e2, e3);
+        __m128i hi01 = _mm_unpackhi_epi32(e0, e1);     // maxX0 maxX1 maxY0 maxY1
+        __m128i hi23 = _mm_unpackhi_epi32(e2, e3);
+        __m128i outside = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpgt_epi32(_mm_unpacklo_epi64(lo01, lo23), maxX),
+                _mm_cmpgt_epi32(_mm_unpackhi_epi64(lo01, lo23), maxY)),
+            _mm_or_si128(
+                _mm_cmpgt_epi32(minX, _mm_unpacklo_epi64(hi01, hi23)),
+                _mm_cmpgt_epi32(minY, _mm_unpackhi_epi64(hi01, hi23))));
+
+        __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(flags + i));
+        __m128i wrongType = _mm_cmpeq_epi32(
+            _mm_and_si128(typeBitsSse2(f), types), zero);
+        // Keep features that aren't in the tiles to the north/west,
+        // or that are in both (the northwest tile skips those)
+        __m128i keep = _mm_or_si128(
+            _mm_cmpeq_epi32(_mm_and_si128(f, northwest), zero),
+            _mm_cmpeq_epi32(_mm_and_si128(f, bothTiles), bothTiles));
+        uint32_t rejected = movemaskSse2(_mm_or_si128(outside, wrongType)) |
+            (movemaskSse2(keep) ^ 0xf);
+        mask |= (rejected ^ 0xf) << i;
+    }
+    for (; i < count; i++)
+    {
+        mask |= scanner.acceptFeature(p + i * FEATURE_ENTRY_SIZE, flags[i]) << i;
+    }
+    *candidates = mask;
+    return (flags[count - 1] & 1) ? nullptr : p + count * FEATURE_ENTRY_SIZE;
+}
+
+
+const uint8_t* LeafScanner::scanNodesSse2(const LeafScanner& scanner,
+    const uint8_t* p, uint32_t* candidates, uint16_t* offsets)
+{
+    int32_t flags[BLOCK_SIZE];
+    int count = readNodeFlags(p, flags, offsets);
+
+    const __m128i minX = _mm_set1_epi32(scanner.nodeMinX_);
+    const __m128i minY = _mm_set1_epi32(scanner.minY_);
+    const __m128i maxX = _mm_set1_epi32(scanner.nodeMaxX_);
+    const __m128i maxY = _mm_set1_epi32(scanner.maxY_);
+    const __m128i types = _mm_set1_epi32(static_cast<int32_t>(scanner.types_));
+    const __m128i zero = _mm_setzero_si128();
+
+    uint32_t mask = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i xy01 = _mm_unpacklo_epi64(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + offsets[i])),
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + offsets[i + 1])));
+        __m128i xy23 = _mm_unpacklo_epi64(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + offsets[i + 2])),
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + offsets[i + 3])));
+        __m128i x = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(xy01),
+            _mm_castsi128_ps(xy23), _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i y = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(xy01),
+            _mm_castsi128_ps(xy23), _MM_SHUFFLE(3, 1, 3, 1)));
+        __m128i outside = _mm_or_si128(
+            _mm_or_si128(_mm_cmpgt_epi32(x, maxX), _mm_cmpgt_epi32(y, maxY)),
+            _mm_or_si128(_mm_cmpgt_epi32(minX, x), _mm_cmpgt_epi32(minY, y)));
+
+        __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(flags + i));
+        __m128i wrongType = _mm_cmpeq_epi32(
+            _mm_and_si128(typeBitsSse2(f), types), zero);
+        mask |= (movemaskSse2(_mm_or_si128(outside, wrongType)) ^ 0xf) << i;
+    }
+    for (; i < count; i++)
+    {
+        mask |= scanner.acceptNode(p + offsets[i], flags[i]) << i;
+    }
+    *candidates = mask;
+    int32_t lastFlags = flags[count - 1];
+    return (lastFlags & 1) ? nullptr : p + offsets[count - 1] + 20 + (lastFlags & 4);
+}
+
+
+// Like the SSE2 kernel, but tests 8 entries at a time (entries i and
+// i + 4 share a 256-bit register, so the 4x4 transpose works within
+// each 128-bit lane). The type test uses a per-lane variable shift.
+
+// Loads the bounding boxes of the entry at `e` and the entry 4 places after it
+GEODESK_TARGET_AVX2
+static inline __m256i loadBoundsAvx2(const uint8_t* e)
+{
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(e))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(e + FEATURE_ENTRY_SIZE * 4)),
+        1);
+}
+
+
+GEODESK_TARGET_AVX2
+const uint8_t* LeafScanner::scanFeaturesAvx2(const LeafScanner& scanner,
+    const uint8_t* p, uint32_t* candidates)
+{
+    int32_t flags[BLOCK_SIZE];
+    int count = readFeatureFlags(p, flags);
+
+    const __m256i minX = _mm256_set1_epi32(scanner.minX_);
+    const __m256i minY = _mm256_set1_epi32(scanner.minY_);
+    const __m256i maxX = _mm256_set1_epi32(scanner.maxX_);
+    const __m256i maxY = _mm256_set1_epi32(scanner.maxY_);
+    const __m256i types = _mm256_set1_epi32(static_cast<int32_t>(scanner.types_));
+    const __m256i northwest = _mm256_set1_epi32(static_cast<int32_t>(scanner.northwestFlags_));
+    const __m256i bothTiles = _mm256_set1_epi32(
+        FeatureFlags::MULTITILE_NORTH | FeatureFlags::MULTITILE_WEST);
+    const __m256i typeIndexMask = _mm256_set1_epi32(0x1f);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i zero = _mm256_setzero_si256();
+
+    uint32_t mask = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const uint8_t* e = p + i * FEATURE_ENTRY_SIZE;
+        __m256i e04 = loadBoundsAvx2(e);
+        __m256i e15 = loadBoundsAvx2(e + FEATURE_ENTRY_SIZE);
+        __m256i e26 = loadBoundsAvx2(e + FEATURE_ENTRY_SIZE * 2);
+        __m256i e37 = loadBoundsAvx2(e + FEATURE_ENTRY_SIZE * 3);
+        __m256i lo01 = _mm256_unpacklo_epi32(e04, e15);
+        __m256i lo23 = _mm256_unpacklo_epi32(e26, e37);
+        __m256i hi01 = _mm256_unpackhi_epi32(e04, e15);
+        __m256i hi23 = _mm256_unpackhi_epi32(e26, e37);
+        __m256i outside = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpgt_epi32(_mm256_unpacklo_epi64(lo01, lo23), maxX),
+                _mm256_cmpgt_epi32(_mm256_unpackhi_epi64(lo01, lo23), maxY)),
+            _mm256_or_si256(
+                _mm256_cmpgt_epi32(minX, _mm256_unpacklo_epi64(hi01, hi23)),
+                _mm256_cmpgt_epi32(minY, _mm256_unpackhi_epi64(hi01, hi23))));
+
+        __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(flags + i));
+        __m256i typeIndex = _mm256_and_si256(_mm256_srli_epi32(f, 1), typeIndexMask);
+        __m256i wrongType = _mm256_cmpeq_epi32(
+            _mm256_and_si256(_mm256_srlv_epi32(types, typeIndex), one), zero);
+        __m256i keep = _mm256_or_si256(
+            _mm256_cmpeq_epi32(_mm256_and_si256(f, northwest), zero),
+            _mm256_cmpeq_epi32(_mm256_and_si256(f, bothTiles), bothTiles));
+        __m256i rejected = _mm256_or_si256(_mm256_or_si256(outside, wrongType),
+            _mm256_xor_si256(keep, _mm256_cmpeq_epi32(zero, zero)));
+        uint32_t rejectedBits = static_cast<uint32_t>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(rejected)));
+        mask |= (rejectedBits ^ 0xff) << i;
+    }
+    for (; i < count; i++)
+    {
+        mask |= scanner.acceptFeature(p + i * FEATURE_ENTRY_SIZE, flags[i]) << i;
+    }
+    *candidates = mask;
+    return (flags[count - 1] & 1) ? nullptr : p + count * FEATURE_ENTRY_SIZE;
+}
+
+#else
+
+// Non-x86 platforms only have the scalar kernels (isSupported()
+// reports the SIMD kernels as unavailable, so these are never used)
+
+const uint8_t* LeafScanner::scanFeaturesSse2(const LeafScanner& scanner,
+    const uint8_t* p, uint32_t* candidates)
+{
+    return scanFeaturesScalar(scanner, p, candidates);
+}
+
+const uint8_t* LeafScanner::scanNodesSse2(const LeafScanner& scanner,
+    const uint8_t* p, uint32_t* candidates, uint16_t* offsets)
+{
+    return scanNodesScalar(scanner, p, candidates, offsets);
+}
+
+const uint8_t* LeafScanner::scanFeaturesAvx2(const LeafScanner& scanner,
+    const uint8_t* p, uint32_t* candidates)
+{
+    return scanFeaturesScalar(scanner, p, candidates);
+}
+
+#endif
+
+} // namespace geodesk
@@ -2,7 +2,11 @@
 // SPDX-License-Identifier: LGPL-3.0-only
 
 #include <geodesk/query/Query.h>
+#include <algorithm>
+#include <clarisma/thread/SpinWait.h>
 #include <clarisma/util/log.h>
+#include <geodesk/geom/Area.h>
+#include <geodesk/geom/Length.h>
 #include <geodesk/query/TileQueryTask.h>
 
 namespace geodesk {
@@ -11,18 +15,32 @@ namespace geodesk {
 
 
 Query::Query(FeatureStore* store, const Box& box, FeatureTypes types,
-    const MatcherHolder* matcher, const Filter* filter) :
+    const MatcherHolder* matcher, const Filter* filter, const Options& options) :
     AbstractQuery(store),
     types_(types),
     matcher_(matcher),
     filter_(filter),
+    aggregate_(options.aggregate),
+    priority_(options.priority),
+    bucketSize_(std::max(options.bucketSize, 1u)),
+    limit_(options.limit),
+    returnedCount_(0),
     pendingTiles_(0),
     currentResults_(QueryResults::EMPTY),
     currentPos_(QueryResults::EMPTY->count),
     allTilesRequested_(false),
+    total_(0),
     tileIndexWalker_(store->tileIndex(), store->zoomLevels(), box, filter),
+    prefetchDistance_(options.prefetchDistance),
+    requestedTiles_(0),
+    prefetchedTiles_(0),
     queuedResults_(QueryResults::EMPTY),
-    completedTiles_(0)
+    completedTiles_(0),
+    queuedTotal_(0),
+    freeBuckets_(nullptr),
+    foundCount_(0),
+    consumerWoken_(false),
+    stopFlags_(0)
 {
     /*
     // Don't add refcount to store, wrapper object is responsible for liveness
@@ -36,21 +54,38 @@ Query::Query(FeatureStore* store, const Box& box, FeatureTypes types,
     tileIndexWalker_.next();
         // move the TIW to the root tile (This is not needed in v2,
         // since next() is called *after* each tile, not before)
+    if (prefetchDistance_)
+    {
+        prefetchWalker_.emplace(store->tileIndex(), store->zoomLevels(), box, filter);
+        prefetchWalker_->next();
+    }
+    store->executor().addClient();
     requestTiles();
 }
 
 
 
-// TODO: use a flag that indicates that query finished, which makes the destructor
-//  more efficient
+// If the Query is destroyed before all results have been consumed
+// (e.g. after first() or isEmpty()), we cancel it, so any tiles that
+// are still queued are skipped instead of scanned. We still have to
+// wait for all pending tiles, since their tasks refer to this Query.
 Query::~Query()
 {
     // LOG("Destroying Query...");
+    if (pendingTiles_) cancel();
     while(pendingTiles_)
     {
         deleteResults(take());
     }
     deleteResults(currentResults_);
+    QueryResults* res = freeBuckets_.load(std::memory_order_acquire);
+    while (res)
+    {
+        QueryResults* next = res->next;
+        QueryResults::destroy(res);
+        res = next;
+    }
+    store_->executor().removeClient();
     // LOG("Destroyed Query.");
 }
 
@@ -60,59 +95,226 @@ void Query::deleteResults(const QueryResults* res)
     while(res != QueryResults::EMPTY)
     {
         QueryResults* next = res->next;
-        delete res;
+        QueryResults::destroy(res);
         res = next;
     }
 }
 
 
-void Query::offer(QueryResults* res)
+/**
+ * Returns a consumed bucket to the pool of free buckets.
+ */
+void Query::recycle(const QueryResults* res)
+{
+    QueryResults* bucket = const_cast<QueryResults*>(res);
+    bucket->tilePin.reset();
+    recycle(bucket, bucket);
+}
+
+
+/**
+ * Returns a chain of buckets (linked via `next`) to the pool of free
+ * buckets. May be called by any thread.
+ */
+void Query::recycle(QueryResults* first, QueryResults* last)
+{
+    QueryResults* top = freeBuckets_.load(std::memory_order_relaxed);
+    do
+    {
+        last->next = top;
+    }
+    while (!freeBuckets_.compare_exchange_weak(top, first,
+        std::memory_order_release, std::memory_order_relaxed));
+}
+
+
+/**
+ * Removes all buckets from the pool of free buckets (or returns
+ * `nullptr` if there are none). The caller takes ownership of the
+ * returned chain; since a TileQueryTask always takes the entire
+ * chain, the pool is safe from the ABA problem.
+ */
+QueryResults* Query::takeFreeBuckets()
 {
-    // LOG("Putting fresh results into the queue...");
-    std::unique_lock lock(mutex_);
-    if (queuedResults_ == QueryResults::EMPTY)
+    if (freeBuckets_.load(std::memory_order_relaxed) == nullptr) return nullptr;
+    return freeBuckets_.exchange(nullptr, std::memory_order_acquire);
+}
+
+
+void Query::pushResults(QueryResults* first, QueryResults* last)
+{
+    QueryResults* top = queuedResults_.load(std::memory_order_relaxed);
+    do
     {
-        queuedResults_ = res;
+        last->next = top;
     }
-    else if(res != QueryResults::EMPTY)
+    while (!queuedResults_.compare_exchange_weak(top, first,
+        std::memory_order_release, std::memory_order_relaxed));
+}
+
+
+void Query::countFound(uint32_t uniqueCount)
+{
+    if (limit_ == UNLIMITED || uniqueCount == 0) return;
+    if (foundCount_.fetch_add(uniqueCount, std::memory_order_relaxed)
+        + uniqueCount >= limit_)
     {
-        QueryResults* first = queuedResults_->next;
-        queuedResults_->next = res->next;
-        res->next = first;
-        queuedResults_ = res;
+        limitReached();
     }
+}
 
-    completedTiles_++;
+
+/**
+ * Tells the TileQueryTasks to stop scanning, since enough features
+ * have been found. Unlike cancel(), the features that have been
+ * found are still delivered.
+ */
+void Query::limitReached()
+{
+    stopFlags_.fetch_or(LIMIT_REACHED, std::memory_order_relaxed);
+}
+
+
+void Query::wakeConsumer()
+{
+    std::lock_guard lock(parkMutex_);
+    consumerWoken_ = true;
     resultsReady_.notify_one();
 }
 
+
+/**
+ * Hands a full bucket of a tile that is still being scanned to the
+ * consumer, so it can start processing the features right away.
+ *
+ * Since the tile has not been completed, the Query is guaranteed
+ * to stay alive for the duration of this call.
+ */
+void Query::publish(QueryResults* bucket, uint32_t uniqueCount)
+{
+    pushResults(bucket, bucket);
+    countFound(uniqueCount);
+
+    // The fence pairs with the one in park(): Either we see that the
+    // consumer has parked, or the consumer sees the bucket
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint32_t state = completedTiles_.load(std::memory_order_relaxed);
+    while (state & CONSUMER_PARKED)
+    {
+        if (completedTiles_.compare_exchange_weak(state, state & ~CONSUMER_PARKED,
+            std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+            wakeConsumer();
+            break;
+        }
+    }
+}
+
+
+/**
+ * Hands the last bucket of a completed tile to the consumer (the other
+ * buckets have already been published). This method is lock-free
+ * unless the consumer has parked: the bucket is pushed onto a lock-free
+ * stack, and the tile is counted as completed.
+ *
+ * Once completedTiles_ has been incremented, the consumer may destroy
+ * the Query, so we must not touch it afterwards -- unless we're the
+ * producer that cleared the CONSUMER_PARKED flag, in which case the
+ * consumer waits for us to wake it.
+ */
+void Query::offer(QueryResults* res, double partial, uint32_t uniqueCount)
+{
+    if (res != QueryResults::EMPTY) pushResults(res, res);
+    if (partial != 0)
+    {
+        queuedTotal_.fetch_add(partial, std::memory_order_relaxed);
+    }
+    countFound(uniqueCount);
+
+    uint32_t completed = completedTiles_.load(std::memory_order_relaxed);
+    while (!completedTiles_.compare_exchange_weak(completed,
+        (completed & ~CONSUMER_PARKED) + 1,
+        std::memory_order_acq_rel, std::memory_order_relaxed))
+    {
+        // retry
+    }
+    if (completed & CONSUMER_PARKED) [[unlikely]]
+    {
+        wakeConsumer();
+    }
+}
+
+/**
+ * Cancels the Query. Tiles that have not yet been scanned are skipped
+ * by their TileQueryTask (they still count as completed), tiles that
+ * are being scanned are abandoned at the next branch or leaf, and no
+ * further tiles are requested. Once the consumer notices the
+ * cancellation, next() returns no further features.
+ *
+ * This method may be called from any thread.
+ */
 void Query::cancel()
 {
-    std::unique_lock lock(mutex_);
-    // TODO
+    stopFlags_.fetch_or(CANCELLED, std::memory_order_relaxed);
+}
+
+/**
+ * Blocks the consumer until at least one more tile has been completed,
+ * or a bucket has been published.
+ */
+void Query::park()
+{
+    std::unique_lock lock(parkMutex_);
+    consumerWoken_ = false;
+    uint32_t expected = 0;
+    if (!completedTiles_.compare_exchange_strong(expected, CONSUMER_PARKED,
+        std::memory_order_acq_rel, std::memory_order_relaxed))
+    {
+        return;     // a tile was completed in the meantime
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (queuedResults_.load(std::memory_order_relaxed) != QueryResults::EMPTY)
+    {
+        // A bucket was published in the meantime: Clear the flag
+        // ourselves, unless a producer has already claimed it
+        // (in which case we must wait for that producer to wake us)
+        expected = CONSUMER_PARKED;
+        if (completedTiles_.compare_exchange_strong(expected, 0,
+            std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+    resultsReady_.wait(lock, [this] { return consumerWoken_; });
 }
 
 const QueryResults* Query::take()
 {
     // LOG("Taking next batch...");
-    std::unique_lock lock(mutex_);
-    while (completedTiles_ == 0)
+    clarisma::SpinWait wait;
+    while (completedTiles_.load(std::memory_order_acquire) == 0 &&
+        queuedResults_.load(std::memory_order_relaxed) == QueryResults::EMPTY)
     {
-        resultsReady_.wait(lock);
+        if (!wait.spin()) park();
     }
-    QueryResults* res = queuedResults_;
-    queuedResults_ = QueryResults::EMPTY;
-    pendingTiles_ -= completedTiles_;
-    completedTiles_ = 0;
+    pendingTiles_ -= static_cast<int32_t>(
+        completedTiles_.exchange(0, std::memory_order_acquire));
+    total_ += queuedTotal_.exchange(0, std::memory_order_relaxed);
 
-    // Turn the circular list into a simple list ending with EMPTY
-    QueryResults* first = res->next;
-    res->next = QueryResults::EMPTY;
-    return first;
+    // The stack is a simple list ending with EMPTY (It may contain
+    // buckets of tiles that are still being scanned, or that are about
+    // to be counted as completed, which is harmless)
+    return queuedResults_.exchange(QueryResults::EMPTY,
+        std::memory_order_acquire);
 }
 
 void Query::requestTiles()
 {
+    if (isStopped())
+    {
+        allTilesRequested_ = true;
+        return;
+    }
 
     // Fill the queue with requests. If the queue is full, submit 1 request
     // (blocking until a spot frees up).
@@ -142,9 +344,16 @@ void Query::requestTiles()
     }
     */
 
-    bool postedAny = false;
+    // To be fair to other queries that share the executor, we keep
+    // at most our fair share of tiles in flight
+
+    TileQueryTaskExecutor& executor = store_->executor();
+    int maxPendingTiles = executor.fairShare();
     for (;;)
     {
+        if (pendingTiles_ >= maxPendingTiles) break;
+        if (prefetchWalker_) prefetchTiles();
+
         TileQueryTask task(this,
             (tileIndexWalker_.currentTip() << 8) |
             tileIndexWalker_.northwestFlags(),
@@ -152,14 +361,14 @@ void Query::requestTiles()
 
         // LOG("Trying to submit %06X...", tileIndexWalker_.currentTip());
 
-        if (!store_->executor().tryPost(task))
+        if (!executor.tryPost(task, static_cast<int>(priority_)))
         {
-            // If the queue is full and we haven't been able to
-            // post at least one task, we'll run the task on the main
+            // If the queues are full and we don't have at least one
+            // tile pending, we'll run the task on the main
             // thread; otherwise, we'll end up waiting for a tile
             // that will never arrive = deadlock
 
-            if (postedAny)  [[likely]]
+            if (pendingTiles_ > 0)  [[likely]]
             {
                 break;
             }
@@ -172,7 +381,7 @@ void Query::requestTiles()
             pendingTiles_++;
             // LOG("  Submitted %06X", tileIndexWalker_.currentTip());
         }
-        postedAny = true;
+        requestedTiles_++;
         if (!tileIndexWalker_.next())
         {
             // LOG("All tiles submitted.");
@@ -183,8 +392,32 @@ void Query::requestTiles()
     
 }
 
+/// Prefetches the tiles that follow the one about to be requested,
+/// up to prefetchDistance_ tiles ahead. The prefetch walker visits the
+/// same tiles in the same order as tileIndexWalker_, so we only need
+/// to count how far ahead it is.
+void Query::prefetchTiles()
+{
+    while (prefetchedTiles_ <= requestedTiles_ + prefetchDistance_)
+    {
+        if (prefetchedTiles_ > requestedTiles_)
+        {
+            // The tile about to be requested needs no prefetch,
+            // since it will be read right away
+            store_->prefetchTile(prefetchWalker_->currentTip());
+        }
+        prefetchedTiles_++;
+        if (!prefetchWalker_->next())
+        {
+            prefetchWalker_.reset();
+            break;
+        }
+    }
+}
+
 FeaturePtr Query::next()
 {
+    if (returnedCount_ == limit_) return nullptr;
     for (;;)
     {
         if (currentPos_ == currentResults_->count)
@@ -192,7 +425,7 @@ FeaturePtr Query::next()
             // We're at the end of the current batch;
             // move on to the next
             QueryResults* next = currentResults_->next;
-            if (currentResults_ != QueryResults::EMPTY) delete currentResults_;
+            if (currentResults_ != QueryResults::EMPTY) recycle(currentResults_);
             currentPos_ = 0;
             currentResults_ = next;
             if (next == QueryResults::EMPTY)
@@ -200,9 +433,10 @@ FeaturePtr Query::next()
                 // We've consumed all current batches;
                 for(;;)
                 {
-                    if (pendingTiles_ == 0)
+                    if (pendingTiles_ == 0 || isCancelled())
                     {
-                        // There are no more tiles: We're done
+                        // There are no more tiles (or the Query has
+                        // been cancelled): We're done
                         return nullptr;
                     }
                     const QueryResults* res = take();
@@ -219,19 +453,61 @@ FeaturePtr Query::next()
                 // LOG("Next batch of current results...");
             }
         }
-        uint32_t item = currentResults_->items[currentPos_++];
+        uint32_t item = currentResults_->items()[currentPos_++];
         DataPtr pTile = currentResults_->pTile;
         if (item & REQUIRES_DEDUP)
         {
             FeaturePtr pFeature (pTile + (item & ~REQUIRES_DEDUP));
             uint64_t idBits = pFeature.idBits();  // getUnsignedLong() & 0xffff'ffff'ffff'ff18LL;
-            if (potentialDupes_.count(idBits)) continue;
+            // A feature lives in at most two tiles (a TilePair), so
+            // once we've seen its twin, we no longer need to track it
+            // (This keeps the set small, even for wide-area queries)
+            if (potentialDupes_.erase(idBits)) continue;
             potentialDupes_.insert(idBits);
+            returnedCount_++;
             return pFeature;
         }
+        returnedCount_++;
         return FeaturePtr(pTile + item);
     }
 }
 
 
+double Query::aggregate()
+{
+    assert(aggregate_ != Aggregate::NONE);
+    double dupesTotal = 0;
+    for (;;)
+    {
+        // Only features that require deduplication are delivered
+        // individually; all others have already been reduced to
+        // per-tile partials by the TileQueryTasks
+        FeaturePtr pFeature = next();
+        if (pFeature.isNull()) break;
+        dupesTotal += measure(store_, pFeature, aggregate_);
+    }
+    return total_ + dupesTotal;
+}
+
+
+double Query::measure(FeatureStore* store, FeaturePtr feature, Aggregate aggregate)
+{
+    switch (aggregate)
+    {
+    case Aggregate::COUNT:
+        return 1;
+    case Aggregate::LENGTH:
+        if (feature.isWay()) return Length::ofWay(WayPtr(feature));
+        if (feature.isRelation()) return Length::ofRelation(store, RelationPtr(feature));
+        return 0;
+    case Aggregate::AREA:
+        if (!feature.isArea()) return 0;
+        if (feature.isWay()) return Area::ofWay(WayPtr(feature));
+        return Area::ofRelation(store, RelationPtr(feature));
+    default:
+        return 0;
+    }
+}
+
+
 } // namespace geodesk
@@ -15,6 +15,7 @@ TileIndexWalker::TileIndexWalker(
 	currentLevel_(0),
     box_(box),
     filter_(filter),
+    turboFlags_(0),
     tileBasedAcceleration_(false),
     trackAcceptedTiles_(false)
 {
@@ -110,10 +111,10 @@ bool TileIndexWalker::next()
 
             if (tileBasedAcceleration_)
             {
-                // TODO: Don't call acceptTile() if all turbo-flags are
-                // set for the current tile
-                
-                int turboFlags = filter_->acceptTile(currentTile_);
+                // If the parent tile was accepted in its entirety,
+                // so are all of its children
+                int turboFlags = level->turboFlags ? level->turboFlags :
+                    filter_->acceptTile(currentTile_);
                 if (turboFlags < 0) continue;
                 turboFlags_ = static_cast<uint32_t>(turboFlags);
                 
@@ -199,7 +200,11 @@ void TileIndexWalker::startLevel(Level* level, int tip)
 
     level->childTileMask = (pIndex_ + (tip + 1) * 4).getUnsignedLong();
     level->pChildEntries = tip + (step == 3 ? 3 : 2);
-    level->turboFlags = 0; // TODO
+    // A tile that lies fully inside the filter's area (and hence is
+    // eligible for acceleration) has children that lie fully inside
+    // as well; this does not apply to the per-child-filter flags
+    // of a ComboFilter, which may each be partial
+    level->turboFlags = (turboFlags_ && !filter_->isCombo()) ? turboFlags_ : 0;
 }
 
 void TileIndexWalker::startRoot()
@@ -216,6 +221,7 @@ void TileIndexWalker::startRoot()
     level->currentRow = 0;
     level->childTileMask = ~0;
     level->pChildEntries = 1;   // TODO: not used for root?
+    level->turboFlags = 0;
 }
 
 } // namespace geodesk
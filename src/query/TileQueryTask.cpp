@@ -5,10 +5,11 @@
 #include <geodesk/feature/FeaturePtr.h>
 #include <geodesk/feature/types.h>
 #include <geodesk/query/Query.h>
+#include <geodesk/query/TileIndexScan.h>
 
 namespace geodesk {
 
-QueryResultsHeader QueryResults::EMPTY_HEADER = { EMPTY, DataPtr(), DEFAULT_BUCKET_SIZE };
+QueryResultsHeader QueryResults::EMPTY_HEADER = { EMPTY, DataPtr(), 0, 0, TilePin() };
 QueryResults* const QueryResults::EMPTY = reinterpret_cast<QueryResults*>(&EMPTY_HEADER);
 
 // TODO: perform type check prior to matcher
@@ -20,285 +21,134 @@ QueryResults* const QueryResults::EMPTY = reinterpret_cast<QueryResults*>(&EMPTY
 
 void TileQueryTask::operator()()
 {
+	if (query_->isStopped())
+	{
+		// Skip the scan, but the tile must still be accounted for
+		query_->offer(results_);
+		return;
+	}
+	// The branch and leaf scanners check for cancellation as well,
+	// so a cancelled Query (or one that has reached its limit)
+	// abandons a tile that is being scanned
+	// (The results found so far are handed over regardless, since
+	// the Query is responsible for freeing them)
 	Tip tip = Tip(tipAndFlags_ >> 8);
-	pTile_ = query_->store()->fetchTile(tip);
-	uint32_t types = query_->types();
+	pTile_ = query_->store()->fetchTile(tip, tilePin_);
 
-	// LOG("Scanning tile %06X", tip);
+	// The other copy of a multi-tile feature lives in a different
+	// tile, which the Query will only visit if its bounding box
+	// extends beyond this tile; otherwise, no deduplication is needed
+	dupeFlag_ = fastFilterHint_.tile.bounds().containsSimple(query_->bounds()) ?
+		0 : Query::REQUIRES_DEDUP;
 
-	if (types & FeatureTypes::NODES) searchNodeIndexes();
-	if (types & FeatureTypes::NONAREA_WAYS) searchIndexes(FeatureIndexType::WAYS);
-	if (types & FeatureTypes::AREAS) searchIndexes(FeatureIndexType::AREAS);
-	if (types & FeatureTypes::NONAREA_RELATIONS) searchIndexes(FeatureIndexType::RELATIONS);
-	query_->offer(results_);
-}
+	// LOG("Scanning tile %06X", tip);
 
-void TileQueryTask::searchNodeIndexes()
-{
-	const MatcherHolder* matcher = query_->matcher();
-	DataPtr ppRoot = pTile_ + 8;
-	int32_t ptr = ppRoot.getInt();
-	if (ptr == 0) return;
-	if ((ptr & 1) == 0)
+	// The scan skips any feature that has a second copy in the tile
+	// to the west (or north), if the query's bounding box extends
+	// into that tile (since the other tile will return it)
+	TileIndexScan<TileQueryTask> scan(*this, query_->store(), query_->bounds(),
+		query_->types(), query_->matcher(), query_->filter(), fastFilterHint_,
+		tipAndFlags_ & (FeatureFlags::MULTITILE_NORTH | FeatureFlags::MULTITILE_WEST));
+	scan.scan(pTile_);
+	if (freeBuckets_)
 	{
-		// method_ = matcher->method(FeatureIndexType::NODES);
-		searchNodeRoot(ppRoot);
-		return;
-	}
-	
-	DataPtr p = ppRoot + (ptr ^ 1);
-	for (;;)
-	{
-		int32_t last = p.getInt() & 1;
-		int32_t keys = (p+4).getInt();
-		if (matcher->acceptIndex(FeatureIndexType::NODES, keys))
-		{
-			searchNodeRoot(p);
-		}
-		if (last != 0) break;
-		p += 8;
+		// Return any unused buckets (must happen before we offer
+		// the results, since the Query may be gone afterwards)
+		QueryResults* last = freeBuckets_;
+		while (last->next) last = last->next;
+		query_->recycle(freeBuckets_, last);
 	}
+	tilePin_.reset();
+		// the buckets hold their own pins
+	query_->offer(results_, partial_, uniqueCount_);
 }
 
-void TileQueryTask::searchNodeRoot(DataPtr ppRoot)
+bool TileQueryTask::isStopped() const
 {
-	int32_t ptr = ppRoot.getInt();
-	if (ptr)
-	{
-		DataPtr p = ppRoot + (ptr & 0xffff'fffc);
-		if (ptr & 2)
-		{
-			searchNodeLeaf(p);
-		}
-		else
-		{
-			searchNodeBranch(p);
-		}
-	}
+	return query_->isStopped();
 }
 
-void TileQueryTask::searchNodeBranch(DataPtr p)
+void TileQueryTask::foundNode(FeaturePtr node)
 {
-	// LOG("Searching branch at %016X", p);
-	Box box = query_->bounds();
-	for (;;)
-	{
-		int32_t ptr = p.getInt();
-		int32_t last = ptr & 1;
-		if (box.intersects(*reinterpret_cast<const Box*>((const uint8_t *)p + 4)))
-		{
-			DataPtr pChild = p + (ptr & 0xffff'fffc);
-			if (ptr & 2)
-			{
-				searchNodeLeaf(pChild);
-			}
-			else
-			{
-				searchNodeBranch(pChild);
-			}
-		}
-		if (last != 0) break;
-		p += 20;
-	}
+	// LOG("Found node/%llu", Feature::id(node));
+	addResult(static_cast<uint32_t>(node.ptr() - pTile_));
 }
 
-void TileQueryTask::searchNodeLeaf(DataPtr p)
+void TileQueryTask::foundFeature(FeaturePtr feature)
 {
-	// LOG("Searching leaf at %016X", p);
-	Box box = query_->bounds();
-	FeatureTypes acceptedTypes = query_->types();
-	const Matcher& matcher = query_->matcher()->mainMatcher();
-
-	for (;;)
-	{
-		int32_t flags = (p+8).getInt();
-		if (box.contains(p.getInt(), (p+4).getInt()))
-		{
-			if (acceptedTypes.acceptFlags(flags))
-			{
-				FeaturePtr pFeature(p + 8);
-				if (matcher.accept(pFeature))
-				{
-					const Filter* filter = query_->filter();
-					if (filter == nullptr || filter->accept(query_->store(),
-						pFeature, fastFilterHint_))
-					{
-						// LOG("Found node/%llu", Feature::id(pFeature));
-						addResult(static_cast<uint32_t>(pFeature.ptr() - pTile_));
-					}
-				}
-			}
-		}
-		if (flags & 1) break;
-		p += 20 + (flags & 4);	
-		// If Node is member of relation (flag bit 2), add
-		// extra 4 bytes for the relation table pointer
-	}
+	// If both multi-tile flags are set, we'll have
+	// to add the feature to the deduplication set
+	// (unless the query does not extend beyond the
+	// tile boundaries)
+	uint32_t dupeFlag = ((feature.flags() &
+		(FeatureFlags::MULTITILE_NORTH | FeatureFlags::MULTITILE_WEST)) ==
+		(FeatureFlags::MULTITILE_NORTH | FeatureFlags::MULTITILE_WEST)) ?
+		dupeFlag_ : 0;
+	// LOG("Found %s/%llu", Feature::typeName(feature), Feature::id(feature));
+	addResult(static_cast<uint32_t>(feature.ptr() - pTile_) | dupeFlag);
 }
 
-
-
-void TileQueryTask::searchIndexes(FeatureIndexType indexType)
+/**
+ * Add a relative pointer to the list of results.
+ * If the current bucket is full, it is handed to the Query right
+ * away (so the consumer can start processing its features while we're
+ * still scanning the tile), and we start a new bucket.
+ * - `results_` always points to the current bucket
+ *
+ * If the Query is aggregating, the feature's measure is added
+ * to the tile's partial total instead (unless the feature
+ * requires deduplication, which the Query must handle)
+ */
+void TileQueryTask::addResult(uint32_t item)
 {
-	const MatcherHolder* matcher = query_->matcher();
-	DataPtr ppRoot = pTile_ + 8 + indexType * 4;
-	int32_t ptr = ppRoot.getInt();
-	if (ptr == 0) return;
-	if ((ptr & 1) == 0)
+	Query::Aggregate aggregate = query_->aggregateMode();
+	if (aggregate != Query::Aggregate::NONE &&
+		(item & Query::REQUIRES_DEDUP) == 0)
 	{
-		// method_ = matcher->method(indexType);
-		searchRoot(ppRoot);
+		partial_ += Query::measure(query_->store(),
+			FeaturePtr(pTile_ + item), aggregate);
 		return;
 	}
-
-	DataPtr p = ppRoot + (ptr ^ 1);
-	for (;;)
-	{
-		int32_t last = p.getInt() & 1;
-		int32_t keys = (p+4).getInt();
-		if (matcher->acceptIndex(indexType, keys))
-		{
-			searchRoot(p);
-		}
-		if (last != 0) break;
-		p += 8;
-	}
-}
-
-
-void TileQueryTask::searchRoot(DataPtr ppRoot)
-{
-	int32_t ptr = ppRoot.getInt();
-	if (ptr)
-	{
-		DataPtr p = ppRoot + (ptr & 0xffff'fffc);
-		if (ptr & 2)
-		{
-			searchLeaf(p);
-		}
-		else
-		{
-			searchBranch(p);
-		}
-	}
-}
-
-void TileQueryTask::searchBranch(DataPtr p)
-{
-	Box box = query_->bounds();
-	for (;;)
+	if (results_->isFull())
 	{
-		int32_t ptr = p.getInt();
-		int32_t last = ptr & 1;
-		if (box.intersects(*reinterpret_cast<const Box*>((const uint8_t*)p + 4)))
+		if (results_ != QueryResults::EMPTY)
 		{
-			DataPtr pChild = p + (ptr & 0xffff'fffc);
-			if (ptr & 2)
-			{
-				searchLeaf(pChild);
-			}
-			else
-			{
-				searchBranch(pChild);		// NOLINT recursion
-			}
+			query_->publish(results_, uniqueCount_);
+			uniqueCount_ = 0;
 		}
-		if (last != 0) break;
-		p += 20;
+		results_ = allocateResults();
 	}
-}
-
-
-void TileQueryTask::searchLeaf(DataPtr p)
-{
-	Box box = query_->bounds();
-	FeatureTypes acceptedTypes = query_->types();
-	const Matcher& matcher = query_->matcher()->mainMatcher();
-
-	for (;;)
+	results_->items()[results_->count++] = item;
+	if ((item & Query::REQUIRES_DEDUP) == 0)
 	{
-		int32_t flags = (p+16).getInt();
-		int32_t multiTileFlags = flags & 
-			(FeatureFlags::MULTITILE_NORTH | FeatureFlags::MULTITILE_WEST);
-		for (;;)
-		{
-			int32_t dupeFlag = 0;
-			if (multiTileFlags)
-			{
-				if (multiTileFlags == FeatureFlags::MULTITILE_WEST)
-				{
-					// If the feature has a second copy in the tile
-					// to the west, and the query's bounding box
-					// extends into that tile, we skip the feature
-
-					if (tipAndFlags_ & FeatureFlags::MULTITILE_WEST) break;
-				}
-				else if (multiTileFlags == FeatureFlags::MULTITILE_NORTH)
-				{
-					// If the feature has a second copy in the tile
-					// to the north, and the query's bounding box
-					// extends into that tile, we skip the feature
-
-					if (tipAndFlags_ & FeatureFlags::MULTITILE_NORTH) break;
-				}
-				else
-				{
-					// If both flags are set, this means we'll have
-					// to add the feature to the deduplication set
-					// TODO: if query does not extend beyond the
-					// tile boundaries, we don't have to do this
-					dupeFlag = Query::REQUIRES_DEDUP;
-				}
-			}
-			if (!(p.getInt() > box.maxX() ||
-				(p+4).getInt() > box.maxY() ||
-				(p+8).getInt() < box.minX() ||
-				(p+12).getInt() < box.minY()))
-			{
-				// TODO: replace this branching code with arithmetic?
-				// Useful? https://stackoverflow.com/a/62852710
-
-				if (acceptedTypes.acceptFlags(flags))
-				{
-					FeaturePtr pFeature (p + 16);
-					if (matcher.accept(pFeature))
-					{
-						const Filter* filter = query_->filter();
-						if (filter == nullptr || filter->accept(query_->store(), 
-							pFeature, fastFilterHint_))
-						{
-							// LOG("Found %s/%llu", Feature::typeName(pFeature), Feature::id(pFeature));
-							addResult(static_cast<uint32_t>(pFeature.ptr() - pTile_) | dupeFlag);	// TODO
-						}
-					}
-				}
-			}
-			break;
-		}
-		if (flags & 1) break;
-		p += 32;
+		// If this tile alone satisfies the Query's limit, there's
+		// no need to wait until the bucket is published
+		if (++uniqueCount_ == query_->limit()) query_->limitReached();
 	}
-
 }
 
 /**
- * Add a relative pointer to the list of results.
- * If the current bucket is full, place a new bucket at the end
- * of the circular linked list of buckets.
- * - `results_` always points to the last bucket
+ * Obtains an empty bucket, preferably one that has been recycled
+ * by the Query's consumer.
  */
-void TileQueryTask::addResult(uint32_t item)
+QueryResults* TileQueryTask::allocateResults()
 {
-	if (results_->isFull())
+	if (!freeBuckets_) freeBuckets_ = query_->takeFreeBuckets();
+	QueryResults* res;
+	if (freeBuckets_)
+	{
+		res = freeBuckets_;
+		freeBuckets_ = res->next;
+	}
+	else
 	{
-		QueryResults* next = new QueryResults();
-		QueryResults* last = (results_ == QueryResults::EMPTY) ? next : results_;
-		next->count = 0;
-		next->pTile = pTile_;
-		next->next = last->next;
-		last->next = next;
-		results_ = next;
+		res = QueryResults::create(query_->bucketSize());
 	}
-	results_->items[results_->count++] = item;
+	res->next = QueryResults::EMPTY;
+	res->pTile = pTile_;
+	res->tilePin = tilePin_;
+	res->count = 0;
+	return res;
 }
 
 
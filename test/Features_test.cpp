@@ -1,11 +1,16 @@
 // Copyright (c) 2024 Clarisma / GeoDesk contributors
 // SPDX-License-Identifier: LGPL-3.0-only
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <memory>
+#include <string>
 #include <string_view>
 #include <catch2/catch_test_macros.hpp>
 #include <geodesk/geodesk.h>
+#include <geodesk/query/Query.h>
+#include "geom/polygon/Ring.h"
 
 using namespace geodesk;
 
@@ -148,4 +153,313 @@ TEST_CASE("Issue 21")
 	Features features = tile("w");
 }
 
+TEST_CASE_METHOD(GolFixture, "Features::byId")
+{
+	monaco.store()->buildIdIndex();
+	std::vector<uint64_t> ids;
+	for (Way street : monaco("w[highway]").limit(100))
+	{
+		std::optional<Feature> found = monaco.byId(FeatureType::WAY, street.id());
+		REQUIRE(found.has_value());
+		REQUIRE(*found == street);
+		ids.push_back(street.id());
+	}
+	ids.push_back(0);		// never a valid ID
+	std::vector<std::optional<Feature>> found = monaco.byIds(FeatureType::WAY, ids);
+	REQUIRE(found.size() == ids.size());
+	for (size_t i = 0; i < ids.size() - 1; i++)
+	{
+		REQUIRE(found[i].has_value());
+		REQUIRE(found[i]->id() == static_cast<int64_t>(ids[i]));
+	}
+	REQUIRE(!found.back().has_value());
+	REQUIRE(!monaco.nodes().byId(FeatureType::WAY, ids[0]).has_value());
+
+	// An index built for another version of the GOL is refused
+	std::string path = IdIndex::defaultPath(monaco.store()->fileName());
+	GolIdentity identity = monaco.store()->identity();
+	IdIndex current;
+	REQUIRE(current.open(path, identity));
+	identity.tileIndexChecksum++;
+	IdIndex stale;
+	REQUIRE(!stale.open(path, identity));
+}
+
+TEST_CASE_METHOD(GolFixture, "Batch queries")
+{
+	std::vector<Coordinate> points;
+	std::vector<Box> boxes;
+	for (Feature shop : monaco.nodes("n[shop]").limit(50))
+	{
+		points.push_back(shop.xy());
+		boxes.push_back(shop.bounds());
+	}
+	Features buildings = monaco("a[building]");
+	std::vector<std::vector<Feature>> containing(points.size());
+	buildings.forEachContaining(points, [&](size_t i, Feature f)
+	{
+		containing[i].push_back(f);
+	});
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		REQUIRE(containing[i].size() == buildings.containing(points[i]).count());
+	}
+	uint64_t intersecting = 0;
+	buildings.forEachIntersecting(boxes, [&](size_t, Feature)
+	{
+		intersecting++;
+	});
+	uint64_t expected = 0;
+	for (const Box& box : boxes) expected += buildings(box).count();
+	REQUIRE(intersecting == expected);
+}
+
+TEST_CASE_METHOD(GolFixture, "Cached polygonizers")
+{
+	PolygonizerCache& cache = monaco.store()->polygonizerCache();
+	cache.setBudget(PolygonizerCache::DEFAULT_BUDGET);
+	std::vector<double> areas;
+	for (Feature rel : monaco.relations("a"))
+	{
+		areas.push_back(rel.area());
+	}
+	PolygonizerCache::Stats before = cache.stats();
+	size_t i = 0;
+	for (Feature rel : monaco.relations("a"))
+	{
+		REQUIRE(rel.area() == areas[i++]);
+	}
+	REQUIRE(cache.stats().hits - before.hits == before.count);
+	cache.setBudget(0);
+	REQUIRE(cache.stats().count == 0);
+}
+
+// Counts the outer rings and their holes
+static size_t countRings(const Polygonizer& polygonizer)
+{
+	size_t count = 0;
+	for (const Polygonizer::Ring* outer = polygonizer.outerRings();
+		outer; outer = outer->next())
+	{
+		count++;
+		for (const Polygonizer::Ring* inner = outer->firstInner();
+			inner; inner = inner->next())
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+TEST_CASE_METHOD(GolFixture, "Polygonizing on multiple threads")
+{
+	FeatureStore* store = world.store();
+	PolygonizerCache& cache = store->polygonizerCache();
+	cache.setBudget(0);		// assemble the rings each time
+	Relations countries = world.relations("a[boundary=administrative][admin_level=2]");
+
+	std::vector<double> areas;
+	std::vector<Coordinate> centroids;
+	std::vector<size_t> ringCounts;
+	cache.setMaxThreads(1);
+	for (Relation rel : countries)
+	{
+		areas.push_back(rel.area());
+		centroids.push_back(rel.centroid());
+		ringCounts.push_back(countRings(*cache.rings(store, rel.ptr(), true)));
+	}
+	REQUIRE(!areas.empty());
+
+	// Use a low threshold so even small relations are assembled
+	// (and their holes assigned) in parallel
+	cache.setMaxThreads(4, 2);
+	REQUIRE(cache.maxThreads() == 4);
+	size_t i = 0;
+	for (Relation rel : countries)
+	{
+		// The member ways are decoded in parallel, but the
+		// rings are still built in order
+		REQUIRE(rel.area() == areas[i]);
+		REQUIRE(rel.centroid() == centroids[i]);
+		REQUIRE(countRings(*cache.rings(store, rel.ptr(), true)) == ringCounts[i]);
+		i++;
+	}
+	REQUIRE(i == areas.size());
+	cache.setMaxThreads(1);
+	cache.setBudget(PolygonizerCache::DEFAULT_BUDGET);
+}
+
+TEST_CASE_METHOD(GolFixture, "Prefetching does not change results")
+{
+	FeatureStore* store = monaco.store();
+	REQUIRE(store->prefetchDistance() == 0);
+	std::vector<int64_t> expected;
+	for (Feature f : monaco("w[highway]")) expected.push_back(f.id());
+	std::sort(expected.begin(), expected.end());	// tiles may complete in any order
+	uint64_t expectedCount = monaco("na[building]").count();
+
+	for (uint32_t distance : { 1u, 8u, 1000u })
+	{
+		store->setPrefetchDistance(distance);
+		std::vector<int64_t> ids;
+		for (Feature f : monaco("w[highway]")) ids.push_back(f.id());
+		std::sort(ids.begin(), ids.end());
+		REQUIRE(ids == expected);
+		REQUIRE(monaco("na[building]").count() == expectedCount);
+	}
+	store->setPrefetchDistance(0);
+}
+
+TEST_CASE_METHOD(GolFixture, "Aggregates match iteration")
+{
+	// count(), length() and area() are summed up per tile by the
+	// query workers; they must agree with measuring each feature
+	for (const char* query : { "w[highway]", "a[building]", "a[natural=water]", "na" })
+	{
+		Features features = monaco(query);
+		uint64_t count = 0;
+		double length = 0;
+		double area = 0;
+		for (Feature f : features)
+		{
+			count++;
+			length += f.length();
+			area += f.area();
+		}
+		// (The partials are added up in a different order)
+		REQUIRE(features.count() == count);
+		REQUIRE(std::abs(features.length() - length) <= length * 1e-9);
+		REQUIRE(std::abs(features.area() - area) <= area * 1e-9);
+	}
+}
+
+TEST_CASE_METHOD(GolFixture, "Cancelled queries stop scanning")
+{
+	FeatureStore* store = world.store();
+	Query::Options options;
+	options.bucketSize = 16;
+
+	// A Query cancelled before its first result returns nothing
+	{
+		Query query(store, Box::ofWorld(), FeatureTypes::WAYS,
+			store->borrowAllMatcher(), nullptr, options);
+		query.cancel();
+		REQUIRE(query.isCancelled());
+		REQUIRE(query.next().isNull());
+	}
+
+	// Once cancelled, only the results that have already been
+	// handed over are returned (and the destructor doesn't wait
+	// for the tiles that are still queued)
+	uint64_t total = world.ways().count();
+	Query query(store, Box::ofWorld(), FeatureTypes::WAYS,
+		store->borrowAllMatcher(), nullptr, options);
+	REQUIRE(!query.next().isNull());
+	query.cancel();
+	uint64_t returned = 1;
+	while (!query.next().isNull()) returned++;
+	REQUIRE(returned < total);
+}
+
+TEST_CASE_METHOD(GolFixture, "Limited queries and small result buckets")
+{
+	Features highways = monaco("w[highway]");
+	uint64_t total = highways.count();
+	REQUIRE(total > 100);
+
+	uint64_t n = 0;
+	for ([[maybe_unused]] Feature f : highways.limit(10)) n++;
+	REQUIRE(n == 10);
+	REQUIRE(highways.limit(10).count() == 10);
+	REQUIRE(highways.limit(total + 1).count() == total);
+	REQUIRE(highways.limit(0).isEmpty());
+
+	// Narrowing a limited set would have to pick from its first
+	// features only, so it is rejected
+	Features limited = highways.limit(10);
+	REQUIRE_THROWS_AS(limited("[name]"), QueryException);
+	REQUIRE_THROWS_AS(limited(Box::ofWSEN(7.4, 43.7, 7.5, 43.8)), QueryException);
+	REQUIRE_THROWS_AS(limited.maxMetersFrom(100, Coordinate::ofLonLat(7.42, 43.73)),
+		QueryException);
+	REQUIRE(highways("[name]").limit(10).count() == 10);
+
+	// Tiny buckets are handed over (and recycled) many times per
+	// tile; the results must be the same as with the default size
+	FeatureStore* store = monaco.store();
+	std::vector<uint64_t> expected;
+	for (Feature f : highways) expected.push_back(f.ptr().idBits());
+	std::sort(expected.begin(), expected.end());
+	const geodesk::MatcherHolder* matcher = store->getMatcher("w[highway]");
+	for (uint32_t bucketSize : { 1u, 4u, 33u })
+	{
+		Query::Options options;
+		options.bucketSize = bucketSize;
+		Query query(store, Box::ofWorld(), FeatureTypes::WAYS,
+			matcher, nullptr, options);
+		std::vector<uint64_t> ids;
+		for (;;)
+		{
+			FeaturePtr feature = query.next();
+			if (feature.isNull()) break;
+			ids.push_back(feature.idBits());
+		}
+		std::sort(ids.begin(), ids.end());
+		REQUIRE(ids == expected);
+	}
+	matcher->release();
+}
+
+TEST_CASE_METHOD(GolFixture, "Kernel matchers agree with bytecode matchers")
+{
+	// Single-selector queries on global keys are matched by a
+	// KernelMatcher; a query made up of two identical selectors
+	// selects the same features, but is always compiled to bytecode
+	for (const char* query : {
+		"w[highway]",
+		"w[highway=primary,secondary,tertiary]",
+		"na[building][name]",
+		"n[amenity=restaurant,cafe][name]",
+		"w[highway][maxspeed>=30][maxspeed<60]",
+		"a[building:levels>=3]",
+		"w[lanes=2]" })
+	{
+		std::string interpreted = std::string(query) + ", " + query;
+		std::vector<uint64_t> expected;
+		for (Feature f : monaco(interpreted.c_str())) expected.push_back(f.ptr().idBits());
+		std::vector<uint64_t> ids;
+		for (Feature f : monaco(query)) ids.push_back(f.ptr().idBits());
+		std::sort(expected.begin(), expected.end());
+		std::sort(ids.begin(), ids.end());
+		REQUIRE(ids == expected);
+	}
+}
+
+TEST_CASE_METHOD(GolFixture, "Kernel matchers with several clauses for one key")
+{
+	// [maxspeed>=30][maxspeed<60] are merged into one clause, which
+	// the KernelMatcher leaves to the bytecode; either way, the result
+	// must agree with testing each value
+	const char* query = "w[maxspeed>=30][maxspeed<60]";
+	std::string interpreted = std::string(query) + ", " + query;
+	std::vector<uint64_t> expected;
+	for (Feature f : monaco("w[maxspeed]"))
+	{
+		std::string value = f["maxspeed"];
+		double speed;
+		if (clarisma::Math::parseDouble(value, &speed) && speed >= 30 && speed < 60)
+		{
+			expected.push_back(f.ptr().idBits());
+		}
+	}
+	REQUIRE(!expected.empty());
+	std::sort(expected.begin(), expected.end());
+	for (const char* q : { query, interpreted.c_str() })
+	{
+		std::vector<uint64_t> ids;
+		for (Feature f : monaco(q)) ids.push_back(f.ptr().idBits());
+		std::sort(ids.begin(), ids.end());
+		REQUIRE(ids == expected);
+	}
+}
+
 // TODO: Test if parent relation iterator respect types
@@ -0,0 +1,37 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <clarisma/alloc/Arena.h>
+
+using namespace clarisma;
+
+TEST_CASE("Arena::reset")
+{
+	Arena arena(1024);
+	REQUIRE(arena.capacity() == 0);
+	for (int i = 0; i < 100; i++) arena.alloc(100, 8);
+	uint64_t grown = arena.capacity();
+	REQUIRE(grown >= 10'000);
+	REQUIRE(arena.used() >= 10'000);
+	REQUIRE(arena.used() <= grown);
+
+	// Only the most recent (largest) chunk is kept
+	arena.reset();
+	uint64_t kept = arena.capacity();
+	REQUIRE(kept > 0);
+	REQUIRE(kept < grown);
+	REQUIRE(arena.used() == 0);
+
+	// Allocations that fit in the kept chunk don't grow the arena
+	uint8_t* first = arena.alloc(64, 8);
+	REQUIRE(arena.used() == 64);
+	for (uint64_t i = 1; i < kept / 64; i++) arena.alloc(64, 8);
+	REQUIRE(arena.capacity() == kept);
+	arena.reset();
+	REQUIRE(arena.alloc(64, 8) == first);
+
+	// A chunk larger than the limit is released
+	arena.reset(kept - 1);
+	REQUIRE(arena.capacity() == 0);
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <unordered_set>
+#include <clarisma/data/OpenHashSet.h>
+
+using namespace clarisma;
+
+TEST_CASE("OpenHashSet")
+{
+	OpenHashSet<uint64_t> set(4);
+	REQUIRE(set.isEmpty());
+	REQUIRE(set.capacity() == 16);
+
+	REQUIRE(set.insert(0));
+	REQUIRE(!set.insert(0));
+	REQUIRE(set.contains(0));
+	REQUIRE(set.insert(42));
+	REQUIRE(!set.insert(42));
+	REQUIRE(set.size() == 2);
+	REQUIRE(set.erase(0));
+	REQUIRE(!set.erase(0));
+	REQUIRE(set.erase(42));
+	REQUIRE(!set.contains(42));
+	REQUIRE(set.isEmpty());
+}
+
+TEST_CASE("OpenHashSet matches std::unordered_set")
+{
+	OpenHashSet<uint64_t> set;
+	std::unordered_set<uint64_t> expected;
+
+	// Keys resemble feature ID bits (ID shifted left, with type bits)
+	uint64_t seed = 12345;
+	for (int i = 0; i < 50000; i++)
+	{
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		uint64_t key = ((seed >> 40) % 5000) << 8 | ((seed >> 20) & 0x18);
+		if (seed & (1ULL << 63))
+		{
+			REQUIRE(set.insert(key) == expected.insert(key).second);
+		}
+		else
+		{
+			REQUIRE(set.erase(key) == (expected.erase(key) != 0));
+		}
+	}
+	REQUIRE(set.size() == expected.size());
+	for (uint64_t key : expected)
+	{
+		REQUIRE(set.contains(key));
+	}
+	set.clear();
+	REQUIRE(set.isEmpty());
+}
@@ -0,0 +1,33 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <memory>
+#include <clarisma/io/MappedFile.h>
+
+using namespace clarisma;
+
+TEST_CASE("MappedFile::residentBytes")
+{
+	constexpr size_t SIZE = 64 * 1024;
+	std::unique_ptr<uint8_t[]> buf(new uint8_t[SIZE]);
+	memset(buf.get(), 1, SIZE);		// touch every page
+	uint64_t resident = MappedFile::residentBytes(buf.get(), SIZE);
+	REQUIRE(resident >= SIZE);
+	REQUIRE(resident <= SIZE + 2 * 64 * 1024);	// at most one extra page at each end
+	REQUIRE(MappedFile::residentBytes(buf.get() + 100, 1) > 0);
+}
+
+TEST_CASE("MappedFile::advise")
+{
+	constexpr size_t SIZE = 256 * 1024;
+	std::unique_ptr<uint8_t[]> buf(new uint8_t[SIZE]);
+	memset(buf.get(), 1, SIZE);
+	// Hints are optional, but resetting to NORMAL must always work
+	// (and ranges need not be page-aligned)
+	REQUIRE(MappedFile::advise(buf.get() + 100, SIZE - 100, MappedFile::Advice::NORMAL));
+	MappedFile::advise(buf.get(), SIZE, MappedFile::Advice::RANDOM);
+	MappedFile::advise(buf.get(), SIZE, MappedFile::Advice::HUGE_PAGES);
+	REQUIRE(buf[SIZE - 1] == 1);
+}
@@ -0,0 +1,35 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <filesystem>
+#include <catch2/catch_test_macros.hpp>
+#include <clarisma/store/IndexFile.h>
+
+using namespace clarisma;
+
+TEST_CASE("IndexFile::tryGet")
+{
+	std::string fileName = (std::filesystem::temp_directory_path() /
+		"geodesk-indexfile-test.idx").string();
+	{
+		IndexFile index;
+		index.bits(24);
+		index.open(fileName.c_str(), File::OpenMode::READ | File::OpenMode::WRITE |
+			File::OpenMode::CREATE | File::OpenMode::REPLACE_EXISTING);
+		index.put(1, 0xabcdef);
+		index.put(1'000'000, 42);
+		REQUIRE(index.get(1) == 0xabcdef);
+		index.close();
+	}
+	{
+		IndexFile index;
+		index.bits(24);
+		index.open(fileName.c_str(), File::OpenMode::READ);
+		REQUIRE(index.tryGet(1) == 0xabcdef);
+		REQUIRE(index.tryGet(2) == 0);
+		REQUIRE(index.tryGet(1'000'000) == 42);
+		REQUIRE(index.tryGet(1'000'000'000'000ULL) == 0);
+			// beyond the end of the file
+	}
+	std::filesystem::remove(fileName);
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <regex>
+#include <string>
+#include <clarisma/text/Regex.h>
+
+using namespace clarisma;
+
+static const char* PATTERNS[] =
+{
+	"", "abc", "^abc$", "a.c", "a*", "a+b", "(ab)*c", "(?:ab|cd)+",
+	"a?b?c?", "[a-c]+x", "[^abc]*", "[]a]", "\\d{2,3}", "x{2}", "x{1,}",
+	"\\w+\\s\\w+", "(a|b)*abb", "St\\..*", ".*strasse", ".*[Ss]chool.*",
+	"(a|ab)(c|bcd)(d*)", "a{0,3}b", "[\\d\\-]+", "^(a|^b)c", "a$|b",
+	"(a*)*b", "(x+x+)+y", ".*(Park|Garden)$", "a{2,}?b",
+};
+
+static const char* STRINGS[] =
+{
+	"", "a", "abc", "abcd", "aaaa", "aab", "ababc", "abcdab", "x",
+	"xx", "xxx", "12", "123", "1234", "12-34", "hello world", "St. Peter",
+	"Hauptstrasse", "High School", "school", "abb", "babb", "abcd",
+	"bc", "ac", "b", "aaab", "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx",
+	"Central Park", "Park Lane", "M\xc3\xbcnchen", "aab", "]", "zzz",
+};
+
+TEST_CASE("Regex matches like std::regex")
+{
+	for (const char* pattern : PATTERNS)
+	{
+		Regex regex(pattern);
+		std::regex expected(pattern);
+		for (const char* s : STRINGS)
+		{
+			INFO("Pattern: " << pattern << "  String: " << s);
+			REQUIRE(regex.match(s) == std::regex_match(s, expected));
+		}
+	}
+}
+
+TEST_CASE("Regex literals")
+{
+	Regex literal("Main Street");
+	REQUIRE(literal.isLiteral());
+	REQUIRE(literal.match("Main Street"));
+	REQUIRE(!literal.match("Main Streets"));
+
+	Regex prefix("^Saint .*");
+	REQUIRE(!prefix.isLiteral());
+	REQUIRE(prefix.literalPrefix() == "Saint ");
+	REQUIRE(prefix.literalSuffix().empty());
+
+	Regex required(".*[Ss]tation (North|South).*");
+	REQUIRE(required.requiredLiteral() == "tation ");
+	REQUIRE(required.match("Main Station South Exit"));
+	REQUIRE(!required.match("Main Station East"));
+
+	// Unlike std::regex, code-point escapes match UTF-8 text
+	Regex utf8("M\\u00fcnchen|K\\xf6ln");
+	REQUIRE(utf8.match("M\xc3\xbcnchen"));
+	REQUIRE(utf8.match("K\xc3\xb6ln"));
+}
+
+TEST_CASE("Regex runs in linear time")
+{
+	// Would take forever with a backtracking engine
+	Regex regex("(x+x+)+y");
+	std::string s(10000, 'x');
+	REQUIRE(!regex.match(s));
+	REQUIRE(regex.match(s + "y"));
+
+	// Too many states for a DFA, falls back to NFA simulation
+	Regex large("(a|b)*a(a|b){12}");
+	REQUIRE(!large.hasDfa());
+	REQUIRE(large.match("bbbabbbbbbbbbbbb"));
+	REQUIRE(!large.match("bbbbbbbbbbbbbbbb"));
+}
+
+TEST_CASE("Regex NFAs of different sizes can be used alternately")
+{
+	// Both simulations share the working memory of the thread
+	const char* patterns[] = { "(a|b)*a(a|b){12}", "(a|b)*b(a|b){11}(a|b|c)+" };
+	Regex first(patterns[0]);
+	Regex second(patterns[1]);
+	REQUIRE(!first.hasDfa());
+	REQUIRE(!second.hasDfa());
+	std::regex expectedFirst(patterns[0]);
+	std::regex expectedSecond(patterns[1]);
+	uint32_t seed = 1;
+	for (int i = 0; i < 200; i++)
+	{
+		std::string s;
+		int len = 10 + i % 12;
+		for (int j = 0; j < len; j++)
+		{
+			seed = seed * 1103515245 + 12345;
+			s += "abc"[(seed >> 16) % 3 == 2 && j == len - 1 ? 2 : (seed >> 16) % 2];
+		}
+		INFO("String: " << s);
+		REQUIRE(first.match(s) == std::regex_match(s, expectedFirst));
+		REQUIRE(second.match(s) == std::regex_match(s, expectedSecond));
+	}
+}
+
+TEST_CASE("Regex rejects unsupported syntax")
+{
+	REQUIRE_THROWS_AS(Regex("(a)\\1"), RegexException);
+	REQUIRE_THROWS_AS(Regex("(?=a)"), RegexException);
+	REQUIRE_THROWS_AS(Regex("\\bword"), RegexException);
+	REQUIRE_THROWS_AS(Regex("(abc"), RegexException);
+	REQUIRE_THROWS_AS(Regex("abc)"), RegexException);
+	REQUIRE_THROWS_AS(Regex("*a"), RegexException);
+	REQUIRE_THROWS_AS(Regex("[abc"), RegexException);
+	REQUIRE_THROWS_AS(Regex("a{3,2}"), RegexException);
+}
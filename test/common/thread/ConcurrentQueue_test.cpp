@@ -0,0 +1,124 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <clarisma/thread/ConcurrentQueue.h>
+#include <clarisma/thread/ThreadPool.h>
+
+using namespace clarisma;
+
+TEST_CASE("ConcurrentQueue")
+{
+	ConcurrentQueue<int> queue(5);
+	REQUIRE(queue.capacity() == 8);
+	REQUIRE(queue.isEmpty());
+
+	int item;
+	REQUIRE(!queue.tryPop(item));
+	for (int i = 0; i < 8; i++)
+	{
+		REQUIRE(queue.tryPush(i));
+	}
+	REQUIRE(!queue.tryPush(8));
+	REQUIRE(queue.count() == 8);
+	for (int i = 0; i < 8; i++)
+	{
+		REQUIRE(queue.tryPop(item));
+		REQUIRE(item == i);
+	}
+	REQUIRE(!queue.tryPop(item));
+}
+
+TEST_CASE("ConcurrentQueue with multiple producers and consumers")
+{
+	constexpr int THREADS = 4;
+	constexpr int ITEMS_PER_THREAD = 20000;
+	ConcurrentQueue<int> queue(64);
+	std::atomic<int64_t> sum = 0;
+	std::atomic<int> consumed = 0;
+	std::vector<std::thread> threads;
+
+	for (int t = 0; t < THREADS; t++)
+	{
+		threads.emplace_back([&queue, t]
+		{
+			for (int i = 1; i <= ITEMS_PER_THREAD; i++)
+			{
+				while (!queue.tryPush(t * ITEMS_PER_THREAD + i)) std::this_thread::yield();
+			}
+		});
+		threads.emplace_back([&queue, &sum, &consumed]
+		{
+			int item;
+			while (consumed.load() < THREADS * ITEMS_PER_THREAD)
+			{
+				if (queue.tryPop(item))
+				{
+					sum += item;
+					consumed++;
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+	for (auto& th : threads) th.join();
+
+	int64_t n = THREADS * ITEMS_PER_THREAD;
+	REQUIRE(consumed.load() == n);
+	REQUIRE(sum.load() == n * (n + 1) / 2);
+}
+
+struct CountingTask
+{
+	std::atomic<int>* counter = nullptr;
+	void operator()() { counter->fetch_add(1); }
+};
+
+TEST_CASE("ThreadPool runs all posted tasks")
+{
+	std::atomic<int> counter = 0;
+	{
+		ThreadPool<CountingTask> pool(3, 0);
+		for (int i = 0; i < 10000; i++)
+		{
+			pool.post(CountingTask{ &counter });
+		}
+		while (counter.load() < 10000) std::this_thread::yield();
+	}
+	REQUIRE(counter.load() == 10000);
+}
+
+struct SlowTask
+{
+	std::atomic<int>* counter = nullptr;
+	void operator()()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		counter->fetch_add(1);
+	}
+};
+
+TEST_CASE("ThreadPool producers park while the queue is full")
+{
+	// With a queue of 2 and tasks that take a while, the producer
+	// outlasts its spin budget and must be woken by the worker
+	std::atomic<int> counter = 0;
+	{
+		ThreadPool<SlowTask> pool(1, 2);
+		for (int i = 0; i < 50; i++)
+		{
+			pool.post(SlowTask{ &counter });
+		}
+		pool.awaitCompletion();
+		REQUIRE(counter.load() >= 49);
+		while (counter.load() < 50) std::this_thread::yield();
+	}
+	REQUIRE(counter.load() == 50);
+}
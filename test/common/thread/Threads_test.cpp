@@ -0,0 +1,45 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include <clarisma/thread/Threads.h>
+
+using namespace clarisma;
+
+TEST_CASE("parallelFor visits each index exactly once")
+{
+	constexpr size_t COUNT = 10'007;
+	for (int threads : { 1, 2, 4, 0 })
+	{
+		std::vector<std::atomic<int>> visits(COUNT);
+		Threads::parallelFor(COUNT, threads, [&visits](size_t i)
+		{
+			visits[i].fetch_add(1, std::memory_order_relaxed);
+		}, 16);
+		for (size_t i = 0; i < COUNT; i++)
+		{
+			REQUIRE(visits[i].load() == 1);
+		}
+	}
+}
+
+TEST_CASE("parallelFor rethrows the first exception")
+{
+	std::atomic<size_t> calls = 0;
+	REQUIRE_THROWS_AS(Threads::parallelFor(1000, 4, [&calls](size_t i)
+	{
+		calls++;
+		if (i == 500) throw std::runtime_error("failed");
+	}, 8), std::runtime_error);
+	REQUIRE(calls.load() <= 1000);
+}
+
+TEST_CASE("parallelFor handles an empty range")
+{
+	bool called = false;
+	Threads::parallelFor(0, 4, [&called](size_t) { called = true; });
+	REQUIRE_FALSE(called);
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <clarisma/thread/WorkStealingPool.h>
+
+using namespace clarisma;
+
+namespace {
+
+struct AddTask
+{
+	std::atomic<int64_t>* sum = nullptr;
+	int value = 0;
+	void operator()() { sum->fetch_add(value); }
+};
+
+struct SlowTask
+{
+	std::atomic<int>* counter = nullptr;
+	void operator()()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		counter->fetch_add(1);
+	}
+};
+
+} // namespace
+
+TEST_CASE("WorkStealingPool runs tasks posted from multiple threads")
+{
+	constexpr int SUBMITTERS = 3;
+	constexpr int TASKS_PER_SUBMITTER = 5000;
+	std::atomic<int64_t> sum = 0;
+	{
+		WorkStealingPool<AddTask> pool(4, 4);
+		REQUIRE(pool.workerCount() == 4);
+		REQUIRE(pool.capacity() == 16);
+
+		std::vector<std::thread> submitters;
+		for (int t = 0; t < SUBMITTERS; t++)
+		{
+			submitters.emplace_back([&pool, &sum, t]
+			{
+				for (int i = 1; i <= TASKS_PER_SUBMITTER; i++)
+				{
+					pool.post(AddTask{ &sum, 1 }, (i + t) % 2);
+				}
+			});
+		}
+		for (auto& th : submitters) th.join();
+		while (sum.load() < SUBMITTERS * TASKS_PER_SUBMITTER)
+		{
+			std::this_thread::yield();
+		}
+	}
+	REQUIRE(sum.load() == SUBMITTERS * TASKS_PER_SUBMITTER);
+}
+
+TEST_CASE("WorkStealingPool fair share")
+{
+	WorkStealingPool<AddTask> pool(2, 8);
+	REQUIRE(pool.fairShare() == 16);
+	pool.addClient();
+	pool.addClient();
+	REQUIRE(pool.fairShare() == 8);
+	for (int i = 0; i < 20; i++) pool.addClient();
+	REQUIRE(pool.fairShare() == 2);
+}
+
+TEST_CASE("WorkStealingPool producers park while all queues are full")
+{
+	// With queues of 2 and tasks that take a while, the producer
+	// outlasts its spin budget and must be woken by a worker
+	std::atomic<int> counter = 0;
+	{
+		WorkStealingPool<SlowTask> pool(2, 2);
+		for (int i = 0; i < 50; i++)
+		{
+			pool.post(SlowTask{ &counter });
+		}
+		while (counter.load() < 50) std::this_thread::yield();
+	}
+	REQUIRE(counter.load() == 50);
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <string>
+#include <vector>
+#include <clarisma/util/Lz4.h>
+
+using namespace clarisma;
+
+static std::vector<uint8_t> roundTrip(const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> compressed(Lz4::maxCompressedSize(data.size()));
+	size_t compressedSize = Lz4::compress(data.data(), data.size(), compressed.data());
+	REQUIRE(compressedSize <= compressed.size());
+	std::vector<uint8_t> result(data.size());
+	Lz4::decompress(compressed.data(), compressedSize, result.data(), result.size());
+	return result;
+}
+
+TEST_CASE("Lz4 round trip")
+{
+	std::mt19937 random(42);
+	std::vector<uint8_t> data;
+	REQUIRE(roundTrip(data) == data);
+
+	for (size_t size : { 1, 5, 12, 13, 100, 4096, 300000 })
+	{
+		// Random bytes (incompressible)
+		data.resize(size);
+		for (auto& b : data) b = static_cast<uint8_t>(random());
+		REQUIRE(roundTrip(data) == data);
+
+		// Repetitive bytes (long matches, overlapping copies)
+		for (size_t i = 0; i < size; i++) data[i] = static_cast<uint8_t>((i % 7) * (i % 3 == 0));
+		REQUIRE(roundTrip(data) == data);
+	}
+
+	std::string text;
+	for (int i = 0; i < 2000; i++) text += "highway=residential name=Main Street ";
+	data.assign(text.begin(), text.end());
+	std::vector<uint8_t> compressed(Lz4::maxCompressedSize(data.size()));
+	REQUIRE(Lz4::compress(data.data(), data.size(), compressed.data()) < data.size() / 10);
+	REQUIRE(roundTrip(data) == data);
+}
+
+TEST_CASE("Lz4 rejects malformed blocks")
+{
+	std::vector<uint8_t> data(1000, 'x');
+	std::vector<uint8_t> compressed(Lz4::maxCompressedSize(data.size()));
+	size_t compressedSize = Lz4::compress(data.data(), data.size(), compressed.data());
+	std::vector<uint8_t> result(data.size());
+
+	REQUIRE_THROWS_AS(Lz4::decompress(compressed.data(), compressedSize - 1,
+		result.data(), result.size()), Lz4Exception);
+	REQUIRE_THROWS_AS(Lz4::decompress(compressed.data(), compressedSize,
+		result.data(), result.size() - 1), Lz4Exception);
+	uint8_t badDistance[] = { 0x10, 'a', 0x05, 0x00, 0x00 };
+	REQUIRE_THROWS_AS(Lz4::decompress(badDistance, sizeof(badDistance),
+		result.data(), 5), Lz4Exception);
+}
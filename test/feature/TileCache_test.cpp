@@ -0,0 +1,82 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <vector>
+#include <clarisma/util/Lz4.h>
+#include <geodesk/feature/TileCache.h>
+
+using namespace clarisma;
+using namespace geodesk;
+
+// Creates a compressed tile blob whose payload consists of `size`
+// copies of `fill`
+static std::vector<uint8_t> compressedTile(uint32_t size, uint8_t fill)
+{
+	std::vector<uint8_t> payload(size, fill);
+	std::vector<uint8_t> blob(8 + Lz4::maxCompressedSize(size));
+	size_t compressedSize = Lz4::compress(payload.data(), size, blob.data() + 8);
+	uint32_t header = static_cast<uint32_t>(compressedSize + 4) | TileCache::COMPRESSED_FLAG;
+	memcpy(blob.data(), &header, 4);
+	memcpy(blob.data() + 4, &size, 4);
+	blob.resize(8 + compressedSize);
+	return blob;
+}
+
+TEST_CASE("TileCache")
+{
+	TileCache cache;
+	std::vector<uint8_t> blob = compressedTile(1000, 7);
+	DataPtr pBlob(blob.data());
+	REQUIRE(TileCache::isCompressed(pBlob));
+
+	TilePin pin;
+	DataPtr pTile = cache.fetch(Tip(1), pBlob, pin);
+	REQUIRE(!pin.isEmpty());
+	REQUIRE(pTile.getUnsignedInt() == 1000);
+	REQUIRE((pTile + 4).getByte() == 7);
+	REQUIRE((pTile + 1003).getByte() == 7);
+
+	TilePin pin2;
+	REQUIRE(cache.fetch(Tip(1), pBlob, pin2).ptr() == pTile.ptr());
+	TileCache::Stats stats = cache.stats();
+	REQUIRE(stats.hits == 1);
+	REQUIRE(stats.misses == 1);
+	REQUIRE(stats.tileCount == 1);
+	REQUIRE(stats.bytes == 1004);
+
+	// Pinned tiles are never evicted
+	cache.clear();
+	REQUIRE(cache.stats().tileCount == 1);
+	pin.reset();
+	pin2.reset();
+	cache.clear();
+	REQUIRE(cache.stats().tileCount == 0);
+	REQUIRE(cache.stats().evictions == 1);
+}
+
+TEST_CASE("TileCache budget")
+{
+	TileCache cache;
+	std::vector<uint8_t> blob = compressedTile(100'000, 1);
+	cache.setBudget(TileCache::SHARD_COUNT * 250'000);
+		// room for 2 tiles per shard
+	for (uint32_t tip = 1; tip <= 200; tip++)
+	{
+		TilePin pin;
+		cache.fetch(Tip(tip), DataPtr(blob.data()), pin);
+	}
+	TileCache::Stats stats = cache.stats();
+	REQUIRE(stats.misses == 200);
+	REQUIRE(stats.bytes <= stats.budget);
+	REQUIRE(stats.evictions == 200 - stats.tileCount);
+
+	cache.setBudget(TileCache::UNLIMITED);
+	for (uint32_t tip = 1; tip <= 200; tip++)
+	{
+		TilePin pin;
+		cache.fetch(Tip(tip), DataPtr(blob.data()), pin);
+	}
+	REQUIRE(cache.stats().tileCount == 200);
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <vector>
+#include <clarisma/util/varint.h>
+#include <geodesk/feature/WayCoordinateIterator.h>
+
+using namespace clarisma;
+using namespace geodesk;
+
+// Encodes a way body with `count` coordinates, relative to (0,0), whose
+// deltas have a mix of varint lengths (including the 5-byte maximum).
+// The returned buffer holds nothing but the encoded body, so any
+// read beyond it is caught by sanitizers.
+static std::vector<uint8_t> encodeWay(int count, std::vector<Coordinate>& coords)
+{
+	std::mt19937 random(count);
+	std::vector<uint8_t> buf(16 + count * 10);
+	uint8_t* p = buf.data();
+	writeVarint(p, count);
+	int32_t x = 0;
+	int32_t y = 0;
+	for (int i = 0; i < count; i++)
+	{
+		int shift = static_cast<int>(random() % 31);
+		// Alternating signs keep x from overflowing
+		int32_t dx = static_cast<int32_t>(random() >> (shift + 2)) * ((i & 1) ? -1 : 1);
+		int32_t dy = static_cast<int32_t>(random() % 200) - 100;
+		x += dx;
+		y += dy;
+		coords.emplace_back(x, y);
+		writeSignedVarint(p, dx);
+		writeSignedVarint(p, dy);
+	}
+	return std::vector<uint8_t>(buf.data(), p);
+}
+
+TEST_CASE("WayCoordinateIterator::nextBlock")
+{
+	for (int count : { 2, 3, 5, 6, 7, 64, 65, 200 })
+	{
+		for (bool area : { false, true })
+		{
+			std::vector<Coordinate> expected;
+			std::vector<uint8_t> body = encodeWay(count, expected);
+			if (area) expected.push_back(expected[0]);
+
+			for (int blockSize : { 1, 2, 7, 64, 1000 })
+			{
+				WayCoordinateIterator iter;
+				iter.start(body.data(), 0, 0, area);
+				REQUIRE(static_cast<size_t>(iter.coordinatesRemaining()) == expected.size());
+				std::vector<Coordinate> actual;
+				std::vector<Coordinate> block(blockSize);
+				for (;;)
+				{
+					int n = iter.nextBlock(block.data(), blockSize);
+					actual.insert(actual.end(), block.begin(), block.begin() + n);
+					if (n < blockSize) break;
+				}
+				REQUIRE(actual == expected);
+			}
+
+			// Mixing next() and nextBlock()
+			WayCoordinateIterator iter;
+			iter.start(body.data(), 0, 0, area);
+			std::vector<Coordinate> actual;
+			actual.push_back(iter.next());
+			Coordinate block[5];
+			for (;;)
+			{
+				int n = iter.nextBlock(block, 5);
+				actual.insert(actual.end(), block, block + n);
+				if (n < 5) break;
+				actual.push_back(iter.next());
+				if (actual.back().isNull())
+				{
+					actual.pop_back();
+					break;
+				}
+			}
+			REQUIRE(actual == expected);
+		}
+	}
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <geodesk/filter/PointDistanceFilter.h>
+
+using namespace geodesk;
+
+static Tile tileAt(Coordinate c, int zoom)
+{
+	return Tile::fromColumnRowZoom(Tile::columnFromXZ(c.x, zoom),
+		Tile::rowFromYZ(c.y, zoom), zoom);
+}
+
+TEST_CASE("PointDistanceFilter::acceptTile")
+{
+	// 50 km around a point in central Germany
+	Coordinate center = Coordinate::ofLonLat(10.5, 51.0);
+	PointDistanceFilter filter(50'000, center);
+	REQUIRE(filter.flags() & FilterFlags::FAST_TILE_FILTER);
+
+	// A zoom-12 tile is about 6 km across at this latitude
+	Tile centerTile = tileAt(center, 12);
+	REQUIRE(filter.acceptTile(centerTile) == 1);
+	REQUIRE(filter.acceptTile(centerTile.neighbor(3, -2)) == 1);
+
+	// The tile that contains the radius' easternmost point
+	Coordinate east(filter.bounds().maxX() - 10, center.y);
+	REQUIRE(filter.acceptTile(tileAt(east, 12)) == 0);
+
+	// The tile at the bbox's northeast corner is outside the circle
+	Coordinate ne(filter.bounds().maxX(), filter.bounds().maxY());
+	REQUIRE(filter.acceptTile(tileAt(ne, 12)) == -1);
+
+	// A zoom-4 tile contains the entire circle, so it is partial
+	REQUIRE(filter.acceptTile(tileAt(center, 4)) == 0);
+}
+
+TEST_CASE("PointDistanceFilter::acceptBranch")
+{
+	Coordinate center = Coordinate::ofLonLat(10.5, 51.0);
+	PointDistanceFilter filter(50'000, center);
+	REQUIRE(filter.flags() & FilterFlags::FAST_BRANCH_FILTER);
+
+	// A small box around the center lies entirely within the radius
+	Box inner(center.x - 1000, center.y - 1000, center.x + 1000, center.y + 1000);
+	REQUIRE(filter.acceptBranch(inner) == 1);
+
+	// A box that straddles the circle
+	REQUIRE(filter.acceptBranch(filter.bounds()) == 0);
+
+	// A box beyond the bbox's northeast corner
+	const Box& b = filter.bounds();
+	Box outer(b.maxX() - 1000, b.maxY() - 1000, b.maxX(), b.maxY());
+	REQUIRE(filter.acceptBranch(outer) == -1);
+}
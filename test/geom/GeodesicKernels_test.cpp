@@ -0,0 +1,138 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <geodesk/geom/Distance.h>
+#include <geodesk/geom/GeodesicKernels.h>
+
+using namespace geodesk;
+
+// A random walk of `count` coordinates starting at the given point,
+// with steps of up to `maxStep` units
+static std::vector<Coordinate> randomWalk(Coordinate start, int count, int maxStep)
+{
+	std::mt19937 random(count);
+	std::uniform_int_distribution<int32_t> step(-maxStep, maxStep);
+	std::vector<Coordinate> coords;
+	Coordinate c = start;
+	for (int i = 0; i < count; i++)
+	{
+		coords.push_back(c);
+		c = Coordinate(c.x + step(random), c.y + step(random));
+	}
+	return coords;
+}
+
+static bool isClose(double a, double b, double relativeTolerance)
+{
+	return std::abs(a - b) <= relativeTolerance * std::max(std::abs(a), std::abs(b));
+}
+
+TEST_CASE("LocalMercatorScale")
+{
+	for (double lat : { 0.0, 30.0, 60.0, 80.0, -45.0 })
+	{
+		double center = Mercator::yFromLat(lat);
+		LocalMercatorScale scale(center);
+		for (double d : { 0.0, 1000.0, -250'000.0, LocalMercatorScale::MAX_HALF_SPAN,
+			-LocalMercatorScale::MAX_HALF_SPAN })
+		{
+			REQUIRE(isClose(scale.metersPerUnitAtY(center + d),
+				Mercator::metersPerUnitAtY(center + d), 1e-9));
+		}
+	}
+}
+
+TEST_CASE("GeodesicKernels")
+{
+	Coordinate start = Coordinate::ofLonLat(10.5, 51.0);
+	for (int count : { 2, 3, 4, 5, 64, 65 })
+	{
+		std::vector<Coordinate> coords = randomWalk(start, count, 20'000);
+
+		double exact = GeodesicKernels::length(coords.data(), count);
+		double expected = 0;
+		for (int i = 1; i < count; i++)
+		{
+			expected += Distance::metersBetween(coords[i - 1], coords[i]);
+		}
+		REQUIRE(exact == expected);
+		REQUIRE(isClose(GeodesicKernels::length(coords.data(), count, false), exact, 1e-9));
+
+		// Close the walk to form a ring
+		coords.push_back(coords[0]);
+		int ringCount = count + 1;
+		double x0 = coords[0].x;
+		double areaExact = GeodesicKernels::signedMercatorAreaSum(
+			coords.data(), ringCount, x0);
+		double areaFast = GeodesicKernels::signedMercatorAreaSum(
+			coords.data(), ringCount, x0, false);
+		REQUIRE(std::abs(areaFast - areaExact) <= 1e-9 * std::abs(areaExact) + 1e-3);
+
+		double areaSum = 0, areaX = 0, areaY = 0;
+		GeodesicKernels::addRingCentroid(coords.data(), ringCount,
+			areaSum, areaX, areaY, false);
+		double exactSum = 0, exactX = 0, exactY = 0;
+		GeodesicKernels::addRingCentroid(coords.data(), ringCount,
+			exactSum, exactX, exactY);
+		double expectedSum = 0, expectedX = 0, expectedY = 0;
+		for (int i = 1; i < ringCount; i++)
+		{
+			double x1 = coords[i - 1].x;
+			double y1 = coords[i - 1].y;
+			double x2 = coords[i].x;
+			double y2 = coords[i].y;
+			double a = x1 * y2 - x2 * y1;
+			expectedSum += a;
+			expectedX += (x1 + x2) * a;
+			expectedY += (y1 + y2) * a;
+		}
+		REQUIRE(exactSum == expectedSum);
+		REQUIRE(exactX == expectedX);
+		REQUIRE(exactY == expectedY);
+		if (count > 2)
+		{
+			// (The terms of a degenerate ring cancel each other out)
+			REQUIRE(isClose(areaX / (3 * areaSum), expectedX / (3 * expectedSum), 1e-6));
+			REQUIRE(isClose(areaY / (3 * areaSum), expectedY / (3 * expectedSum), 1e-6));
+		}
+
+		double length = 0, lineX = 0, lineY = 0;
+		GeodesicKernels::addLineCentroid(coords.data(), count,
+			length, lineX, lineY, false);
+		double exactLength = 0, exactLineX = 0, exactLineY = 0;
+		GeodesicKernels::addLineCentroid(coords.data(), count,
+			exactLength, exactLineX, exactLineY);
+		double expectedLength = 0, expectedLineX = 0, expectedLineY = 0;
+		for (int i = 1; i < count; i++)
+		{
+			double x1 = coords[i - 1].x;
+			double y1 = coords[i - 1].y;
+			double x2 = coords[i].x;
+			double y2 = coords[i].y;
+			double d = std::sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2));
+			expectedLength += d;
+			expectedLineX += (x1 + x2) * d;
+			expectedLineY += (y1 + y2) * d;
+		}
+		REQUIRE(exactLength == expectedLength);
+		REQUIRE(exactLineX == expectedLineX);
+		REQUIRE(exactLineY == expectedLineY);
+		REQUIRE(isClose(length, expectedLength, 1e-12));
+		REQUIRE(isClose(lineX, expectedLineX, 1e-12));
+		REQUIRE(isClose(lineY, expectedLineY, 1e-12));
+
+		for (Coordinate pt : { start, Coordinate(start.x + 5000, start.y - 70'000) })
+		{
+			double minExact = GeodesicKernels::minPointSegmentSquared(
+				coords.data(), count, pt);
+			double minFast = GeodesicKernels::minPointSegmentSquared(
+				coords.data(), count, pt, false);
+			REQUIRE(std::abs(minFast - minExact) <= 1e-9 * minExact + 1e-6);
+		}
+		REQUIRE(GeodesicKernels::minPointSegmentSquared(coords.data(), count, coords[1]) == 0);
+	}
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <geodesk/geom/index/MCIndexBuilder.h>
+#include <geodesk/geom/index/MCIndexCache.h>
+
+using namespace geodesk;
+
+static MCIndex squareIndex(const Box& box, size_t* pSize)
+{
+	MCIndexBuilder builder;
+	builder.addLineSegment(box.topLeft(), box.topRight());
+	builder.addLineSegment(box.bottomRight(), box.topRight());
+	builder.addLineSegment(box.bottomLeft(), box.bottomRight());
+	builder.addLineSegment(box.bottomLeft(), box.topLeft());
+	*pSize = builder.indexSize();
+	return builder.build(box);
+}
+
+TEST_CASE("MCIndexCache")
+{
+	MCIndexCache cache;
+	Box box(0, 0, 100, 100);
+	size_t size;
+	REQUIRE(cache.get(1) == nullptr);
+
+	// Tiny indexes are not cached
+	MCIndexCache::Handle small = cache.put(1, squareIndex(box, &size), size);
+	REQUIRE(small->containsPoint(Coordinate(50, 50)));
+	REQUIRE(cache.get(1) == nullptr);
+
+	// (We pretend the indexes are larger than they are)
+	const size_t big = MCIndexCache::MIN_CACHED_SIZE;
+	MCIndexCache::Handle a = cache.put(1, squareIndex(box, &size), big);
+	REQUIRE(cache.get(1) == a);
+	MCIndexCache::Handle b = cache.put(1, squareIndex(box, &size), big);
+	REQUIRE(b == a);		// first one wins
+
+	cache.put(2, squareIndex(box, &size), big);
+	cache.put(3, squareIndex(box, &size), big);
+	cache.get(1);
+	cache.setBudget(big * 2);	// evicts 2, the least recently used
+	REQUIRE(cache.get(1) == a);
+	REQUIRE(cache.get(2) == nullptr);
+	REQUIRE(cache.get(3) != nullptr);
+
+	MCIndexCache::Stats stats = cache.stats();
+	REQUIRE(stats.count == 2);
+	REQUIRE(stats.bytes == big * 2);
+	REQUIRE(stats.evictions == 1);
+
+	cache.clear();
+	REQUIRE(cache.get(1) == nullptr);
+	REQUIRE(a->containsPoint(Coordinate(50, 50)));	// still owned by handle
+}
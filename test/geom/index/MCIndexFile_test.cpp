@@ -0,0 +1,91 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <clarisma/io/IOException.h>
+#include <geodesk/geom/index/MCIndexBuilder.h>
+#include <geodesk/geom/index/MCIndexFile.h>
+
+using namespace geodesk;
+
+// A closed ring with many vertexes, so the index has several levels
+static MCIndex starIndex(Coordinate center, int radius, int points)
+{
+	MCIndexBuilder builder;
+	Box bounds;
+	Coordinate prev;
+	for (int i = 0; i <= points; i++)
+	{
+			int r = (i % 2) ? radius / 2 : radius;
+			double angle = 2 * 3.14159265358979 * (i % points) / points;
+			Coordinate c(center.x + static_cast<int32_t>(r * cos(angle)),
+				center.y + static_cast<int32_t>(r * sin(angle)));
+			if (i > 0) builder.addLineSegment(prev, c);
+			bounds.expandToInclude(c);
+			prev = c;
+	}
+	return builder.build(bounds);
+}
+
+TEST_CASE("MCIndexFile")
+{
+	std::string path = (std::filesystem::temp_directory_path() /
+		"geodesk-mcindexfile-test.mci").string();
+	MCIndex a = starIndex(Coordinate(0, 0), 1000, 200);
+	MCIndex b = starIndex(Coordinate(5000, 5000), 300, 20);
+	GolIdentity identity{ 1234, 56, 0x89AB'CDEF };
+	{
+		MCIndexFile::Writer writer(path, identity);
+		writer.add(42, b);
+		writer.add(7, a);
+		writer.finish();
+	}
+
+	{
+		MCIndexFile file;
+		REQUIRE(file.open(path, identity));
+		REQUIRE(file.count() == 2);
+		REQUIRE(file.get(8) == nullptr);
+		MCIndexCache::Handle mappedA = file.get(7);
+		MCIndexCache::Handle mappedB = file.get(42);
+		REQUIRE(mappedA != nullptr);
+		REQUIRE(mappedB != nullptr);
+		for (int y = -1100; y <= 1100; y += 37)
+		{
+			for (int x = -1100; x <= 1100; x += 41)
+			{
+				Coordinate c(x, y);
+				REQUIRE(mappedA->locatePoint(c) == a.locatePoint(c));
+				Coordinate c2(x / 3 + 5000, y / 3 + 5000);
+				REQUIRE(mappedB->locatePoint(c2) == b.locatePoint(c2));
+			}
+		}
+		Box box(-100, -100, 100, 100);
+		REQUIRE(mappedA->locateBox(box) == a.locateBox(box));
+		REQUIRE(mappedA->locateBox(box) == 1);
+	}
+
+	// A file built for another GOL is not opened
+	GolIdentity other = identity;
+	other.tileIndexChecksum++;
+	{
+		MCIndexFile file;
+		REQUIRE_FALSE(file.open(path, other));
+		REQUIRE(file.count() == 0);
+	}
+
+	// An entry that points past the entry table is rejected
+	{
+		std::fstream out(path, std::ios::in | std::ios::out | std::ios::binary);
+		out.seekp(-8, std::ios::end);		// size of the last entry
+		uint64_t hugeSize = UINT64_MAX / 2;
+		out.write(reinterpret_cast<const char*>(&hugeSize), sizeof(hugeSize));
+	}
+	{
+		MCIndexFile file;
+		REQUIRE_THROWS_AS(file.open(path, identity), clarisma::IOException);
+	}
+	std::filesystem::remove(path);
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <geodesk/geom/index/MCIndexBuilder.h>
+
+using namespace geodesk;
+
+static MCIndex ringIndex(const std::vector<Coordinate>& ring)
+{
+	MCIndexBuilder builder;
+	Box bounds;
+	for (size_t i = 1; i < ring.size(); i++)
+	{
+		builder.addLineSegment(ring[i - 1], ring[i]);
+		bounds.expandToInclude(ring[i]);
+	}
+	return builder.build(bounds);
+}
+
+static std::vector<Coordinate> star(Coordinate center, int radius, int points)
+{
+	std::vector<Coordinate> ring;
+	for (int i = 0; i <= points; i++)
+	{
+		int r = (i % 2) ? radius / 2 : radius;
+		double angle = 2 * 3.14159265358979 * (i % points) / points;
+		ring.emplace_back(center.x + static_cast<int32_t>(r * cos(angle)),
+			center.y + static_cast<int32_t>(r * sin(angle)));
+	}
+	return ring;
+}
+
+static void requireSameLocations(const MCIndex& index, const std::vector<Coordinate>& points)
+{
+	std::vector<int8_t> results(points.size(), 99);
+	index.locatePoints(points.data(), points.size(), results.data());
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		REQUIRE(results[i] == index.locatePoint(points[i]));
+	}
+
+	// A reused buffer must not carry over points of earlier batches
+	MCIndex::LocateBuffer buffer;
+	std::vector<int8_t> batchResults(points.size(), 99);
+	for (size_t batchSize : { points.size(), points.size() / 2 + 1, size_t{3} })
+	{
+		batchSize = std::min(batchSize, points.size());
+		index.locatePoints(points.data(), batchSize, batchResults.data(), buffer);
+		for (size_t i = 0; i < batchSize; i++)
+		{
+			REQUIRE(batchResults[i] == results[i]);
+		}
+	}
+}
+
+TEST_CASE("MCIndex::locatePoints matches locatePoint")
+{
+	SECTION("Star with many chains")
+	{
+		MCIndex index = ringIndex(star(Coordinate(0, 0), 1000, 200));
+		std::vector<Coordinate> points;
+		for (int y = -1100; y <= 1100; y += 13)
+		{
+			for (int x = -1100; x <= 1100; x += 17)
+			{
+				points.emplace_back(x, y);
+			}
+		}
+		// The vertexes themselves lie on the boundary
+		for (Coordinate c : star(Coordinate(0, 0), 1000, 200)) points.push_back(c);
+		std::mt19937 random(42);
+		std::shuffle(points.begin(), points.end(), random);
+		requireSameLocations(index, points);
+	}
+
+	SECTION("Rectangle with horizontal and vertical edges")
+	{
+		MCIndex index = ringIndex({ {0,0}, {100,0}, {100,50}, {0,50}, {0,0} });
+		std::vector<Coordinate> points;
+		for (int y = -10; y <= 60; y += 5)
+		{
+			for (int x = -10; x <= 110; x += 5)
+			{
+				points.emplace_back(x, y);
+			}
+		}
+		requireSameLocations(index, points);
+	}
+
+	SECTION("Small batches")
+	{
+		MCIndex index = ringIndex(star(Coordinate(5000, 5000), 300, 20));
+		std::vector<Coordinate> points;
+		for (int i = 0; i < MCIndex::CLUSTER_SIZE + 1; i++)
+		{
+			points.emplace_back(4700 + i * 9, 5000 + (i % 7) * 40 - 120);
+		}
+		requireSameLocations(index, { points[0] });
+		requireSameLocations(index, std::vector<Coordinate>(
+			points.begin(), points.begin() + MCIndex::CLUSTER_SIZE));
+		requireSameLocations(index, points);
+		requireSameLocations(index, {});
+	}
+}
@@ -0,0 +1,21 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <geodesk/match/MatcherCompiler.h>
+
+using namespace geodesk;
+
+TEST_CASE("MatcherCompiler::normalizeQuery")
+{
+	REQUIRE(MatcherCompiler::normalizeQuery("na[amenity=pub]") == "na[amenity=pub]");
+	REQUIRE(MatcherCompiler::normalizeQuery("  na [amenity = pub]\t ") == "na [amenity = pub]");
+	REQUIRE(MatcherCompiler::normalizeQuery("n\n\n[a],\r\nw[b]") == "n [a], w[b]");
+	REQUIRE(MatcherCompiler::normalizeQuery("") == "");
+	REQUIRE(MatcherCompiler::normalizeQuery("   ") == "");
+
+	// Whitespace in quoted strings is kept as-is
+	REQUIRE(MatcherCompiler::normalizeQuery("n[name='Big  Ben']") == "n[name='Big  Ben']");
+	REQUIRE(MatcherCompiler::normalizeQuery("n[name=\"a  \\\"  b\"]  ") == "n[name=\"a  \\\"  b\"]");
+	REQUIRE(MatcherCompiler::normalizeQuery("n[name='it\\'s  ok']") == "n[name='it\\'s  ok']");
+}
@@ -0,0 +1,161 @@
+// Copyright (c) 2024 Clarisma / GeoDesk contributors
+// SPDX-License-Identifier: LGPL-3.0-only
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <vector>
+#include <geodesk/query/LeafScanner.h>
+
+using namespace geodesk;
+
+namespace {
+
+void putInt(std::vector<uint8_t>& buf, size_t pos, int32_t v)
+{
+	memcpy(&buf[pos], &v, sizeof(v));
+}
+
+// Builds a feature leaf with `count` entries of pseudo-random bboxes and flags
+std::vector<uint8_t> makeFeatureLeaf(int count, uint64_t seed)
+{
+	std::vector<uint8_t> leaf(count * 32);
+	for (int i = 0; i < count; i++)
+	{
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		int32_t minX = static_cast<int32_t>(seed >> 40) % 1000;
+		int32_t minY = static_cast<int32_t>(seed >> 20) % 1000;
+		int32_t flags = static_cast<int32_t>(seed >> 8) & 0xfe;
+		if (i == count - 1) flags |= 1;
+		putInt(leaf, i * 32, minX);
+		putInt(leaf, i * 32 + 4, minY);
+		putInt(leaf, i * 32 + 8, minX + 50);
+		putInt(leaf, i * 32 + 12, minY + 50);
+		putInt(leaf, i * 32 + 16, flags);
+	}
+	return leaf;
+}
+
+// Scans an entire leaf, and returns the indexes of all candidates
+std::vector<int> scanFeatures(const LeafScanner& scanner, const std::vector<uint8_t>& leaf)
+{
+	std::vector<int> results;
+	const uint8_t* p = leaf.data();
+	int base = 0;
+	while (p)
+	{
+		uint32_t candidates;
+		const uint8_t* next = scanner.scanFeatures(p, &candidates);
+		for (int i = 0; i < LeafScanner::BLOCK_SIZE; i++)
+		{
+			if (candidates & (1u << i)) results.push_back(base + i);
+		}
+		base += LeafScanner::BLOCK_SIZE;
+		p = next;
+	}
+	return results;
+}
+
+} // namespace
+
+TEST_CASE("LeafScanner kernels agree with scalar code")
+{
+	Box box(200, 300, 600, 700);
+	FeatureTypes types(FeatureTypes::WAYS);
+	constexpr uint32_t BOTH_TILES = FeatureFlags::MULTITILE_NORTH | FeatureFlags::MULTITILE_WEST;
+	for (uint32_t northwest : { 0u, static_cast<uint32_t>(FeatureFlags::MULTITILE_WEST), BOTH_TILES })
+	{
+		LeafScanner scalar(box, types, northwest, LeafScanner::Kernel::SCALAR);
+		REQUIRE(scalar.kernel() == LeafScanner::Kernel::SCALAR);
+
+		// (The SIMD kernels test 4 or 8 entries at a time)
+		for (int count : { 1, 2, 3, 4, 5, 7, 8, 9, 15, 31, 32, 33, 64, 100 })
+		{
+			std::vector<uint8_t> leaf = makeFeatureLeaf(count, count);
+			std::vector<int> expected;
+			for (int i = 0; i < count; i++)
+			{
+				int32_t e[5];
+				memcpy(e, &leaf[i * 32], sizeof(e));
+				bool hit = !(e[0] > box.maxX() || e[1] > box.maxY() ||
+					e[2] < box.minX() || e[3] < box.minY());
+				uint32_t multiTile = e[4] & BOTH_TILES;
+				bool skip = multiTile != BOTH_TILES && (multiTile & northwest) != 0;
+				if (hit && types.acceptFlags(e[4]) && !skip) expected.push_back(i);
+			}
+			REQUIRE(scanFeatures(scalar, leaf) == expected);
+
+			for (auto kernel : { LeafScanner::Kernel::SSE2, LeafScanner::Kernel::AVX2 })
+			{
+				if (!LeafScanner::isSupported(kernel)) continue;
+				LeafScanner simd(box, types, northwest, kernel);
+				REQUIRE(simd.kernel() == kernel);
+				REQUIRE(scanFeatures(simd, leaf) == expected);
+			}
+		}
+	}
+}
+
+TEST_CASE("LeafScanner node kernels")
+{
+	// Three nodes; the second is a relation member (24-byte entry)
+	std::vector<uint8_t> leaf(20 + 24 + 20);
+	int32_t nodeFlags = 0;		// type bits 0 (node)
+	putInt(leaf, 0, 10);  putInt(leaf, 4, 10);  putInt(leaf, 8, nodeFlags);
+	putInt(leaf, 20, 50); putInt(leaf, 24, 50); putInt(leaf, 28, nodeFlags | 4);
+	putInt(leaf, 44, 90); putInt(leaf, 48, 20); putInt(leaf, 52, nodeFlags | 1);
+
+	FeatureTypes types(FeatureTypes::NODES);
+	for (auto kernel : { LeafScanner::Kernel::SCALAR, LeafScanner::Kernel::SSE2 })
+	{
+		if (!LeafScanner::isSupported(kernel)) continue;
+		LeafScanner scanner(Box(40, 0, 100, 60), types, 0, kernel);
+		uint32_t candidates;
+		uint16_t offsets[LeafScanner::BLOCK_SIZE];
+		REQUIRE(scanner.scanNodes(leaf.data(), &candidates, offsets) == nullptr);
+		REQUIRE(candidates == 0b110);
+		REQUIRE(offsets[1] == 20);
+		REQUIRE(offsets[2] == 44);
+	}
+}
+
+TEST_CASE("LeafScanner node kernels agree with scalar code")
+{
+	// A leaf of pseudo-random nodes of all types, some of which
+	// are relation members (24-byte entries)
+	constexpr int COUNT = 100;
+	std::vector<uint8_t> leaf;
+	uint64_t seed = 7;
+	for (int i = 0; i < COUNT; i++)
+	{
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		int32_t flags = static_cast<int32_t>(seed >> 8) & 0x3e;
+		if (i == COUNT - 1) flags |= 1;
+		size_t pos = leaf.size();
+		leaf.resize(pos + 20 + (flags & 4));
+		putInt(leaf, pos, static_cast<int32_t>(seed >> 40) % 1000);
+		putInt(leaf, pos + 4, static_cast<int32_t>(seed >> 20) % 1000);
+		putInt(leaf, pos + 8, flags);
+	}
+
+	Box box(200, 300, 600, 700);
+	FeatureTypes types(FeatureTypes::NODES);
+	LeafScanner scalar(box, types, 0, LeafScanner::Kernel::SCALAR);
+	LeafScanner simd(box, types, 0, LeafScanner::bestKernel());
+	const uint8_t* p = leaf.data();
+	while (p)
+	{
+		uint32_t expected, candidates;
+		uint16_t expectedOffsets[LeafScanner::BLOCK_SIZE];
+		uint16_t offsets[LeafScanner::BLOCK_SIZE];
+		const uint8_t* next = scalar.scanNodes(p, &expected, expectedOffsets);
+		REQUIRE(simd.scanNodes(p, &candidates, offsets) == next);
+		REQUIRE(candidates == expected);
+		int count = next ? LeafScanner::BLOCK_SIZE :
+			static_cast<int>(COUNT % LeafScanner::BLOCK_SIZE);
+		for (int i = 0; i < count; i++)
+		{
+			REQUIRE(offsets[i] == expectedOffsets[i]);
+		}
+		p = next;
+	}
+}